@@ -74,13 +74,6 @@ typedef struct _zzjmp_buf {
 #define ZZLEXBUFSIZE	2000
 #endif
 
-#define zzOvfChk														\
-            if ( zzasp <= 0 )                                           \
-            {                                                           \
-                fprintf(stderr, zzStackOvfMsg, __FILE__, __LINE__);		\
-                exit(PCCTS_EXIT_FAILURE);                                               \
-            }
-
 #ifndef ZZA_STACKSIZE
 #define ZZA_STACKSIZE	400
 #endif
@@ -88,6 +81,28 @@ typedef struct _zzjmp_buf {
 #define ZZAST_STACKSIZE	400
 #endif
 
+/* btparse: the attribute and AST stacks aren't fixed-size arrays any more,
+ * so that entries with hundreds of fields don't overflow them.  Each is a
+ * series of chunks of ZZA_STACKSIZE (ZZAST_STACKSIZE) elements: the first
+ * chunk is static, and the rest are allocated by zzaGrow() (zzastGrow())
+ * when the stack gets that deep, and freed again by zzaFreeChunks()
+ * (zzastFreeChunks()).  Chunks never move, so pointers into the stacks
+ * (like zzaRetPtr) stay good.  The stack pointers still count down, from
+ * zzaTOP (zzastTOP), and zzaAt(i) (zzastAt(i)) is element i.  zzOvfChk
+ * makes sure that the element below the next one to be pushed exists.
+ */
+#ifndef ZZ_MAXCHUNKS
+#define ZZ_MAXCHUNKS	1024
+#endif
+#define zzaTOP			(ZZA_STACKSIZE * ZZ_MAXCHUNKS)
+#define zzaAt(i)		zzaElem(zzaTOP - 1 - (i))
+#define zzaElem(p)		(*((p) < ZZA_STACKSIZE ? &zzaStack[p] :		\
+						   &zzaChunks[(p) / ZZA_STACKSIZE][(p) % ZZA_STACKSIZE]))
+
+#define zzOvfChk														\
+            if ( (zzaTOP - zzasp + 1) % ZZA_STACKSIZE == 0 )            \
+                zzaGrow();
+
 #ifndef zzfailed_pred
 #define zzfailed_pred(_p)	\
 	fprintf(stderr, "semantic error; failed predicate: '%s'\n",_p)
@@ -100,7 +115,7 @@ typedef struct _zzjmp_buf {
 	int zzlap = 0, zzlabase=0; /* labase only used for DEMAND_LOOK */
 #else
 #define LOOKAHEAD												\
-	int zztoken;
+	zzTHREAD_LOCAL int zztoken;
 #endif
 
 #ifndef zzcr_ast
@@ -225,9 +240,10 @@ extern void _inf_zzgettok();
 	Attrib zzempty_attr(void) {static Attrib a; return a;}			\
 	Attrib zzconstr_attr(int _tok, char *_text)\
 		{Attrib a; zzcr_attr((&a),_tok,_text); return a;}		\
-	int zzasp=ZZA_STACKSIZE;									\
+	zzTHREAD_LOCAL int zzasp=zzaTOP;							\
 	char zzStackOvfMsg[]="fatal: attrib/AST stack overflow %s(%d)!\n"; \
-	Attrib zzaStack[ZZA_STACKSIZE]; DemandLookData				\
+	zzTHREAD_LOCAL Attrib zzaStack[ZZA_STACKSIZE];				\
+	zzTHREAD_LOCAL Attrib *zzaChunks[ZZ_MAXCHUNKS]; DemandLookData	\
 	InfLookData                                                 \
     zzGuessData
 #else
@@ -235,9 +251,10 @@ extern void _inf_zzgettok();
 	Attrib zzempty_attr() {static Attrib a; return a;}			\
 	Attrib zzconstr_attr(_tok, _text) int _tok; char *_text;\
 		{Attrib a; zzcr_attr((&a),_tok,_text); return a;}		\
-	int zzasp=ZZA_STACKSIZE;									\
+	zzTHREAD_LOCAL int zzasp=zzaTOP;							\
 	char zzStackOvfMsg[]="fatal: attrib/AST stack overflow %s(%d)!\n"; \
-	Attrib zzaStack[ZZA_STACKSIZE]; DemandLookData				\
+	zzTHREAD_LOCAL Attrib zzaStack[ZZA_STACKSIZE];				\
+	zzTHREAD_LOCAL Attrib *zzaChunks[ZZ_MAXCHUNKS]; DemandLookData	\
 	InfLookData                                                 \
     zzGuessData
 #endif
@@ -249,9 +266,10 @@ extern void _inf_zzgettok();
 	Attrib zzempty_attr(void) {static Attrib a; return a;}			\
 	Attrib zzconstr_attr(int _tok, char *_text)\
 		{Attrib a; zzcr_attr((&a),_tok,_text); return a;}		\
-	int zzasp=ZZA_STACKSIZE;									\
+	zzTHREAD_LOCAL int zzasp=zzaTOP;							\
 	char zzStackOvfMsg[]="fatal: attrib/AST stack overflow %s(%d)!\n"; \
-	Attrib zzaStack[ZZA_STACKSIZE]; DemandLookData				\
+	zzTHREAD_LOCAL Attrib zzaStack[ZZA_STACKSIZE];				\
+	zzTHREAD_LOCAL Attrib *zzaChunks[ZZ_MAXCHUNKS]; DemandLookData	\
 	InfLookData                                                 \
     zzGuessData
 #else
@@ -259,9 +277,10 @@ extern void _inf_zzgettok();
 	Attrib zzempty_attr() {static Attrib a; return a;}			\
 	Attrib zzconstr_attr(_tok, _text) int _tok; char *_text;\
 		{Attrib a; zzcr_attr((&a),_tok,_text); return a;}		\
-	int zzasp=ZZA_STACKSIZE;									\
+	zzTHREAD_LOCAL int zzasp=zzaTOP;							\
 	char zzStackOvfMsg[]="fatal: attrib/AST stack overflow %s(%d)!\n"; \
-	Attrib zzaStack[ZZA_STACKSIZE]; DemandLookData				\
+	zzTHREAD_LOCAL Attrib zzaStack[ZZA_STACKSIZE];				\
+	zzTHREAD_LOCAL Attrib *zzaChunks[ZZ_MAXCHUNKS]; DemandLookData	\
 	InfLookData                                                 \
     zzGuessData
 #endif
@@ -382,21 +401,21 @@ extern void _inf_zzgettok();
 
 					/* A r g u m e n t  A c c e s s */
 
-#define zzaCur			(zzaStack[zzasp])
+#define zzaCur			(zzaAt(zzasp))
 #define zzaRet			(*zzaRetPtr)
-#define zzaArg(v,n)		zzaStack[v-n]
-#define zzMakeAttr		{ zzNON_GUESS_MODE {zzOvfChk; --zzasp; zzcr_attr(&(zzaStack[zzasp]),LA(1),LATEXT(1));}}
+#define zzaArg(v,n)		zzaAt(v-n)
+#define zzMakeAttr		{ zzNON_GUESS_MODE {zzOvfChk; --zzasp; zzcr_attr(&(zzaAt(zzasp)),LA(1),LATEXT(1));}}
 #ifdef zzdef0
-#define zzMake0			{ zzOvfChk; --zzasp; zzdef0(&(zzaStack[zzasp]));}
+#define zzMake0			{ zzOvfChk; --zzasp; zzdef0(&(zzaAt(zzasp)));}
 #else
 #define zzMake0			{ zzOvfChk; --zzasp;}
 #endif
-#define zzaPush(_v)		{ zzOvfChk; zzaStack[--zzasp] = _v;}
+#define zzaPush(_v)		{ zzOvfChk; --zzasp; zzaAt(zzasp) = _v;}
 #ifndef zzd_attr
 #define zzREL(t)		zzasp=(t);		/* Restore state of stack */
 #else
 #define zzREL(t)		for (; zzasp<(t); zzasp++)				\
-						{ zzd_attr(&(zzaStack[zzasp])); }
+						{ zzd_attr(&(zzaAt(zzasp))); }
 #endif
 
 #define zzsetmatch(_es)						\
@@ -441,13 +460,13 @@ extern int _zzsetmatch_wdfltsig();
 #endif
 
 #ifdef GENAST
-#define zzRULE		Attrib *zzaRetPtr = &(zzaStack[zzasp-1]);	\
+#define zzRULE		Attrib *zzaRetPtr = &(zzaAt(zzasp-1));	\
 					SetWordType *zzMissSet=NULL; int zzMissTok=0;		\
 					int zzBadTok=0; char *zzBadText="";		\
 					int zzErrk=1;								\
 					char *zzMissText=""; zzASTVars
 #else
-#define zzRULE		Attrib *zzaRetPtr = &(zzaStack[zzasp-1]);	\
+#define zzRULE		Attrib *zzaRetPtr = &(zzaAt(zzasp-1));	\
 					int zzBadTok=0; char *zzBadText="";		\
 					int zzErrk=1;								\
 					SetWordType *zzMissSet=NULL; int zzMissTok=0; char *zzMissText=""
@@ -593,12 +612,20 @@ extern char zztextLA[][ZZLEXBUFSIZE];
 extern int zzlap;
 extern int zzlabase;
 #else
-extern int zztoken;
+extern zzTHREAD_LOCAL int zztoken;
 #endif
 
 extern char zzStackOvfMsg[];
-extern int zzasp;
-extern Attrib zzaStack[];
+extern zzTHREAD_LOCAL int zzasp;
+extern zzTHREAD_LOCAL Attrib zzaStack[];
+extern zzTHREAD_LOCAL Attrib *zzaChunks[];
+#ifdef __USE_PROTOS
+extern void zzaGrow(void);
+extern void zzaFreeChunks(void);
+#else
+extern void zzaGrow();
+extern void zzaFreeChunks();
+#endif
 #ifdef ZZINF_LOOK
 extern int *zzinf_tokens;
 extern char **zzinf_text;
@@ -619,7 +646,7 @@ extern zzjmp_buf zzguess_start;
  * These declarations duplicate those in dlgdef.h, but are needed
  * if ANTLR is not to generate a .dlg file (-gx); PS, this is a hack.
  */
-extern zzchar_t *zzlextext;     /* text of most recently matched token */
-extern int      zzbufsize;      /* how long zzlextext is */
+extern zzTHREAD_LOCAL zzchar_t *zzlextext; /* text of most recently matched token */
+extern zzTHREAD_LOCAL int      zzbufsize; /* how long zzlextext is */
 
 #endif
@@ -57,8 +57,15 @@ zzastnew(void)
 zzastnew()
 #endif
 {
+#ifdef zzastalloc
+	AST *p = zzastalloc();
+#else
 	AST *p = (AST *) calloc(1, sizeof(AST));
+#endif
 	if ( p == NULL ) fprintf(stderr,"%s(%d): cannot allocate AST node\n",__FILE__,__LINE__);
+#ifdef zzastcount
+	zzastcount();
+#endif
 	return p;
 }
 
@@ -168,10 +175,16 @@ zzfree_ast(tree)
 AST *tree;
 #endif
 {
-	if ( tree == NULL ) return;
-	zzfree_ast( tree->down );
-	zzfree_ast( tree->right );
-	zztfree( tree );
+	AST *next;
+
+	/* iterate along siblings: a list of entries can be very long */
+	while ( tree != NULL )
+	{
+		next = tree->right;
+		zzfree_ast( tree->down );
+		zztfree( tree );
+		tree = next;
+	}
 }
 
 /* build a tree (root child1 child2 ... NULL)
@@ -258,7 +271,11 @@ AST *t;
 #ifdef zzd_ast
 	zzd_ast( t );
 #endif
+#ifdef zzastdealloc
+	zzastdealloc( t );
+#else
 	free( t );
+#endif
 }
 
 #ifdef zzAST_DOUBLE
@@ -281,3 +298,50 @@ AST *t, *left, *up;
 	zzdouble_link(t->right, t, up);
 }
 #endif
+
+/* btparse: allocate the next chunk of the AST stack, if it isn't there
+ * already (see zzastOvfChk in ast.h)
+ */
+void
+#ifdef __STDC__
+zzastGrow(void)
+#else
+zzastGrow()
+#endif
+{
+	int c = (zzastTOP - zzast_sp + 1) / ZZAST_STACKSIZE;
+
+	if ( c >= ZZ_MAXCHUNKS )
+	{
+		fprintf(stderr, zzStackOvfMsg, __FILE__, __LINE__);
+		exit(PCCTS_EXIT_FAILURE);
+	}
+	if ( zzastChunks[c] == NULL )
+	{
+		zzastChunks[c] = (AST **) calloc(ZZAST_STACKSIZE, sizeof(AST *));
+		if ( zzastChunks[c] == NULL )
+		{
+			fprintf(stderr, zzStackOvfMsg, __FILE__, __LINE__);
+			exit(PCCTS_EXIT_FAILURE);
+		}
+	}
+}
+
+/* btparse: free all the chunks allocated by zzastGrow(); the stack must be
+ * (almost) empty
+ */
+void
+#ifdef __STDC__
+zzastFreeChunks(void)
+#else
+zzastFreeChunks()
+#endif
+{
+	int c;
+
+	for (c = 1; c < ZZ_MAXCHUNKS && zzastChunks[c] != NULL; c++)
+	{
+		free(zzastChunks[c]);
+		zzastChunks[c] = NULL;
+	}
+}
@@ -32,12 +32,17 @@
 #ifndef ZZAST_H
 #define ZZAST_H
 
+/* btparse: the AST stack grows in chunks, like the attribute stack
+ * (see antlr.h).
+ */
+#define zzastTOP		(ZZAST_STACKSIZE * ZZ_MAXCHUNKS)
+#define zzastAt(i)		zzastElem(zzastTOP - 1 - (i))
+#define zzastElem(p)	(*((p) < ZZAST_STACKSIZE ? &zzastStack[p] :	\
+						   &zzastChunks[(p) / ZZAST_STACKSIZE][(p) % ZZAST_STACKSIZE]))
+
 #define zzastOvfChk														\
-			if ( zzast_sp <= 0 )                                        \
-            {                                                           \
-                fprintf(stderr, zzStackOvfMsg, __FILE__, __LINE__);    	\
-                exit(PCCTS_EXIT_FAILURE);                                               \
-            }
+			if ( (zzastTOP - zzast_sp + 1) % ZZAST_STACKSIZE == 0 )     \
+				zzastGrow();
 
 #ifndef USER_DEFINED_AST
 #ifndef AST_FIELDS
@@ -70,21 +75,23 @@ typedef struct _ast {
 
 /* define global variables needed by #i stack */
 #define zzASTgvars												\
-	AST *zzastStack[ZZAST_STACKSIZE];							\
-	int zzast_sp = ZZAST_STACKSIZE;
+	zzTHREAD_LOCAL AST *zzastStack[ZZAST_STACKSIZE];			\
+	zzTHREAD_LOCAL AST **zzastChunks[ZZ_MAXCHUNKS];				\
+	zzTHREAD_LOCAL int zzast_sp = zzastTOP;
 
 #define zzASTVars	AST *_ast = NULL, *_sibling = NULL, *_tail = NULL
 #define zzSTR		( (_tail==NULL)?(&_sibling):(&(_tail->right)) )
-#define zzastCur	(zzastStack[zzast_sp])
-#define zzastArg(i)	(zzastStack[zztsp-i])
-#define zzastPush(p) zzastOvfChk; zzastStack[--zzast_sp] = p;
-#define zzastDPush	--zzast_sp
+#define zzastCur	(zzastAt(zzast_sp))
+#define zzastArg(i)	(zzastAt(zztsp-i))
+#define zzastPush(p) zzastOvfChk; --zzast_sp; zzastAt(zzast_sp) = p;
+#define zzastDPush	zzastOvfChk; --zzast_sp
 #define zzastMARK	zztsp=zzast_sp;		/* Save state of stack */
 #define zzastREL	zzast_sp=zztsp;		/* Return state of stack */
 #define zzrm_ast	{zzfree_ast(*_root); _tail = _sibling = (*_root)=NULL;}
 
-extern int zzast_sp;
-extern AST *zzastStack[];
+extern zzTHREAD_LOCAL int zzast_sp;
+extern zzTHREAD_LOCAL AST *zzastStack[];
+extern zzTHREAD_LOCAL AST **zzastChunks[];
 
 #ifdef __STDC__
 void zzlink(AST **, AST **, AST **);
@@ -92,6 +99,8 @@ void zzsubchild(AST **, AST **, AST **);
 void zzsubroot(AST **, AST **, AST **);
 void zzpre_ast(AST *, void (*)(), void (*)(), void (*)());
 void zzfree_ast(AST *);
+void zzastGrow(void);
+void zzastFreeChunks(void);
 AST *zztmake(AST *, ...);
 AST *zzdup_ast(AST *);
 void zztfree(AST *);
@@ -106,6 +115,8 @@ void zzsubchild();
 void zzsubroot();
 void zzpre_ast();
 void zzfree_ast();
+void zzastGrow();
+void zzastFreeChunks();
 AST *zztmake();
 AST *zzdup_ast();
 void zztfree();
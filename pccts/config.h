@@ -220,6 +220,16 @@ extern void fsetfileinfo (char *filename, unsigned long newcreator, unsigned lon
 
 #endif
 
+/*
+ * zzTHREAD_LOCAL qualifies the scanner and parser state (the DLG
+ * variables, the attribute and AST stacks, the lookahead token).  It is
+ * empty by default; a program that wants one scanner/parser per thread
+ * can define it to its compiler's thread-local storage class.
+ */
+#ifndef zzTHREAD_LOCAL
+# define zzTHREAD_LOCAL
+#endif
+
 #ifdef USER_ZZMODE_STACK
 # ifndef ZZSTACK_MAX_MODE
 #  define  ZZSTACK_MAX_MODE 32
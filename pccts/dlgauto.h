@@ -30,19 +30,19 @@
 #ifndef ZZDEFAUTO_H
 #define ZZDEFAUTO_H
 
-zzchar_t	*zzlextext;	/* text of most recently matched token */
-zzchar_t	*zzbegexpr;	/* beginning of last reg expr recogn. */
-zzchar_t	*zzendexpr;	/* beginning of last reg expr recogn. */
-int	zzbufsize;	/* number of characters in zzlextext */
-int	zzbegcol = 0;	/* column that first character of token is in*/
-int	zzendcol = 0;	/* column that last character of token is in */
-int	zzline = 1;	/* line current token is on */
-int	zzreal_line=1;	/* line of 1st portion of token that is not skipped */
-int	zzchar;		/* character to determine next state */
-int	zzbufovf;	/* indicates that buffer too small for text */
-int	zzcharfull = 0;
-static zzchar_t	*zznextpos;/* points to next available position in zzlextext*/
-static int 	zzclass;
+zzTHREAD_LOCAL zzchar_t	*zzlextext;	/* text of most recently matched token */
+zzTHREAD_LOCAL zzchar_t	*zzbegexpr;	/* beginning of last reg expr recogn. */
+zzTHREAD_LOCAL zzchar_t	*zzendexpr;	/* beginning of last reg expr recogn. */
+zzTHREAD_LOCAL int	zzbufsize;	/* number of characters in zzlextext */
+zzTHREAD_LOCAL int	zzbegcol = 0;	/* column that first character of token is in*/
+zzTHREAD_LOCAL int	zzendcol = 0;	/* column that last character of token is in */
+zzTHREAD_LOCAL int	zzline = 1;	/* line current token is on */
+zzTHREAD_LOCAL int	zzreal_line=1;	/* line of 1st portion of token that is not skipped */
+zzTHREAD_LOCAL int	zzchar;		/* character to determine next state */
+zzTHREAD_LOCAL int	zzbufovf;	/* indicates that buffer too small for text */
+zzTHREAD_LOCAL int	zzcharfull = 0;
+static zzTHREAD_LOCAL zzchar_t	*zznextpos;/* points to next available position in zzlextext*/
+static zzTHREAD_LOCAL int 	zzclass;
 
 #ifdef __USE_PROTOS
 void	zzerrstd(const char *);
@@ -54,17 +54,18 @@ void	(*zzerr)()=zzerrstd;	/* pointer to error reporting function */
 extern int	zzerr_in();
 #endif
 
-static FILE	*zzstream_in=0;
-static int	(*zzfunc_in)() = zzerr_in;
-static zzchar_t	*zzstr_in=0;
+static zzTHREAD_LOCAL FILE	*zzstream_in=0;
+static zzTHREAD_LOCAL int	(*zzfunc_in)() = zzerr_in;
+static zzTHREAD_LOCAL zzchar_t	*zzstr_in=0;
+static zzTHREAD_LOCAL zzchar_t	*zzstr_end=0;	/* end of zzrdbuf() input, or 0 */
 
 #ifdef USER_ZZMODE_STACK
-int 	          zzauto = 0;
+zzTHREAD_LOCAL int 	          zzauto = 0;
 #else
-static int     zzauto = 0;
+static zzTHREAD_LOCAL int     zzauto = 0;
 #endif
-static int	zzadd_erase;
-static char 	zzebuf[70];
+static zzTHREAD_LOCAL int	zzadd_erase;
+static zzTHREAD_LOCAL char 	zzebuf[70];
 
 #ifdef ZZCOL
 #define ZZINC (++zzendcol)
@@ -76,7 +77,7 @@ static char 	zzebuf[70];
 #define ZZGETC_STREAM {zzchar = getc(zzstream_in); zzclass = ZZSHIFT(zzchar);}
 #define ZZGETC_FUNC {zzchar = (*zzfunc_in)(); zzclass = ZZSHIFT(zzchar);}
 #define ZZGETC_STR { 			\
-	if (*zzstr_in){				\
+	if (zzstr_end ? zzstr_in < zzstr_end : *zzstr_in){ \
 		zzchar = *zzstr_in;		\
 		++zzstr_in;				\
 	}else{						\
@@ -87,6 +88,74 @@ static char 	zzebuf[70];
 
 #define ZZNEWSTATE	(newstate = dfa[state][zzclass])
 
+#ifdef ZZRUN_MODE
+#include <string.h>
+
+/* Bulk scanning of runs (not in stock DLG).  If the user defines
+   ZZRUN_MODE, then in that mode a token that starts with a character for
+   which ZZRUN_START(c) is true must be one that runs up to (not
+   including) the next character for which ZZRUN_STOP(c) is true, or end
+   of input, and whose action is just zzmore().  Rather than walk the
+   automaton through it one character at a time, zzrun() copies the whole
+   run into the buffer at once -- with ZZRUN_SPAN(s,end), which returns
+   the number of characters before the first stop character in s (up to
+   end, or to a null if end is 0), when reading from a string -- and
+   leaves zzchar at the stop character, just as the zzmore() would.
+   ZZRUN_OVERFLOW(lastpos,nextpos) must make more room in the buffer. */
+static void
+#ifdef __USE_PROTOS
+zzrun( zzchar_t **lastpos )
+#else
+zzrun( lastpos )
+zzchar_t **lastpos;
+#endif
+{
+	size_t	n;
+
+	if (zzstr_in) {
+		n = ZZRUN_SPAN(zzstr_in, zzstr_end);
+		while ((size_t) (*lastpos - zznextpos) <= n)
+			ZZRUN_OVERFLOW(lastpos, &zznextpos);
+		*(zznextpos++) = zzchar;
+		memcpy(zznextpos, zzstr_in, n);
+		zznextpos += n;
+		zzstr_in += n;
+#ifdef ZZCOL
+		zzendcol += n;
+#endif
+		ZZGETC_STR;
+		ZZINC;
+	}
+	else if (zzstream_in) {
+		/* keep it all in locals: getc() could change any global */
+		zzchar_t *p = zznextpos;
+		int	c = zzchar;
+
+		n = 0;
+		do {
+			if (p >= *lastpos) {
+				zznextpos = p;
+				ZZRUN_OVERFLOW(lastpos, &zznextpos);
+				p = zznextpos;
+			}
+			*(p++) = c;
+			c = getc(zzstream_in);
+			n++;
+		} while (c != EOF && !ZZRUN_STOP(c));
+		zznextpos = p;
+		zzchar = c;
+		zzclass = ZZSHIFT(zzchar);
+#ifdef ZZCOL
+		zzendcol += n;
+#endif
+	}
+#ifdef ZZLEXED
+	ZZLEXED(zznextpos - zzbegexpr);
+#endif
+	zzbegexpr = zznextpos;
+}
+#endif
+
 #ifndef ZZCOPY
 #define ZZCOPY	\
 	/* Truncate matching buffer to size (not an error) */	\
@@ -119,6 +188,7 @@ FILE *f;
 		zzstream_in = f;
 		zzfunc_in = NULL;
 		zzstr_in = 0;
+		zzstr_end = 0;
 		zzcharfull = 0;
 	}
 }
@@ -145,6 +215,7 @@ int (*f)();
 		zzstream_in = NULL;
 		zzfunc_in = f;
 		zzstr_in = 0;
+		zzstr_end = 0;
 		zzcharfull = 0;
 	}
 }
@@ -172,6 +243,28 @@ zzchar_t *s;
 		zzstream_in = NULL;
 		zzfunc_in = 0;
 		zzstr_in = s;
+		zzstr_end = 0;
+		zzcharfull = 0;
+	}
+}
+
+/* like zzrdstr(), but reads exactly len chars from s (which need not be
+   null-terminated, and may contain nulls) */
+void
+#ifdef __USE_PROTOS
+zzrdbuf( zzchar_t *s, size_t len )
+#else
+zzrdbuf( s, len )
+zzchar_t *s;
+size_t len;
+#endif
+{
+	if (s){
+		zzline = 1;
+		zzstream_in = NULL;
+		zzfunc_in = 0;
+		zzstr_in = s;
+		zzstr_end = s + len;
 		zzcharfull = 0;
 	}
 }
@@ -199,6 +292,7 @@ struct zzdlg_state *state;
 	state->stream = zzstream_in;
 	state->func_ptr = zzfunc_in;
 	state->str = zzstr_in;
+	state->str_end = zzstr_end;
 	state->auto_num = zzauto;
 	state->add_erase = zzadd_erase;
 	state->lookc = zzchar;
@@ -226,6 +320,7 @@ struct zzdlg_state *state;
 	zzstream_in = state->stream;
 	zzfunc_in = state->func_ptr;
 	zzstr_in = state->str;
+	zzstr_end = state->str_end;
 	zzauto = state->auto_num;
 	zzadd_erase = state->add_erase;
 	zzchar = state->lookc;
@@ -322,12 +417,19 @@ register zzchar_t *s;
 	zzendexpr = zznextpos - 1;
 }
 
+/* Hooks for counting (not in stock DLG): if defined, ZZGETTOK_BEGIN is
+   a declaration made on entry to zzgettok(), ZZGETTOK_END a statement
+   executed just before it returns a token, and ZZLEXED(n) is told of
+   every n characters matched (including those skipped or zzmore()'d). */
 void
 zzgettok()
 {
 	register int state, newstate;
 	/* last space reserved for the null char */
 	zzchar_t *lastpos;           /* GPW 1997/09/05 (removed 'register' */
+#ifdef ZZGETTOK_BEGIN
+	ZZGETTOK_BEGIN;
+#endif
 
 skip:
 	zzreal_line = zzline;
@@ -390,6 +492,10 @@ more:
 		zzadvance();
 	else
 		ZZINC;
+#ifdef ZZRUN_MODE
+	if (zzauto == ZZRUN_MODE && zzchar != EOF && ZZRUN_START(zzchar))
+		zzrun(&lastpos);
+#endif
 	state = dfa_base[zzauto];
 	if (zzstr_in)
 		while (ZZNEWSTATE != DfaStates){
@@ -430,12 +536,18 @@ more:
 	zzendcol -= zzcharfull;
 #endif
 	zzendexpr = zznextpos -1;
+#ifdef ZZLEXED
+	ZZLEXED(zznextpos - zzbegexpr);
+#endif
 	zzadd_erase = 0;
 	(*actions[accepts[state]])();
 	switch (zzadd_erase) {
 		case 1: goto skip;
 		case 2: goto more;
 	}
+#ifdef ZZGETTOK_END
+	ZZGETTOK_END;
+#endif
 }
 
 void
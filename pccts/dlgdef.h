@@ -46,6 +46,7 @@ struct zzdlg_state {
 	FILE *stream;
 	int (*func_ptr)();
 	zzchar_t *str;
+	zzchar_t *str_end;
 	int auto_num;
 	int add_erase;
 	int lookc;
@@ -59,16 +60,16 @@ struct zzdlg_state {
 	int	class_num;
 };
 
-extern zzchar_t	*zzlextext;  	/* text of most recently matched token */
-extern zzchar_t	*zzbegexpr;	/* beginning of last reg expr recogn. */
-extern zzchar_t	*zzendexpr;	/* beginning of last reg expr recogn. */
-extern int	zzbufsize;	/* how long zzlextext is */
-extern int	zzbegcol;	/* column that first character of token is in*/
-extern int	zzendcol;	/* column that last character of token is in */
-extern int	zzline;		/* line current token is on */
-extern int	zzreal_line;		/* line of 1st portion of token that is not skipped */
-extern int	zzchar;		/* character to determine next state */
-extern int	zzbufovf;	/* indicates that buffer too small for text */
+extern zzTHREAD_LOCAL zzchar_t	*zzlextext;  	/* text of most recently matched token */
+extern zzTHREAD_LOCAL zzchar_t	*zzbegexpr;	/* beginning of last reg expr recogn. */
+extern zzTHREAD_LOCAL zzchar_t	*zzendexpr;	/* beginning of last reg expr recogn. */
+extern zzTHREAD_LOCAL int	zzbufsize;	/* how long zzlextext is */
+extern zzTHREAD_LOCAL int	zzbegcol;	/* column that first character of token is in*/
+extern zzTHREAD_LOCAL int	zzendcol;	/* column that last character of token is in */
+extern zzTHREAD_LOCAL int	zzline;		/* line current token is on */
+extern zzTHREAD_LOCAL int	zzreal_line;		/* line of 1st portion of token that is not skipped */
+extern zzTHREAD_LOCAL int	zzchar;		/* character to determine next state */
+extern zzTHREAD_LOCAL int	zzbufovf;	/* indicates that buffer too small for text */
 #ifdef __USE_PROTOS
 extern void	(*zzerr)(const char *);/* pointer to error reporting function */
 #else
@@ -76,7 +77,7 @@ extern void	(*zzerr)();
 #endif
 
 #ifdef USER_ZZMODE_STACK
-extern int     zzauto;
+extern zzTHREAD_LOCAL int     zzauto;
 #endif
 
 #ifdef __USE_PROTOS
@@ -88,6 +89,7 @@ extern void	zzrdstream(FILE *);/* what stream to read from */
 extern void	zzclose_stream(void);/* close the current input stream */
 extern void	zzrdfunc(int (*)());/* what function to get char from */
 extern void zzrdstr( zzchar_t * );
+extern void zzrdbuf( zzchar_t *, size_t );/* read from a counted buffer */
 extern void	zzgettok(void);	/* get next token */
 extern void	zzreplchar(zzchar_t c);/* replace last recognized reg. expr. with
 					a character */
@@ -109,6 +111,7 @@ extern void	zzrdstream();	/* what stream to read from */
 extern void	zzclose_stream();/* close the current input stream */
 extern void	zzrdfunc();	/* what function to get char from */
 extern void zzrdstr();
+extern void zzrdbuf();
 extern void	zzgettok();	/* get next token */
 extern void	zzreplchar();	/* replace last recognized reg. expr. with
 					a character */
@@ -38,6 +38,7 @@
 #include "config.h"
 
 #include <string.h>
+#include <stdlib.h>
 #ifdef __STDC__
 #include <stdarg.h>
 #else
@@ -78,7 +79,7 @@ zzresynch(wd,mask)
 SetWordType *wd, mask;
 #endif
 {
-	static int consumed = 1;
+	static zzTHREAD_LOCAL int consumed = 1;
 
 	/* if you enter here without having consumed a token from last resynch
 	 * force a token consumption.
@@ -129,10 +130,10 @@ va_dcl
 #endif
 {
 #ifdef LL_K
-	static char text[LL_K*ZZLEXBUFSIZE+1];
+	static zzTHREAD_LOCAL char text[LL_K*ZZLEXBUFSIZE+1];
 	SetWordType *f[LL_K];
 #else
-	static char text[ZZLEXBUFSIZE+1];
+	static zzTHREAD_LOCAL char text[ZZLEXBUFSIZE+1];
 	SetWordType *f[1];
 #endif
 	SetWordType **miss_set;
@@ -265,6 +266,53 @@ zzantlr_state *buf;
 #endif
 }
 
+/* btparse: allocate the next chunk of the attribute stack, if it isn't
+ * there already (see zzOvfChk in antlr.h)
+ */
+void
+#ifdef __USE_PROTOS
+zzaGrow(void)
+#else
+zzaGrow()
+#endif
+{
+	int c = (zzaTOP - zzasp + 1) / ZZA_STACKSIZE;
+
+	if ( c >= ZZ_MAXCHUNKS )
+	{
+		fprintf(stderr, zzStackOvfMsg, __FILE__, __LINE__);
+		exit(PCCTS_EXIT_FAILURE);
+	}
+	if ( zzaChunks[c] == NULL )
+	{
+		zzaChunks[c] = (Attrib *) calloc(ZZA_STACKSIZE, sizeof(Attrib));
+		if ( zzaChunks[c] == NULL )
+		{
+			fprintf(stderr, zzStackOvfMsg, __FILE__, __LINE__);
+			exit(PCCTS_EXIT_FAILURE);
+		}
+	}
+}
+
+/* btparse: free all the chunks allocated by zzaGrow(); the stack must be
+ * (almost) empty
+ */
+void
+#ifdef __USE_PROTOS
+zzaFreeChunks(void)
+#else
+zzaFreeChunks()
+#endif
+{
+	int c;
+
+	for (c = 1; c < ZZ_MAXCHUNKS && zzaChunks[c] != NULL; c++)
+	{
+		free(zzaChunks[c]);
+		zzaChunks[c] = NULL;
+	}
+}
+
 void
 #ifdef __USE_PROTOS
 zzedecode(SetWordType *a)
@@ -785,9 +833,9 @@ SetWordType *e;
 }
 
 #ifdef USER_ZZMODE_STACK
-static int  zzmstk[ZZMAXSTK] = { -1 };
-static int  zzmdep = 0;
-static char zzmbuf[70];
+static zzTHREAD_LOCAL int  zzmstk[ZZMAXSTK] = { -1 };
+static zzTHREAD_LOCAL int  zzmdep = 0;
+static zzTHREAD_LOCAL char zzmbuf[70];
 
 void
 #ifdef __USE_PROTOS
@@ -48,6 +48,9 @@ static boolean collapse_whitespace = TRUE;
 static boolean check_only = FALSE;
 static boolean dump_ast = FALSE;
 static boolean whole_file = FALSE;
+static boolean bibtex = FALSE;
+static boolean json = FALSE;
+static boolean split_names = FALSE;
 
 struct option option_table[] = 
 {
@@ -65,6 +68,9 @@ struct option option_table[] =
    { "dump",       0, &dump_ast, 1 },
    { "nodump",     0, &dump_ast, 0 },
    { "wholefile",  0, &whole_file, 1 },
+   { "bibtex",     0, &bibtex, 1 },
+   { "json",       0, &json, 1 },
+   { "splitnames", 0, &split_names, 1 },
    { NULL, 0, 0, 0 }
 };
 
@@ -102,6 +108,9 @@ parser_options *parse_args (int argc, char **argv)
    options->check_only = check_only;
    options->dump_ast = dump_ast;
    options->whole_file = whole_file;
+   options->bibtex = bibtex;
+   options->json = json;
+   options->split_names = split_names;
 
    return options;
 
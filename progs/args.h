@@ -27,6 +27,9 @@ typedef struct
    boolean   quote_strings;
    boolean   dump_ast;
    boolean   whole_file;
+   boolean   bibtex;                    /* write entries back as BibTeX */
+   boolean   json;                      /* ... or as JSON */
+   boolean   split_names;               /* (with names split up) */
 } parser_options;
 
 parser_options *parse_args (int argc, char **argv);
@@ -0,0 +1,71 @@
+/* ------------------------------------------------------------------------
+@NAME       : bibgen.c
+@INPUT      :
+@OUTPUT     : synthetic BibTeX on stdout
+@RETURNS    :
+@DESCRIPTION: Writes out a synthetic BibTeX corpus, as generated for
+              bt_bench, so that it can be fed to other programs (or to
+              bt_bench again, or an older version of it).
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse distribution (but not part
+              of the library itself).  This is free software; you can
+              redistribute it and/or modify it under the terms of the GNU
+              General Public License as published by the Free Software
+              Foundation; either version 2 of the License, or (at your
+              option) any later version.
+-------------------------------------------------------------------------- */
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "getopt.h"
+#include "corpus.h"
+
+char *  Usage = "usage: bibgen [options] > file.bib\n";
+char *  Help =
+"\n"
+"Options:\n"
+CORPUS_HELP
+"\n";
+
+struct option option_table[] =
+{
+   CORPUS_OPTIONS,
+   { NULL, 0, 0, 0 }
+};
+
+
+int main (int argc, char *argv[])
+{
+   corpus_params  params;
+   char *         text;
+   size_t         len;
+   int            c;
+
+   default_corpus_params (&params);
+   while ((c = getopt_long_only (argc, argv, "", option_table, NULL)) != -1)
+   {
+      if (! set_corpus_param (&params, c, optarg))
+      {
+         fprintf (stderr, Usage);
+         fprintf (stderr, Help);
+         exit (1);
+      }
+   }
+   if (optind < argc)
+   {
+      fprintf (stderr, Usage);
+      fprintf (stderr, Help);
+      fprintf (stderr, "Too many arguments\n");
+      exit (1);
+   }
+
+   text = generate_corpus (&params, &len);
+   if (fwrite (text, 1, len, stdout) != len)
+   {
+      perror ("bibgen");
+      exit (1);
+   }
+   free (text);
+   exit (0);
+}
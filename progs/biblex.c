@@ -34,7 +34,6 @@
 
 int main (int argc, char *argv[])
 {
-   extern char * InputFilename;         /* from input.c in the library */
    char  * filename;
    FILE  * infile;
 
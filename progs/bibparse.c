@@ -35,11 +35,24 @@
 
 extern void dump_ast (char *msg, AST *root); /* stolen from btparse */
 
+static bt_writer * Writer = NULL;       /* for -bibtex */
+
+/* Output for -json: built up in one big block, written when full. */
+#define JSON_BUF_SIZE (256 * 1024)
+
+static char *   JsonBuf = NULL;
+static size_t   JsonUsed = 0;
+static boolean  JsonFailed = FALSE;
+
 char *  Usage = "usage: bibparse [options] file [...]\n";
 char *  Help = 
 "\n"
 "Options:\n"
 "  -check         check syntax only (ie. don't print entries out)\n"
+"  -bibtex        print entries out as BibTeX (with -quote, use quotes\n"
+"                 rather than braces around strings)\n"
+"  -json          print entries out as JSON, one object per line\n"
+"  -splitnames    with -json, split up author and editor names too\n"
 "  -noquote       don't quote strings [default]\n"
 "  -quote         put quotes around strings (warning: not bulletproof)\n"
 "  -convert       convert numeric values to strings\n"
@@ -214,71 +227,429 @@ print_entry (FILE *stream, AST *top, boolean quote_strings)
 
 
 /* ------------------------------------------------------------------------
-@NAME       : process_file
-@INPUT      : filename
+@NAME       : flush_json()
+@INPUT      : 
 @OUTPUT     : 
-@RETURNS    : true if there were no errors or only trivial errors
-              false if there were serious errors
-@DESCRIPTION: Parses an entire BibTeX file one entry at a time.  Each 
-              entry is separately read, parsed, and printed back out
-              to minimize memory use.
-@GLOBALS    : 
-@CALLS      : 
-@CREATED    : Jan 1997, GPW
+@RETURNS    : 
+@DESCRIPTION: Writes out the JSON buffer in one go.
+@GLOBALS    : JsonBuf, JsonUsed, JsonFailed
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static void
+flush_json (void)
+{
+   if (JsonUsed > 0 && !JsonFailed &&
+       fwrite (JsonBuf, 1, JsonUsed, stdout) != JsonUsed)
+      JsonFailed = TRUE;
+   JsonUsed = 0;
+}
+
+
+/* Appends to the JSON buffer, which must have room for `n' more bytes. */
+#define JSON_ROOM(n) \
+   do { if (JsonUsed + (n) > JSON_BUF_SIZE) flush_json (); } while (0)
+
+static void
+put_json (const char *s, size_t n)
+{
+   JSON_ROOM (n);
+   if (n > JSON_BUF_SIZE)
+   {
+      if (!JsonFailed && fwrite (s, 1, n, stdout) != n)
+         JsonFailed = TRUE;
+      return;
+   }
+   memcpy (JsonBuf + JsonUsed, s, n);
+   JsonUsed += n;
+}
+
+#define put_json_str(s) put_json (s, strlen (s))
+
+
+/* ------------------------------------------------------------------------
+@NAME       : utf8_length()
+@INPUT      : s - text (null-terminated)
+@OUTPUT     : 
+@RETURNS    : length of the UTF-8 sequence at `s', or 0 if it's not one
+@DESCRIPTION: Checks for a well-formed multi-byte UTF-8 sequence (with no
+              overlong forms or surrogates).
+@CREATED    : 2026/10/16
 @MODIFIED   : 
-@COMMENTS   : this *might* eventually wind up in the library, with
-              a function pointer argument to specify what to do 
-              to each entry
 -------------------------------------------------------------------------- */
 static int
-process_file (char *filename, parser_options *options)
+utf8_length (const unsigned char *s)
+{
+   int  len, i;
+
+   if (s[0] >= 0xc2 && s[0] <= 0xdf)      len = 2;
+   else if (s[0] >= 0xe0 && s[0] <= 0xef) len = 3;
+   else if (s[0] >= 0xf0 && s[0] <= 0xf4) len = 4;
+   else return 0;
+
+   for (i = 1; i < len; i++)
+      if ((s[i] & 0xc0) != 0x80)
+         return 0;
+   if ((s[0] == 0xe0 && s[1] < 0xa0) ||   /* overlong */
+       (s[0] == 0xed && s[1] >= 0xa0) ||  /* surrogate */
+       (s[0] == 0xf0 && s[1] < 0x90) ||   /* overlong */
+       (s[0] == 0xf4 && s[1] >= 0x90))    /* past U+10FFFF */
+      return 0;
+   return len;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : put_json_chars()
+@INPUT      : s - text to write in a JSON string
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Escapes `s' straight into the JSON buffer (without the
+              quotes around it).  Runs of characters that need no
+              escaping are copied in one go.  Well-formed UTF-8 goes
+              through as it is; any other byte over 127 is taken to be
+              Latin-1 and written as UTF-8, so that the output is always
+              valid JSON.
+@GLOBALS    : JsonBuf, JsonUsed
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static void
+put_json_chars (const char *s)
 {
-   FILE   *infile;
-   AST    *cur_entry;
-   boolean status, overall_status;
+   static const char hex[] = "0123456789abcdef";
+   const unsigned char *p, *run;
+   int   len;
 
-   /*
-    * If a string was given, and it's *not* "-", then open that filename.
-    * Otherwise just use stdin.
-    */
+   p = (const unsigned char *) s;
+   while (*p)
+   {
+      for (run = p; *p >= 0x20 && *p < 0x80 && *p != '"' && *p != '\\'; p++)
+         ;
+      if (p > run)
+         put_json ((const char *) run, p - run);
+      if (*p == 0)
+         break;
+
+      JSON_ROOM (6);
+      if (*p == '"' || *p == '\\')
+      {
+         JsonBuf[JsonUsed++] = '\\';
+         JsonBuf[JsonUsed++] = *p++;
+      }
+      else if (*p < 0x20)
+      {
+         JsonBuf[JsonUsed++] = '\\';
+         switch (*p)
+         {
+            case '\n': JsonBuf[JsonUsed++] = 'n'; break;
+            case '\t': JsonBuf[JsonUsed++] = 't'; break;
+            case '\r': JsonBuf[JsonUsed++] = 'r'; break;
+            default:
+               memcpy (JsonBuf + JsonUsed, "u00", 3);
+               JsonBuf[JsonUsed+3] = hex[*p >> 4];
+               JsonBuf[JsonUsed+4] = hex[*p & 0xf];
+               JsonUsed += 5;
+               break;
+         }
+         p++;
+      }
+      else if ((len = utf8_length (p)) > 0)
+      {
+         memcpy (JsonBuf + JsonUsed, p, len);
+         JsonUsed += len;
+         p += len;
+      }
+      else                              /* Latin-1 to UTF-8 */
+      {
+         JsonBuf[JsonUsed++] = (char) (0xc0 | (*p >> 6));
+         JsonBuf[JsonUsed++] = (char) (0x80 | (*p & 0x3f));
+         p++;
+      }
+   }
+}
 
-   if (filename != NULL && strcmp (filename, "-") != 0)
+
+/* Writes `s' as a JSON string (or null). */
+static void
+put_json_string (const char *s)
+{
+   if (s == NULL)
+   {
+      put_json ("null", 4);
+      return;
+   }
+   put_json ("\"", 1);
+   put_json_chars (s);
+   put_json ("\"", 1);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : put_json_value()
+@INPUT      : top - a field, or a comment or preamble entry
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Writes the value of `top': a string if it's a single
+              simple value (as it is once pasted), or else an array with
+              a string for each string or number and {"macro": name}
+              for each unexpanded macro.
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static void
+put_json_value (AST *top)
+{
+   AST *       value;
+   bt_nodetype nodetype;
+   char *      text;
+   boolean     array;
+
+   value = NULL;
+   array = FALSE;
+   while ((value = bt_next_value (top, value, &nodetype, &text)))
    {
-      infile = fopen (filename, "r");
-      if (infile == NULL)
+      if (value->right != NULL && !array)
       {
-         perror (filename);
-         return 0;
+         put_json ("[", 1);
+         array = TRUE;
+      }
+      else if (array)
+         put_json (",", 1);
+
+      if (nodetype == BTAST_MACRO)
+      {
+         put_json ("{\"macro\":", 9);
+         put_json_string (text);
+         put_json ("}", 1);
       }
+      else
+         put_json_string (text ? text : "");
+   }
+   if (array)
+      put_json ("]", 1);
+   else if (top->down == NULL)
+      put_json ("\"\"", 2);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : put_json_names()
+@INPUT      : field - an author or editor field
+              filename
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Writes an array of the names in a field, each split into
+              its first, von, last and jr parts (leaving out empty ones).
+@CALLS      : bt_split_list(), bt_split_name()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static void
+put_json_names (AST *field, char *filename)
+{
+   static char *   part_names[BT_MAX_NAMEPARTS] =
+      { "first", "von", "last", "jr" };
+   bt_stringlist * list;
+   bt_name *       name;
+   char *          value;
+   int             i, part, tok;
+   boolean         first_name, first_part, first_tok;
+
+   put_json ("[", 1);
+   value = bt_get_text (field);
+   list = value ? bt_split_list (value, "and", filename, field->line, "name")
+                : NULL;
+   first_name = TRUE;
+   for (i = 0; list && i < list->num_items; i++)
+   {
+      if (list->items[i] == NULL)
+         continue;
+      if (!first_name)
+         put_json (",", 1);
+      first_name = FALSE;
+      name = bt_split_name (list->items[i], filename, field->line, i);
+      put_json ("{", 1);
+      first_part = TRUE;
+      for (part = 0; part < BT_MAX_NAMEPARTS; part++)
+      {
+         for (tok = 0; tok < name->part_len[part]; tok++)
+            if (name->parts[part][tok] != NULL)
+               break;
+         if (tok == name->part_len[part])  /* empty part */
+            continue;
+         if (!first_part)
+            put_json (",", 1);
+         put_json ("\"", 1);
+         put_json_str (part_names[part]);
+         put_json ("\":\"", 3);
+         for (tok = 0, first_tok = TRUE; tok < name->part_len[part]; tok++)
+         {
+            if (name->parts[part][tok] == NULL)
+               continue;
+            if (!first_tok)
+               put_json (" ", 1);
+            put_json_chars (name->parts[part][tok]);
+            first_tok = FALSE;
+         }
+         put_json ("\"", 1);
+         first_part = FALSE;
+      }
+      put_json ("}", 1);
+      bt_free_name (name);
+   }
+   put_json ("]", 1);
+   if (list) bt_free_list (list);
+   free (value);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : print_json_entry()
+@INPUT      : top
+              split_names - whether to add the split-up author and editor
+                            names
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Prints an entry as a JSON object on a line of its own:
+
+                {"metatype": ..., "type": ..., "key": ...,
+                 "fields": {name: value, ...},
+                 "names": {"author": [{"first": ..., "last": ...}, ...]}}
+
+              A comment or preamble has "value" instead of "fields";
+              "key" is null for anything but a regular entry; and
+              "names" is only there if asked for, and if the entry has
+              an author or editor field.
+@GLOBALS    : 
+@CALLS      : put_json_value(), put_json_names()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static void
+print_json_entry (AST *top, boolean split_names)
+{
+   static char *  metatypes[] =
+      { "unknown", "regular", "comment", "preamble", "macrodef" };
+   AST *    field;
+   char *   field_name;
+   boolean  first;
+   bt_metatype metatype;
+
+   metatype = bt_entry_metatype (top);
+   put_json_str ("{\"metatype\":\"");
+   put_json_str (metatypes[metatype]);
+   put_json_str ("\",\"type\":");
+   put_json_string (bt_entry_type (top));
+   put_json_str (",\"key\":");
+   put_json_string (bt_entry_key (top));
+
+   if (metatype == BTE_COMMENT || metatype == BTE_PREAMBLE)
+   {
+      put_json_str (",\"value\":");
+      put_json_value (top);
    }
    else
    {
-      filename = "(stdin)";
-      infile = stdin;
+      put_json_str (",\"fields\":{");
+      field = NULL;
+      first = TRUE;
+      while ((field = bt_next_field (top, field, &field_name)))
+      {
+         if (!first) put_json (",", 1);
+         put_json_string (field_name);
+         put_json (":", 1);
+         put_json_value (field);
+         first = FALSE;
+      }
+      put_json ("}", 1);
+
+      first = TRUE;
+      field = NULL;
+      while (split_names && metatype == BTE_REGULAR &&
+             (field = bt_next_field (top, field, &field_name)))
+      {
+         if (strcmp (field_name, "author") != 0 &&
+             strcmp (field_name, "editor") != 0)
+            continue;
+         put_json_str (first ? ",\"names\":{" : ",");
+         put_json_string (field_name);
+         put_json (":", 1);
+         put_json_names (field, top->filename);
+         first = FALSE;
+      }
+      if (!first)
+         put_json ("}", 1);
+   }
+   put_json ("}\n", 2);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : process_entry
+@INPUT      : entry
+              status - whether it parsed without serious errors
+              data - the parser_options
+@OUTPUT     : 
+@RETURNS    : BTCB_FREE (we're done with the entry)
+@DESCRIPTION: Callback for bt_process_file(): prints an entry back out
+              (and/or dumps its AST, saying whether it had errors), as
+              requested by the options.
+@GLOBALS    : Writer, JsonBuf
+@CALLS      : 
+@CREATED    : Jan 1997, GPW (as the guts of process_file())
+@MODIFIED   : 2026/10/16 (split out as a callback for bt_process_file())
+              2026/10/16 (added -bibtex, -json)
+-------------------------------------------------------------------------- */
+static int
+process_entry (AST *entry, boolean status, void *data)
+{
+   parser_options *options = (parser_options *) data;
+
+   if (!options->check_only)
+   {
+      if (options->json)
+         print_json_entry (entry, options->split_names);
+      else if (options->bibtex)
+         bt_write_entry (entry, Writer);
+      else
+         print_entry (stdout, entry, options->quote_strings);
+   }
+   if (options->dump_ast)
+   {
+      if (JsonBuf)                      /* keep the dump after its entry */
+         flush_json ();
+      dump_ast (status ? "AST for whole entry:\n"
+                       : "AST for whole entry (with errors):\n", entry);
    }
+   return BTCB_FREE;
+}
+
 
+/* ------------------------------------------------------------------------
+@NAME       : process_file
+@INPUT      : filename
+@OUTPUT     : 
+@RETURNS    : true if there were no errors or only trivial errors
+              false if there were serious errors
+@DESCRIPTION: Parses an entire BibTeX file one entry at a time.  Each 
+              entry is separately read, parsed, and printed back out
+              to minimize memory use.
+@GLOBALS    : 
+@CALLS      : bt_process_file()
+@CREATED    : Jan 1997, GPW
+@MODIFIED   : 2026/10/16 (the loop is now bt_process_file() in the library)
+-------------------------------------------------------------------------- */
+static int
+process_file (char *filename, parser_options *options)
+{
    bt_set_stringopts (BTE_MACRODEF, options->string_opts);
    bt_set_stringopts (BTE_REGULAR, options->string_opts);
    bt_set_stringopts (BTE_COMMENT, options->string_opts);
    bt_set_stringopts (BTE_PREAMBLE, options->string_opts);
-      
-   overall_status = 1;                  /* assume success */
-   while (1)
-   {
-      cur_entry = bt_parse_entry (infile, filename, 
-                                  options->other_opts,
-                                  &status);
-      overall_status &= status;
-      if (!cur_entry) break;
-      if (!options->check_only)
-         print_entry (stdout, cur_entry, options->quote_strings);
-      if (options->dump_ast)
-         dump_ast ("AST for whole entry:\n", cur_entry);
-      bt_free_ast (cur_entry);
-   }
 
-   fclose (infile);
-   return overall_status;
+   return bt_process_file (filename, options->other_opts,
+                           process_entry, options);
 
 } /* process_file() */
 
@@ -289,6 +660,14 @@ int main (int argc, char *argv[])
 
    options = parse_args (argc, argv);
    bt_initialize ();
+   if (options->bibtex)
+   {
+      Writer = bt_writer_new (stdout);
+      if (options->quote_strings)
+         bt_writer_set_quote (Writer, '"');
+   }
+   if (options->json)
+      JsonBuf = (char *) malloc (JSON_BUF_SIZE);
 
    if (argv[optind])            /* any leftover arguments (filenames) */
    {
@@ -305,6 +684,18 @@ int main (int argc, char *argv[])
       exit (1);
    }
 
+   if (JsonBuf)
+   {
+      flush_json ();
+      free (JsonBuf);
+      if (fflush (stdout) != 0)
+         JsonFailed = TRUE;
+   }
+   if ((Writer && !bt_writer_free (Writer)) || JsonFailed)
+   {
+      perror ("bibparse");
+      exit (1);
+   }
    bt_cleanup ();
    free (options);
    exit (bt_error_status (NULL));
@@ -0,0 +1,515 @@
+/* ------------------------------------------------------------------------
+@NAME       : bt_bench.c
+@INPUT      : a BibTeX file, or parameters for a synthetic one
+@OUTPUT     : timings for each stage of processing, on stdout
+@RETURNS    :
+@DESCRIPTION: Benchmarks the btparse library one stage at a time:
+              lexing alone (biblex-style, poking about in the library's
+              private bits), parsing, postprocessing, splitting author
+              lists into names, formatting those names, writing the
+              entries back out (both in full and by copying them from
+              the original text), and finding duplicate entries (on one
+              thread and on all of them).  For each
+              stage, reports the best time over several runs as MB/s
+              and entries/s.
+
+              The input is either a file named on the command line or
+              a synthetic corpus (see corpus.c), generated in memory
+              from the same options that bibgen takes.  Since the same
+              options and seed always give the same corpus, runs of
+              different versions of the library can be compared.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse distribution (but not part
+              of the library itself).  This is free software; you can
+              redistribute it and/or modify it under the terms of the GNU
+              General Public License as published by the Free Software
+              Foundation; either version 2 of the License, or (at your
+              option) any later version.
+-------------------------------------------------------------------------- */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <btparse.h>
+#include "stdpccts.h"                   /* poke about btparse's private bits */
+
+#include "getopt.h"
+#include "corpus.h"
+
+char *  Usage = "usage: bt_bench [options] [file]\n";
+char *  Help =
+"\n"
+"Benchmarks file (or, if none given, a synthetic corpus).  Options:\n"
+"  -repeat N      run each stage N times and report the best [3]\n"
+CORPUS_HELP
+"\n";
+
+struct option option_table[] =
+{
+   { "repeat",     1, NULL, 'R' },
+   CORPUS_OPTIONS,
+   { NULL, 0, 0, 0 }
+};
+
+typedef struct
+{
+   AST **          entries;
+   int             num_entries;
+   int             num_regular;
+   bt_stringlist **
+                   lists;               /* one author list per entry */
+   bt_name **      names;
+   int             num_names;
+   size_t          name_bytes;          /* total length of author fields */
+} bench_state;
+
+
+static double
+now (void)
+{
+#ifdef CLOCK_MONOTONIC
+   struct timespec t;
+
+   clock_gettime (CLOCK_MONOTONIC, &t);
+   return (double) t.tv_sec + (double) t.tv_nsec * 1e-9;
+#else
+   return (double) clock () / CLOCKS_PER_SEC;
+#endif
+}
+
+
+static char *
+read_file (char * filename, size_t * len)
+{
+   FILE *  infile;
+   char *  buf;
+   long    size;
+
+   infile = fopen (filename, "rb");
+   if (infile == NULL)
+   {
+      perror (filename);
+      exit (1);
+   }
+   fseek (infile, 0L, SEEK_END);
+   size = ftell (infile);
+   rewind (infile);
+   buf = (char *) malloc ((size_t) size + 1);
+   if (buf == NULL || fread (buf, 1, (size_t) size, infile) != (size_t) size)
+   {
+      fprintf (stderr, "bt_bench: couldn't read %s\n", filename);
+      exit (1);
+   }
+   buf[size] = (char) 0;
+   fclose (infile);
+   *len = (size_t) size;
+   return buf;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : lex_buffer()
+@INPUT      : buf, len
+@RETURNS    : number of tokens
+@DESCRIPTION: Runs just the lexical scanner over a buffer, the way
+              start_parse() in input.c sets it up, without any parsing.
+-------------------------------------------------------------------------- */
+static long
+lex_buffer (char * buf, size_t len)
+{
+   long   num_tokens = 0;
+
+   InputFilename = "(lex)";
+   initialize_lexer_state ();
+   alloc_lex_buffer (ZZLEXBUFSIZE);
+   zzrdbuf ((zzchar_t *) buf, len);
+   zzendcol = zzbegcol = 0;
+   do
+   {
+      zzgettok ();
+      num_tokens++;
+   }
+   while (zztoken != zzEOF_TOKEN);
+   free_lex_buffer ();
+   InputFilename = NULL;
+
+   return num_tokens;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : parse_buffer()
+@INPUT      : buf, len
+@OUTPUT     : state - entries filled in
+@DESCRIPTION: Parses every entry in the buffer with BTO_LAZY, so that the
+              fields' postprocessing is left for postprocess_entries().
+              At most one error of each class is reported; the rest are
+              counted, but (as with any big, messy input) not printed.
+-------------------------------------------------------------------------- */
+static void
+parse_buffer (char * buf, size_t len, bench_state * state)
+{
+   bt_parser *  parser;
+   AST *        entry;
+   boolean      status;
+   int          alloced = 1024;
+
+   state->entries = (AST **) malloc (alloced * sizeof (AST *));
+   state->num_entries = state->num_regular = 0;
+
+   parser = bt_parser_new_buffer (buf, len, "(parse)");
+   bt_parser_queue_errors (parser, 1);
+   while ((entry = bt_parser_parse_entry (parser, BTO_LAZY, &status)))
+   {
+      if (state->num_entries == alloced)
+      {
+         alloced *= 2;
+         state->entries = (AST **)
+            realloc (state->entries, alloced * sizeof (AST *));
+      }
+      state->entries[state->num_entries++] = entry;
+      if (bt_entry_metatype (entry) == BTE_REGULAR)
+         state->num_regular++;
+   }
+   bt_parser_free (parser);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : postprocess_entries()
+@INPUT      : state
+@DESCRIPTION: Finishes the postprocessing that BTO_LAZY put off, by
+              asking for every field's value.
+-------------------------------------------------------------------------- */
+static void
+postprocess_entries (bench_state * state)
+{
+   AST *   field;
+   char *  fname;
+   int     i;
+
+   for (i = 0; i < state->num_entries; i++)
+   {
+      switch (bt_entry_metatype (state->entries[i]))
+      {
+         case BTE_REGULAR:
+            field = NULL;
+            while ((field = bt_next_field (state->entries[i], field, &fname)))
+               bt_get_value (field);
+            break;
+         case BTE_COMMENT:
+         case BTE_PREAMBLE:
+            bt_get_value (state->entries[i]);
+            break;
+         default:
+            break;
+      }
+   }
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : split_names()
+@INPUT      : state
+@DESCRIPTION: Splits the author field of every regular entry into a list
+              of names, and each of those into its parts.
+-------------------------------------------------------------------------- */
+static void
+split_names (bench_state * state)
+{
+   bt_stringlist *  list;
+   AST *            field;
+   char *           fname;
+   char *           value;
+   int              alloced = 1024;
+   int              i, j;
+
+   state->lists = (bt_stringlist **)
+      calloc (state->num_entries, sizeof (bt_stringlist *));
+   state->names = (bt_name **) malloc (alloced * sizeof (bt_name *));
+   state->num_names = 0;
+   state->name_bytes = 0;
+
+   for (i = 0; i < state->num_entries; i++)
+   {
+      if (bt_entry_metatype (state->entries[i]) != BTE_REGULAR)
+         continue;
+      field = NULL;
+      while ((field = bt_next_field (state->entries[i], field, &fname)))
+         if (strcmp (fname, "author") == 0)
+            break;
+      if (field == NULL || (value = bt_get_value (field)) == NULL)
+         continue;
+      state->name_bytes += strlen (value);
+      list = state->lists[i] = bt_split_list (value, "and", NULL, 0, "name");
+      if (list == NULL)
+         continue;
+      for (j = 0; j < list->num_items; j++)
+      {
+         if (list->items[j] == NULL)
+            continue;
+         if (state->num_names == alloced)
+         {
+            alloced *= 2;
+            state->names = (bt_name **)
+               realloc (state->names, alloced * sizeof (bt_name *));
+         }
+         state->names[state->num_names++] =
+            bt_split_name (list->items[j], NULL, 0, j);
+      }
+   }
+}
+
+
+static void
+format_names (bench_state * state, bt_name_format * format)
+{
+   int   i;
+
+   for (i = 0; i < state->num_names; i++)
+      free (bt_format_name (state->names[i], format));
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : write_entries()
+@INPUT      : state
+              source, len - text to copy unchanged entries from (or NULL)
+@RETURNS    : number of bytes written
+@DESCRIPTION: Writes every entry back out as BibTeX, into memory.
+-------------------------------------------------------------------------- */
+static size_t
+write_entries (bench_state * state, const char * source, size_t len)
+{
+   bt_writer *  writer;
+   size_t       written;
+   int          i;
+
+   writer = bt_writer_new (NULL);
+   bt_writer_set_source (writer, source, len);
+   for (i = 0; i < state->num_entries; i++)
+      bt_write_entry (state->entries[i], writer);
+   bt_writer_text (writer, &written);
+   bt_writer_free (writer);
+   return written;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : find_duplicates()
+@INPUT      : state
+              num_threads - for bt_find_duplicates()
+@RETURNS    : number of clusters of duplicates found
+@DESCRIPTION: Fingerprints and clusters all the entries; they're linked
+              into a list just for the occasion.
+-------------------------------------------------------------------------- */
+static int
+find_duplicates (bench_state * state, int num_threads)
+{
+   bt_dupmap *  map;
+   int          num_clusters;
+   int          i;
+
+   for (i = 0; i + 1 < state->num_entries; i++)
+      state->entries[i]->right = state->entries[i+1];
+   map = bt_find_duplicates (state->num_entries > 0 ? state->entries[0] : NULL,
+                             num_threads);
+   num_clusters = bt_dupmap_clusters (map);
+   bt_dupmap_free (map);
+   for (i = 0; i < state->num_entries; i++)
+      state->entries[i]->right = NULL;
+   return num_clusters;
+}
+
+
+static void
+free_names (bench_state * state)
+{
+   int   i;
+
+   for (i = 0; i < state->num_names; i++)
+      bt_free_name (state->names[i]);
+   for (i = 0; i < state->num_entries; i++)
+      if (state->lists[i] != NULL)
+         bt_free_list (state->lists[i]);
+   free (state->names);
+   free (state->lists);
+}
+
+
+static void
+free_entries (bench_state * state)
+{
+   int   i;
+
+   for (i = 0; i < state->num_entries; i++)
+      bt_free_ast (state->entries[i]);
+   free (state->entries);
+   bt_delete_all_macros ();             /* so the next run starts afresh */
+}
+
+
+static void
+report (char * stage, double secs, size_t bytes, int entries)
+{
+   if (secs <= 0.0)
+      secs = 1e-9;
+   printf ("%-12s %10.4f %10.2f %12.0f\n",
+           stage, secs, bytes / secs / (1024.0 * 1024.0), entries / secs);
+}
+
+
+#define BEST(best,start) \
+   { double t = now () - (start); if ((best) < 0 || t < (best)) (best) = t; }
+
+int main (int argc, char *argv[])
+{
+   corpus_params  params;
+   bench_state    state;
+   bt_name_format *
+                  format;
+   bt_stats       stats;
+   boolean        have_stats;
+   char *         buf;
+   size_t         len;
+   int            repeat = 3;
+   double         start;
+   double         lex_time = -1, parse_time = -1, post_time = -1,
+                  split_time = -1, format_time = -1,
+                  write_time = -1, copy_time = -1,
+                  dedup_time = -1, dedup_par_time = -1;
+   size_t         written = 0, copied = 0;
+   int            num_clusters = 0;
+   long           num_tokens = 0;
+   int            i, c;
+
+   default_corpus_params (&params);
+   while ((c = getopt_long_only (argc, argv, "", option_table, NULL)) != -1)
+   {
+      if (c == 'R' ? (repeat = atoi (optarg)) < 1
+                   : ! set_corpus_param (&params, c, optarg))
+      {
+         fprintf (stderr, Usage);
+         fprintf (stderr, Help);
+         exit (1);
+      }
+   }
+   if (argc - optind > 1)
+   {
+      fprintf (stderr, Usage);
+      fprintf (stderr, Help);
+      fprintf (stderr, "Too many arguments\n");
+      exit (1);
+   }
+
+   if (optind < argc)
+      buf = read_file (argv[optind], &len);
+   else
+      buf = generate_corpus (&params, &len);
+
+   bt_initialize ();
+   bt_set_stringopts (BTE_MACRODEF, BTO_MACRO);
+   bt_set_stringopts (BTE_REGULAR, BTO_FULL);
+   bt_set_stringopts (BTE_COMMENT, BTO_FULL);
+   bt_set_stringopts (BTE_PREAMBLE, BTO_FULL);
+   format = bt_create_name_format ("fvlj", FALSE);
+
+   for (i = 0; i < repeat; i++)
+   {
+      start = now ();
+      num_tokens = lex_buffer (buf, len);
+      BEST (lex_time, start);
+   }
+
+   for (i = 0; i < repeat; i++)
+   {
+      if (i > 0)
+         free_entries (&state);
+      bt_reset_stats ();
+
+      start = now ();
+      parse_buffer (buf, len, &state);
+      BEST (parse_time, start);
+
+      start = now ();
+      postprocess_entries (&state);
+      BEST (post_time, start);
+   }
+   have_stats = bt_get_stats (&stats);  /* for the last run only */
+
+   for (i = 0; i < repeat; i++)
+   {
+      if (i > 0)
+         free_names (&state);
+
+      start = now ();
+      split_names (&state);
+      BEST (split_time, start);
+   }
+
+   for (i = 0; i < repeat; i++)
+   {
+      start = now ();
+      format_names (&state, format);
+      BEST (format_time, start);
+   }
+
+   for (i = 0; i < repeat; i++)
+   {
+      start = now ();
+      written = write_entries (&state, NULL, 0);
+      BEST (write_time, start);
+
+      start = now ();
+      copied = write_entries (&state, buf, len);
+      BEST (copy_time, start);
+   }
+
+   for (i = 0; i < repeat; i++)
+   {
+      start = now ();
+      num_clusters = find_duplicates (&state, 1);
+      BEST (dedup_time, start);
+
+      start = now ();
+      find_duplicates (&state, 0);
+      BEST (dedup_par_time, start);
+   }
+
+   printf ("%lu bytes, %ld tokens, %d entries (%d regular), %d names\n",
+           (unsigned long) len, num_tokens,
+           state.num_entries, state.num_regular, state.num_names);
+   printf ("%d clusters of duplicates\n", num_clusters);
+   printf ("best of %d runs:\n", repeat);
+   printf ("%-12s %10s %10s %12s\n", "stage", "seconds", "MB/s", "entries/s");
+   report ("lex", lex_time, len, state.num_entries);
+   report ("parse", parse_time, len, state.num_entries);
+   report ("postprocess", post_time, len, state.num_entries);
+   report ("split names", split_time, state.name_bytes, state.num_regular);
+   report ("format names", format_time, state.name_bytes, state.num_regular);
+   report ("write", write_time, written, state.num_entries);
+   report ("write raw", copy_time, copied, state.num_entries);
+   report ("dedup", dedup_time, len, state.num_entries);
+   report ("dedup par", dedup_par_time, len, state.num_entries);
+
+   if (have_stats)
+   {
+      printf ("\nlast parse (from bt_get_stats()):\n");
+      printf ("  %lu bytes lexed, %lu tokens, %lu AST nodes\n",
+              stats.bytes_lexed, stats.tokens, stats.ast_nodes);
+      printf ("  %lu macro lookups (%lu found), %lu values pasted, "
+              "%lu lexical buffer reallocations\n",
+              stats.macro_lookups, stats.macro_hits, stats.strings_pasted,
+              stats.lex_reallocs);
+      printf ("  %.4f s lexing and parsing, %.4f s postprocessing\n",
+              stats.parse_time, stats.postprocess_time);
+   }
+
+   free_names (&state);
+   free_entries (&state);
+   bt_free_name_format (format);
+   free (buf);
+   bt_cleanup ();
+   exit (0);
+}
@@ -0,0 +1,460 @@
+/* ------------------------------------------------------------------------
+@NAME       : corpus.c
+@DESCRIPTION: Generates synthetic BibTeX for benchmarking: a block of
+              @string definitions followed by regular entries whose
+              size and difficulty (string length, macro use, pasting,
+              length of name lists, syntax errors, near-duplicates) are
+              set by a corpus_params.  The same parameters and seed always give
+              the same text.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse distribution (but not part
+              of the library itself).  This is free software; you can
+              redistribute it and/or modify it under the terms of the GNU
+              General Public License as published by the Free Software
+              Foundation; either version 2 of the License, or (at your
+              option) any later version.
+-------------------------------------------------------------------------- */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "corpus.h"
+
+#define NUM_MACROS 64
+
+typedef struct
+{
+   char *    text;
+   size_t    len;
+   size_t    size;
+} textbuf;
+
+static char * Words[] =
+{
+   "analysis", "of", "the", "a", "parsing", "BibTeX", "fast", "large",
+   "on", "theory", "method", "for", "databases", "{TeX}", "in", "and",
+   "bibliographic", "systems", "with", "{\\'e}tude", "algorithms", "data",
+   "study", "new", "efficient", "approach", "to", "{S}tructures"
+};
+
+static char * FirstNames[] =
+{
+   "John", "Mary", "Jean-Paul", "Q.", "Donald E.", "Ana", "{\\'E}mile",
+   "Wei", "Ludwig", "Kim"
+};
+
+static char * VonParts[] = { "van", "de la", "von", "van der", "di" };
+
+static char * LastNames[] =
+{
+   "Smith", "Knuth", "Lamport", "M{\\\"u}ller", "Nguyen", "Beethoven",
+   "Garc{\\'\\i}a", "Ward", "Patashnik", "{Barnes and Noble}", "Zhang"
+};
+
+static char * ExtraFields[] =
+{
+   "journal", "booktitle", "publisher", "address", "volume", "number",
+   "pages", "note", "series", "edition", "abstract", "keywords"
+};
+
+#define NUM(array) ((int) (sizeof (array) / sizeof (array[0])))
+
+static unsigned long RandState;
+
+
+/* A small, portable generator, so a seed means the same on every system */
+static unsigned long
+next_random (void)
+{
+   RandState = (RandState * 1103515245UL + 12345UL) & 0xffffffffUL;
+   return RandState >> 8;
+}
+
+static int
+random_int (int n)
+{
+   return (int) (next_random () % (unsigned long) n);
+}
+
+static boolean
+random_chance (double p)
+{
+   return (next_random () & 0xffffff) < (unsigned long) (p * 0x1000000);
+}
+
+
+static void
+put_text (textbuf * buf, const char * s, size_t n)
+{
+   if (buf->len + n + 1 > buf->size)
+   {
+      while (buf->len + n + 1 > buf->size)
+         buf->size = buf->size ? buf->size * 2 : 65536;
+      buf->text = (char *) realloc (buf->text, buf->size);
+      if (buf->text == NULL)
+      {
+         fprintf (stderr, "out of memory generating corpus\n");
+         exit (1);
+      }
+   }
+   memcpy (buf->text + buf->len, s, n);
+   buf->len += n;
+   buf->text[buf->len] = (char) 0;
+}
+
+static void
+put_str (textbuf * buf, const char * s)
+{
+   put_text (buf, s, strlen (s));
+}
+
+static void
+put_num (textbuf * buf, long n)
+{
+   char   num[32];
+
+   sprintf (num, "%ld", n);
+   put_str (buf, num);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : put_words()
+@INPUT      : buf
+              len - how many characters to aim for
+@DESCRIPTION: Appends random words (a few of them with braces or TeX
+              accents) to `buf' until at least `len' characters are
+              added; at least one word in any case.
+-------------------------------------------------------------------------- */
+static void
+put_words (textbuf * buf, int len)
+{
+   size_t  start = buf->len;
+
+   do
+   {
+      if (buf->len > start)
+         put_str (buf, " ");
+      put_str (buf, Words[random_int (NUM (Words))]);
+   }
+   while (buf->len - start < (size_t) len);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : put_value()
+@INPUT      : buf
+              params
+@DESCRIPTION: Appends a field value: paste_depth+1 pieces joined by `#',
+              each either a macro (with probability macro_density) or a
+              string delimited by braces or quotes.
+-------------------------------------------------------------------------- */
+static void
+put_value (textbuf * buf, corpus_params * params)
+{
+   int   piece_len;
+   int   i;
+
+   piece_len = params->string_len / (params->paste_depth + 1);
+   for (i = 0; i <= params->paste_depth; i++)
+   {
+      if (i > 0)
+         put_str (buf, " # ");
+      if (random_chance (params->macro_density))
+      {
+         put_str (buf, "m");
+         put_num (buf, random_int (NUM_MACROS));
+      }
+      else if (random_int (2))
+      {
+         put_str (buf, "{");
+         put_words (buf, piece_len);
+         put_str (buf, "}");
+      }
+      else
+      {
+         put_str (buf, "\"");
+         put_words (buf, piece_len);
+         put_str (buf, "\"");
+      }
+   }
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : put_name()
+@INPUT      : buf
+@DESCRIPTION: Appends one name, in one of BibTeX's three forms (with or
+              without a "von" part).
+-------------------------------------------------------------------------- */
+static void
+put_name (textbuf * buf)
+{
+   char *  first = FirstNames[random_int (NUM (FirstNames))];
+   char *  von = random_int (4) ? NULL : VonParts[random_int (NUM (VonParts))];
+   char *  last = LastNames[random_int (NUM (LastNames))];
+
+   switch (random_int (4))
+   {
+      case 0:                           /* von Last, First */
+      case 1:
+         if (von) { put_str (buf, von); put_str (buf, " "); }
+         put_str (buf, last);
+         put_str (buf, ", ");
+         put_str (buf, first);
+         break;
+      case 2:                           /* von Last, Jr, First */
+         if (von) { put_str (buf, von); put_str (buf, " "); }
+         put_str (buf, last);
+         put_str (buf, ", Jr., ");
+         put_str (buf, first);
+         break;
+      default:                          /* First von Last */
+         put_str (buf, first);
+         put_str (buf, " ");
+         if (von) { put_str (buf, von); put_str (buf, " "); }
+         put_str (buf, last);
+         break;
+   }
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : put_entry()
+@INPUT      : buf
+              params
+              num - entry number (for the key)
+@DESCRIPTION: Appends a regular entry with author, title, and year
+              fields, and as many others as needed to make num_fields.
+              With probability error_rate, one of the commas between
+              fields is left out, which is a syntax error.
+-------------------------------------------------------------------------- */
+static void
+put_entry (textbuf * buf, corpus_params * params, int num)
+{
+   int   bad_field = -1;
+   int   i;
+
+   if (random_chance (params->error_rate))
+      bad_field = random_int (params->num_fields - 1);
+
+   put_str (buf, random_int (2) ? "@article{key" : "@InProceedings{key");
+   put_num (buf, num);
+   put_str (buf, ",\n");
+   for (i = 0; i < params->num_fields; i++)
+   {
+      switch (i)
+      {
+         case 0:
+            put_str (buf, "  author = {");
+            {
+               int  j;
+
+               for (j = 0; j < params->num_names; j++)
+               {
+                  if (j > 0)
+                     put_str (buf, " and ");
+                  put_name (buf);
+               }
+            }
+            put_str (buf, "}");
+            break;
+         case 1:
+            put_str (buf, "  title = ");
+            put_value (buf, params);
+            break;
+         case 2:
+            put_str (buf, "  year = ");
+            put_num (buf, 1950 + random_int (75));
+            break;
+         default:
+            put_str (buf, "  ");
+            if (i - 3 < NUM (ExtraFields))
+               put_str (buf, ExtraFields[i-3]);
+            else
+            {
+               put_str (buf, "field");
+               put_num (buf, i);
+            }
+            put_str (buf, " = ");
+            put_value (buf, params);
+            break;
+      }
+      if (i < params->num_fields - 1 && i != bad_field)
+         put_str (buf, ",");
+      put_str (buf, "\n");
+   }
+   put_str (buf, "}\n\n");
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : put_near_copy()
+@INPUT      : buf
+              orig - text of an earlier entry (not in `buf', which may
+                     move)
+              num  - entry number (for the key)
+@DESCRIPTION: Appends a near-duplicate of `orig': the same work, as far
+              as bt_find_duplicates() is concerned, but with its own key,
+              maybe a different entry type, and some of the title's
+              words capitalized.  (Letters inside braces within the title
+              are left alone, since changing those would change the
+              title after case-folding.)
+-------------------------------------------------------------------------- */
+static void
+put_near_copy (textbuf * buf, const char * orig, int num)
+{
+   const char * line;
+   const char * end;
+   int          depth;
+   boolean      quoted;
+   char         c;
+
+   put_str (buf, random_int (2) ? "@article{key" : "@InProceedings{key");
+   put_num (buf, num);
+   line = strchr (orig, ',');
+   while (*line)
+   {
+      end = strchr (line, '\n');
+      end = end ? end + 1 : line + strlen (line);
+      if (strncmp (line, "  title = ", 10) != 0)
+      {
+         put_text (buf, line, end - line);
+         line = end;
+         continue;
+      }
+
+      depth = 0;
+      quoted = FALSE;
+      for (; line < end; line++)
+      {
+         c = *line;
+         if (c == '{')
+            depth++;
+         else if (c == '}')
+            depth--;
+         else if (c == '"' && depth == 0)
+            quoted = !quoted;
+         else if (c >= 'a' && c <= 'z' && depth == (quoted ? 0 : 1)
+                  && (line[-1] == ' ' || line[-1] == '{' || line[-1] == '"')
+                  && random_int (2))
+            c += 'A' - 'a';
+         put_text (buf, &c, 1);
+      }
+   }
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : default_corpus_params()
+@INPUT      :
+@OUTPUT     : *params - filled in with the defaults listed in CORPUS_HELP
+@RETURNS    :
+-------------------------------------------------------------------------- */
+void default_corpus_params (corpus_params * params)
+{
+   params->num_entries = 1000;
+   params->num_fields = 8;
+   params->string_len = 40;
+   params->macro_density = 0.1;
+   params->paste_depth = 0;
+   params->num_names = 3;
+   params->error_rate = 0.0;
+   params->dup_rate = 0.05;
+   params->seed = 1;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : set_corpus_param()
+@INPUT      : opt - option character, from CORPUS_OPTIONS
+              arg - its argument
+@OUTPUT     : *params - with the option's parameter set
+@RETURNS    : TRUE if `opt' was one of ours and `arg' was valid
+-------------------------------------------------------------------------- */
+boolean set_corpus_param (corpus_params * params, int opt, char * arg)
+{
+   char *  end;
+   long    n;
+   double  f;
+
+   n = strtol (arg, &end, 10);
+   f = strtod (arg, NULL);
+   switch (opt)
+   {
+      case 'n': params->num_entries = (int) n; return *end == 0 && n >= 0;
+      case 'f': params->num_fields = (int) n;  return *end == 0 && n >= 3;
+      case 's': params->string_len = (int) n;  return *end == 0 && n >= 0;
+      case 'p': params->paste_depth = (int) n; return *end == 0 && n >= 0;
+      case 'a': params->num_names = (int) n;   return *end == 0 && n >= 1;
+      case 'r': params->seed = (unsigned) n;   return *end == 0;
+      case 'm': params->macro_density = f;     return f >= 0 && f <= 1;
+      case 'e': params->error_rate = f;        return f >= 0 && f <= 1;
+      case 'd': params->dup_rate = f;          return f >= 0 && f <= 1;
+      default:  return FALSE;
+   }
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : generate_corpus()
+@INPUT      : params
+@OUTPUT     : *len - length of the text
+@RETURNS    : the generated text (null-terminated, malloc'd)
+@DESCRIPTION: Generates NUM_MACROS @string definitions (m0, m1, ...),
+              then params->num_entries regular entries that use them.
+              With probability dup_rate, an entry is a near-duplicate of
+              one of the entries before it (see put_near_copy()).
+-------------------------------------------------------------------------- */
+char * generate_corpus (corpus_params * params, size_t * len)
+{
+   textbuf  buf = { NULL, 0, 0 };
+   size_t * starts;                     /* where each entry begins */
+   char *   orig;
+   int      i, j;
+
+   RandState = params->seed;
+   for (i = 0; i < NUM_MACROS; i++)
+   {
+      put_str (&buf, "@string{m");
+      put_num (&buf, i);
+      put_str (&buf, " = {");
+      put_words (&buf, params->string_len / (params->paste_depth + 1));
+      put_str (&buf, "}}\n");
+   }
+   put_str (&buf, "\n");
+
+   starts = (size_t *) malloc ((params->num_entries + 1) * sizeof (size_t));
+   if (starts == NULL)
+   {
+      fprintf (stderr, "out of memory generating corpus\n");
+      exit (1);
+   }
+   for (i = 0; i < params->num_entries; i++)
+   {
+      starts[i] = buf.len;
+      if (i > 0 && random_chance (params->dup_rate))
+      {
+         j = random_int (i);
+         orig = (char *) malloc (starts[j+1] - starts[j] + 1);
+         if (orig == NULL)
+         {
+            fprintf (stderr, "out of memory generating corpus\n");
+            exit (1);
+         }
+         memcpy (orig, buf.text + starts[j], starts[j+1] - starts[j]);
+         orig[starts[j+1] - starts[j]] = (char) 0;
+         put_near_copy (&buf, orig, i);
+         free (orig);
+      }
+      else
+         put_entry (&buf, params, i);
+   }
+   free (starts);
+
+   *len = buf.len;
+   return buf.text;
+}
@@ -0,0 +1,60 @@
+/* ------------------------------------------------------------------------
+@NAME       : corpus.h
+@DESCRIPTION: Parameters for, and prototype of, the synthetic BibTeX
+              corpus generator shared by bibgen and bt_bench.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse distribution (but not part
+              of the library itself).  This is free software; you can
+              redistribute it and/or modify it under the terms of the GNU
+              General Public License as published by the Free Software
+              Foundation; either version 2 of the License, or (at your
+              option) any later version.
+-------------------------------------------------------------------------- */
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stddef.h>
+#include <btparse.h>
+
+typedef struct
+{
+   int       num_entries;               /* regular entries to generate */
+   int       num_fields;                /* fields per entry (at least 3) */
+   int       string_len;                /* approx. length of string values */
+   double    macro_density;             /* chance a value piece is a macro */
+   int       paste_depth;               /* `#' operators per value */
+   int       num_names;                 /* names per author list */
+   double    error_rate;                /* chance an entry is malformed */
+   double    dup_rate;                  /* chance an entry is a near-copy */
+   unsigned  seed;
+} corpus_params;
+
+/* The options that set corpus_params, for getopt_long_only(). */
+#define CORPUS_OPTIONS \
+   { "entries",    1, NULL, 'n' }, \
+   { "fields",     1, NULL, 'f' }, \
+   { "strlen",     1, NULL, 's' }, \
+   { "macros",     1, NULL, 'm' }, \
+   { "paste",      1, NULL, 'p' }, \
+   { "names",      1, NULL, 'a' }, \
+   { "errors",     1, NULL, 'e' }, \
+   { "dups",       1, NULL, 'd' }, \
+   { "seed",       1, NULL, 'r' }
+
+#define CORPUS_HELP \
+"  -entries N     number of regular entries [1000]\n" \
+"  -fields N      fields per entry, including author, title, year [8]\n" \
+"  -strlen N      approximate length of each string value [40]\n" \
+"  -macros F      fraction of values (or pieces) that are macros [0.1]\n" \
+"  -paste N       number of `#' operators in each value [0]\n" \
+"  -names N       number of names in each author list [3]\n" \
+"  -errors F      fraction of entries with a syntax error [0]\n" \
+"  -dups F        fraction of entries that copy an earlier one [0.05]\n" \
+"  -seed N        random number seed [1]\n"
+
+void    default_corpus_params (corpus_params * params);
+boolean set_corpus_param (corpus_params * params, int opt, char * arg);
+char *  generate_corpus (corpus_params * params, size_t * len);
+
+#endif /* CORPUS_H */
@@ -0,0 +1,380 @@
+/* ------------------------------------------------------------------------
+@NAME       : arena.c
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: A simple arena (aka region or pool) allocator.  Memory is
+              carved sequentially out of a list of large blocks, and can
+              only be released all at once by freeing the whole arena.
+              While an arena is selected with bt_set_arena(), all AST
+              nodes and their text created by the current thread come
+              out of it, so a whole forest of entries can be built with
+              a handful of malloc() calls and thrown away in one go.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse library.  This library is
+              free software; you can redistribute it and/or modify it under
+              the terms of the GNU Library General Public License as
+              published by the Free Software Foundation; either version 2
+              of the License, or (at your option) any later version.
+-------------------------------------------------------------------------- */
+
+#include "bt_config.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "btparse.h"
+#include "error.h"
+#include "prototypes.h"
+#include "my_dmalloc.h"
+
+
+#define DEFAULT_BLOCK_SIZE 65536
+
+/*
+ * Everything handed out is aligned to ARENA_ALIGN, which is the size of
+ * this union (good enough for anything we put in an arena).
+ */
+typedef union
+{
+   long     l;
+   double   d;
+   void *   p;
+} arena_align_t;
+
+#define ARENA_ALIGN (sizeof (arena_align_t))
+#define ROUND_UP(n) (((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+typedef struct arena_block_s
+{
+   struct arena_block_s *
+                next;
+   size_t       size;                   /* bytes available in data[] */
+   size_t       used;                   /* bytes handed out so far */
+   arena_align_t
+                data[1];                /* really `size' bytes long */
+} arena_block;
+
+struct bt_arena_s
+{
+   arena_block *
+                blocks;                 /* current block first */
+   size_t       block_size;             /* size of a normal block */
+   bt_arena *   children;               /* arenas adopted by this one */
+   bt_arena *   next_child;             /* sibling in parent's list */
+   char *       map;                    /* file owned, from map_file() */
+   size_t       map_len;
+};
+
+static BT_THREAD_LOCAL bt_arena * CurrentArena = NULL;
+
+
+/* ------------------------------------------------------------------------
+@NAME       : new_block()
+@INPUT      : size - number of bytes the block must be able to hold
+@OUTPUT     :
+@RETURNS    : a new, empty block
+@DESCRIPTION: Allocates an arena block, bombing via internal_error() if
+              memory is exhausted (the same as running out of memory
+              anywhere else in the parser).
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static arena_block *
+new_block (size_t size)
+{
+   arena_block * block;
+
+   block = (arena_block *) malloc (offsetof (arena_block, data) + size);
+   if (block == NULL)
+      internal_error ("out of memory allocating arena block");
+   block->next = NULL;
+   block->size = size;
+   block->used = 0;
+   return block;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : arena_get()
+@INPUT      : arena
+              size
+@OUTPUT     :
+@RETURNS    : pointer to `size' bytes of (uninitialized) memory in `arena'
+@DESCRIPTION: The guts of bt_arena_alloc() and bt_arena_strdup().  Small
+              requests are served from the current block, starting a
+              fresh one when it fills up; requests too big to fit
+              comfortably in a normal block get a block of their own,
+              which goes behind the current block so that the space left
+              in it isn't wasted.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void *
+arena_get (bt_arena * arena, size_t size)
+{
+   arena_block * block;
+   void *        p;
+
+   size = ROUND_UP (size);
+   block = arena->blocks;
+   if (block == NULL || block->used + size > block->size)
+   {
+      if (size > arena->block_size / 4)
+      {
+         block = new_block (size);
+         if (arena->blocks == NULL)
+         {
+            arena->blocks = block;
+         }
+         else
+         {
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+         }
+      }
+      else
+      {
+         block = new_block (arena->block_size);
+         block->next = arena->blocks;
+         arena->blocks = block;
+      }
+   }
+
+   p = (char *) block->data + block->used;
+   block->used += size;
+   return p;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_arena_new()
+@INPUT      : block_size - size of the blocks the arena allocates from
+                           (0 means use a sensible default)
+@OUTPUT     :
+@RETURNS    : a new, empty arena
+@DESCRIPTION: Creates an arena.  No memory is allocated until something
+              is allocated from it.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+bt_arena * bt_arena_new (size_t block_size)
+{
+   bt_arena * arena;
+
+   arena = (bt_arena *) malloc (sizeof (bt_arena));
+   if (arena == NULL)
+      internal_error ("out of memory allocating arena");
+   arena->blocks = NULL;
+   arena->children = NULL;
+   arena->next_child = NULL;
+   arena->map = NULL;
+   arena->map_len = 0;
+   arena->block_size = ROUND_UP (block_size > 0
+                                 ? block_size : DEFAULT_BLOCK_SIZE);
+   return arena;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_arena_free()
+@INPUT      : arena
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Frees an arena and everything ever allocated from it,
+              including any ASTs built while it was selected, any arenas
+              it has adopted, and any file it owns.  If it's still the
+              current thread's arena, it's deselected first.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void bt_arena_free (bt_arena * arena)
+{
+   arena_block * block,
+               * next;
+   bt_arena *    child,
+            *    next_child;
+
+   if (arena == NULL) return;
+   if (arena == CurrentArena)
+      CurrentArena = NULL;
+
+   for (child = arena->children; child != NULL; child = next_child)
+   {
+      next_child = child->next_child;
+      bt_arena_free (child);
+   }
+
+   for (block = arena->blocks; block != NULL; block = next)
+   {
+      next = block->next;
+      free (block);
+   }
+   unmap_file (arena->map, arena->map_len);
+   free (arena);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : arena_adopt()
+@INPUT      : parent
+              child
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Makes `parent' responsible for `child', so that freeing
+              `parent' frees `child' too.  This is how ASTs built in
+              several threads (each with its own arena, since an arena
+              can't be shared between threads) end up belonging to the
+              caller's arena.  The child stays intact, so nodes that
+              point to it are still good.
+@CALLERS    : bt_parse_buffer_parallel()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void arena_adopt (bt_arena * parent, bt_arena * child)
+{
+   child->next_child = parent->children;
+   parent->children = child;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : arena_own_map()
+@INPUT      : arena
+              map, len - a file loaded by map_file()
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Makes `arena' responsible for a mapped file, so that it's
+              unmapped when the arena is freed.  This is for ASTs that
+              live in the file itself (see bt_forest_load()).
+@CALLERS    : load_forest() (in cache.c)
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void arena_own_map (bt_arena * arena, char * map, size_t len)
+{
+   arena->map = map;
+   arena->map_len = len;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_arena_alloc()
+@INPUT      : arena - arena to allocate from, or NULL
+              size  - number of bytes wanted
+@OUTPUT     :
+@RETURNS    : pointer to `size' bytes of zeroed memory
+@DESCRIPTION: Allocates memory from an arena; it can't be freed on its
+              own, only along with the whole arena.  If `arena' is NULL,
+              just falls back to calloc(), so callers can use the same
+              code whether or not an arena is in use.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void * bt_arena_alloc (bt_arena * arena, size_t size)
+{
+   void * p;
+
+   if (arena == NULL)
+      return calloc (1, size);
+
+   p = arena_get (arena, size);
+   memset (p, 0, size);
+   return p;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_arena_strdup()
+@INPUT      : arena - arena to allocate from, or NULL
+              s     - string to copy
+@OUTPUT     :
+@RETURNS    : a copy of `s' (or NULL if `s' is NULL)
+@DESCRIPTION: Like strdup(), but the copy lives in `arena'.  As with
+              bt_arena_alloc(), a NULL arena means use the ordinary heap.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+char * bt_arena_strdup (bt_arena * arena, const char * s)
+{
+   size_t  len;
+   char *  copy;
+
+   if (s == NULL)
+      return NULL;
+   if (arena == NULL)
+      return strdup (s);
+
+   len = strlen (s) + 1;
+   copy = (char *) arena_get (arena, len);
+   memcpy (copy, s, len);
+   return copy;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_set_arena()
+@INPUT      : arena - arena to use from now on (NULL to go back to
+                      ordinary malloc()/free() management)
+@OUTPUT     :
+@RETURNS    : the previously selected arena, so callers can restore it
+@DESCRIPTION: Selects the arena that AST nodes (and their text) built by
+              the current thread are allocated from.  Each thread has its
+              own selection.
+@GLOBALS    : CurrentArena
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+bt_arena * bt_set_arena (bt_arena * arena)
+{
+   bt_arena * previous = CurrentArena;
+
+   CurrentArena = arena;
+   return previous;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_get_arena()
+@INPUT      :
+@OUTPUT     :
+@RETURNS    : the current thread's arena (NULL if none selected)
+@GLOBALS    : CurrentArena
+@CALLERS    : zzastalloc() (ie. zzastnew() in pccts/ast.c)
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+bt_arena * bt_get_arena (void)
+{
+   return CurrentArena;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : set_ast_text()
+@INPUT      : node - AST node whose text is to be replaced
+              text - new text (or NULL), allocated where the node's own
+                     text would be: in node->arena if it has one (eg. with
+                     bt_arena_alloc (node->arena, ...)), else with malloc()
+@OUTPUT     : node->text
+@RETURNS    : the string now stored in the node
+@DESCRIPTION: Replaces the text of an AST node, taking ownership of
+              `text'.  For an ordinary node, the old text is freed; if
+              the node lives in an arena, it mustn't be (it goes away
+              with everything else).  If the old text was an atom (see
+              bt_intern()), it's left alone, and the node's text is no
+              longer an atom.
+@CALLERS    : bt_postprocess_value(), bt_set_text()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+char * set_ast_text (AST * node, char * text)
+{
+   if (node->arena == NULL && node->text != NULL && node->atom == 0)
+      free (node->text);
+   node->text = text;
+   node->atom = 0;
+   return node->text;
+}
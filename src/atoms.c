@@ -0,0 +1,319 @@
+/* ------------------------------------------------------------------------
+@NAME       : atoms.c
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: The atom table: a single, canonical, lowercase copy of each
+              field name and entry type, with a small integer ID.  The
+              parser interns these as it goes, so that every "author"
+              field in a big file shares the same text, and the AST node
+              records the ID (in its `atom' member) for quick comparison.
+              The names of the standard BibTeX entry types and fields are
+              always in the table, with the fixed IDs given by the
+              bt_atom_id enum in btparse.h.
+
+              There is one table for the whole process, shared by all
+              threads, and atoms are never freed.  Since the same few
+              dozen names make up almost all of the lookups, each thread
+              keeps a small cache of the atoms it has used recently, and
+              only goes to the (locked) table itself on a miss.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse library.  This library is
+              free software; you can redistribute it and/or modify it under
+              the terms of the GNU Library General Public License as
+              published by the Free Software Foundation; either version 2
+              of the License, or (at your option) any later version.
+-------------------------------------------------------------------------- */
+
+#include "bt_config.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <ctype.h>
+#if HAVE_PTHREAD_H && HAVE_LIBPTHREAD
+# include <pthread.h>
+# define USE_THREADS 1
+#else
+# define USE_THREADS 0
+#endif
+#include "btparse.h"
+#include "error.h"
+#include "my_dmalloc.h"
+
+
+#define INITIAL_SIZE     256            /* must be a power of 2 */
+#define ATOM_BLOCK_SIZE  8192           /* arena block size for atoms */
+#define CACHE_SIZE       64             /* per thread; a power of 2 */
+
+typedef struct
+{
+   unsigned int hash;
+   int          id;
+   char         text[1];                /* really as long as needed */
+} atom;
+
+/*
+ * The table proper is a hash table with open addressing (linear
+ * probing), as in macros.c, plus an array to go from ID to atom.  The
+ * atoms themselves live in an arena, so they never move.
+ */
+static struct
+{
+   atom **      slots;
+   unsigned int size;                   /* number of slots */
+   atom **      by_id;                  /* by_id[0] is unused */
+   int          num_ids;
+   int          alloc_ids;
+   bt_arena *   arena;
+} Atoms = { NULL, 0, NULL, 0, 0, NULL };
+
+#if USE_THREADS
+static pthread_mutex_t AtomLock = PTHREAD_MUTEX_INITIALIZER;
+# define LOCK_ATOMS()   pthread_mutex_lock (&AtomLock)
+# define UNLOCK_ATOMS() pthread_mutex_unlock (&AtomLock)
+#else
+# define LOCK_ATOMS()
+# define UNLOCK_ATOMS()
+#endif
+
+static BT_THREAD_LOCAL atom * AtomCache[CACHE_SIZE];
+
+/* Must be in the same order as the bt_atom_id enum. */
+static char * PredefinedAtoms[] =
+{
+   "article", "book", "booklet", "conference", "inbook", "incollection",
+   "inproceedings", "manual", "mastersthesis", "misc", "phdthesis",
+   "proceedings", "techreport", "unpublished",
+   "comment", "preamble", "string",
+   "address", "annote", "author", "booktitle", "chapter", "crossref",
+   "edition", "editor", "howpublished", "institution", "journal", "key",
+   "month", "note", "number", "organization", "pages", "publisher",
+   "school", "series", "title", "type", "volume", "year"
+};
+
+
+/* ------------------------------------------------------------------------
+@NAME       : hash_name()
+@INPUT      : name
+@OUTPUT     :
+@RETURNS    : hash value of `name', ignoring case
+@DESCRIPTION: FNV-1a hash of the lowercased name (as in macros.c).
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static unsigned int
+hash_name (const char * name)
+{
+   unsigned int  hash = 2166136261U;
+
+   while (*name)
+   {
+      hash ^= (unsigned char) tolower ((unsigned char) *name++);
+      hash *= 16777619U;
+   }
+   return hash;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : find_slot()
+@INPUT      : name
+              hash - hash_name (name)
+@OUTPUT     :
+@RETURNS    : the slot holding `name', or the empty slot where it would go
+@GLOBALS    : Atoms (must be locked)
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static atom **
+find_slot (const char * name, unsigned int hash)
+{
+   unsigned int mask = Atoms.size - 1;
+   unsigned int i;
+
+   for (i = hash & mask; Atoms.slots[i] != NULL; i = (i + 1) & mask)
+   {
+      if (Atoms.slots[i]->hash == hash &&
+          strcasecmp (Atoms.slots[i]->text, name) == 0)
+         break;
+   }
+   return &Atoms.slots[i];
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : grow_table()
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Doubles the size of the hash table (or creates it).
+@GLOBALS    : Atoms (must be locked)
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+grow_table (void)
+{
+   atom **      old_slots = Atoms.slots;
+   unsigned int old_size = Atoms.size;
+   unsigned int i;
+
+   Atoms.size = (old_size > 0) ? old_size * 2 : INITIAL_SIZE;
+   Atoms.slots = (atom **) calloc (Atoms.size, sizeof (atom *));
+   if (Atoms.slots == NULL)
+      internal_error ("out of memory growing atom table");
+   for (i = 0; i < old_size; i++)
+   {
+      if (old_slots[i] != NULL)
+         *find_slot (old_slots[i]->text, old_slots[i]->hash) = old_slots[i];
+   }
+   if (old_slots)
+      free (old_slots);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : new_atom()
+@INPUT      : name
+              hash - hash_name (name)
+              slot - where it goes, from find_slot()
+@OUTPUT     :
+@RETURNS    : the new atom
+@DESCRIPTION: Adds a lowercased copy of `name' to the table, with the
+              next free ID.
+@GLOBALS    : Atoms (must be locked)
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static atom *
+new_atom (const char * name, unsigned int hash, atom ** slot)
+{
+   atom *  new;
+   size_t  len;
+   size_t  i;
+
+   len = strlen (name);
+   new = (atom *) bt_arena_alloc (Atoms.arena,
+                                  offsetof (atom, text) + len + 1);
+   for (i = 0; i < len; i++)
+      new->text[i] = tolower ((unsigned char) name[i]);
+   new->hash = hash;
+
+   if (Atoms.num_ids + 1 >= Atoms.alloc_ids)
+   {
+      Atoms.alloc_ids = (Atoms.alloc_ids > 0) ? Atoms.alloc_ids * 2 : 256;
+      Atoms.by_id = (atom **)
+         realloc (Atoms.by_id, Atoms.alloc_ids * sizeof (atom *));
+      if (Atoms.by_id == NULL)
+         internal_error ("out of memory growing atom table");
+   }
+   new->id = ++Atoms.num_ids;
+   Atoms.by_id[new->id] = new;
+
+   *slot = new;
+   if (2 * (unsigned int) Atoms.num_ids > Atoms.size)
+      grow_table ();
+   return new;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : init_atoms()
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Sets up the table with the predefined atoms, if that
+              hasn't been done yet.
+@GLOBALS    : Atoms (must be locked)
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+init_atoms (void)
+{
+   unsigned int hash;
+   size_t       i;
+
+   if (Atoms.slots != NULL)
+      return;
+
+   Atoms.arena = bt_arena_new (ATOM_BLOCK_SIZE);
+   grow_table ();
+   for (i = 0; i < sizeof (PredefinedAtoms) / sizeof (char *); i++)
+   {
+      hash = hash_name (PredefinedAtoms[i]);
+      new_atom (PredefinedAtoms[i], hash,
+                find_slot (PredefinedAtoms[i], hash));
+   }
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_intern()
+@INPUT      : name - a field name or entry type (any case)
+@OUTPUT     : *id  - (if not NULL) the atom's ID
+@RETURNS    : the canonical, lowercase copy of `name', which mustn't be
+              modified or freed
+@DESCRIPTION: Finds `name' in the atom table, adding it if it's not
+              already there.  Names that differ only in case are the
+              same atom, so two names are the same (ignoring case) iff
+              bt_intern() returns the same pointer (and ID) for both.
+@GLOBALS    : Atoms, AtomCache
+@CALLS      :
+@CALLERS    : zzcr_ast() (for field names and entry types)
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+char * bt_intern (const char * name, int * id)
+{
+   unsigned int hash;
+   atom **      cached;
+   atom **      slot;
+   atom *       found;
+
+   hash = hash_name (name);
+   cached = &AtomCache[hash & (CACHE_SIZE - 1)];
+   if (*cached != NULL && (*cached)->hash == hash &&
+       strcasecmp ((*cached)->text, name) == 0)
+   {
+      found = *cached;
+   }
+   else
+   {
+      LOCK_ATOMS ();
+      init_atoms ();
+      slot = find_slot (name, hash);
+      found = (*slot != NULL) ? *slot : new_atom (name, hash, slot);
+      UNLOCK_ATOMS ();
+      *cached = found;
+   }
+
+   if (id) *id = found->id;
+   return found->text;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_atom_text()
+@INPUT      : id - an atom ID (from bt_intern(), an AST node's `atom'
+                   member, or the bt_atom_id enum)
+@OUTPUT     :
+@RETURNS    : the atom's text, or NULL if there's no such atom
+@GLOBALS    : Atoms
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+char * bt_atom_text (int id)
+{
+   char *  text = NULL;
+
+   LOCK_ATOMS ();
+   init_atoms ();
+   if (id > 0 && id <= Atoms.num_ids)
+      text = Atoms.by_id[id]->text;
+   UNLOCK_ATOMS ();
+   return text;
+}
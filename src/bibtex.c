@@ -12,6 +12,7 @@
 #define ZZCOL
 #define USER_ZZSYN
 
+#include "bt_config.h"
 #include "config.h"
 #include "btparse.h"
 #include "attrib.h"
@@ -19,7 +20,11 @@
 #include "error.h"
 #include "my_dmalloc.h"
 
-extern char * InputFilename;            /* for zzcr_ast call in pccts/ast.c */
+extern BT_THREAD_LOCAL char * InputFilename; /* for zzcr_ast in pccts/ast.c */
+extern BT_THREAD_LOCAL boolean SkippingField; /* ditto (parse_auxiliary.c) */
+extern BT_THREAD_LOCAL boolean InterningName; /* ditto */
+void  check_field_name (AST * field); /* parse_auxiliary.c */
+AST * new_value_node (Attrib * attr, int tok, bt_nodetype nodetype);
 #define GENAST
 
 #include "ast.h"
@@ -90,6 +95,7 @@ AST **_root;
 	{
 	bt_metatype metatype;   
 	zzmatch(AT);  zzCONSUME;
+	InterningName = TRUE;   
 	zzmatch(NAME); zzsubroot(_root, &_sibling, &_tail);
 	
 	metatype = entry_metatype();
@@ -253,6 +259,7 @@ AST **_root;
 	zzBLOCK(zztasp1);
 	zzMake0;
 	{
+	InterningName = TRUE;   
 	zzmatch(NAME); zzsubroot(_root, &_sibling, &_tail);
 	zzastArg(1)->nodetype = BTAST_FIELD; check_field_name (zzastArg(1));   
  zzCONSUME;
@@ -265,6 +272,12 @@ AST **_root;
 	"       first val = %p (%s)\n",
 	zzastArg(1)->text, zzastArg(1)->text, zzastArg(2)->text, zzastArg(2)->text);
 #endif
+	if (SkippingField)      /* not wanted: throw it away */
+	{
+		SkippingField = FALSE;
+		bt_free_ast ((*_root));
+		(*_root) = NULL;
+	}
 	zzEXIT(zztasp1);
 	return;
 fail:
@@ -321,22 +334,22 @@ AST **_root;
 	zzMake0;
 	{
 	if ( (LA(1)==STRING) ) {
-		zzmatch(STRING); zzsubchild(_root, &_sibling, &_tail);
-		zzastArg(1)->nodetype = BTAST_STRING;   
+		zzmatch(STRING); 
+		(*_root) = new_value_node (&zzaArg(zztasp1,1 ), STRING, BTAST_STRING);   
  zzCONSUME;
 
 	}
 	else {
 		if ( (LA(1)==NUMBER) ) {
-			zzmatch(NUMBER); zzsubchild(_root, &_sibling, &_tail);
-			zzastArg(1)->nodetype = BTAST_NUMBER;   
+			zzmatch(NUMBER); 
+			(*_root) = new_value_node (&zzaArg(zztasp1,1 ), NUMBER, BTAST_NUMBER);   
  zzCONSUME;
 
 		}
 		else {
 			if ( (LA(1)==NAME) ) {
-				zzmatch(NAME); zzsubchild(_root, &_sibling, &_tail);
-				zzastArg(1)->nodetype = BTAST_MACRO;   
+				zzmatch(NAME); 
+				(*_root) = new_value_node (&zzaArg(zztasp1,1 ), NAME, BTAST_MACRO);   
  zzCONSUME;
 
 			}
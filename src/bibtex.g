@@ -61,6 +61,7 @@
 #define ZZCOL
 #define USER_ZZSYN
 
+#include "bt_config.h"
 #include "config.h"
 #include "btparse.h"
 #include "attrib.h"
@@ -68,7 +69,11 @@
 #include "error.h"
 #include "my_dmalloc.h"
 
-extern char * InputFilename;            /* for zzcr_ast call in pccts/ast.c */
+extern BT_THREAD_LOCAL char * InputFilename; /* for zzcr_ast in pccts/ast.c */
+extern BT_THREAD_LOCAL boolean SkippingField; /* ditto (parse_auxiliary.c) */
+extern BT_THREAD_LOCAL boolean InterningName; /* ditto */
+void  check_field_name (AST * field); /* parse_auxiliary.c */
+AST * new_value_node (Attrib * attr, int tok, bt_nodetype nodetype);
 >>
 
 /*
@@ -332,7 +337,7 @@ bibfile!     : << AST *last; #0 = NULL; >>
  * semantic predicates) to select amongst the various syntax options.
  */
 entry        : << bt_metatype metatype; >>
-               AT! NAME^
+               AT! << InterningName = TRUE; >> NAME^
                <<
                   metatype = entry_metatype();
                   #1->nodetype = BTAST_ENTRY;
@@ -390,8 +395,16 @@ fields       : field { COMMA! fields }
              | /* epsilon */
              ;
 
-/* `field' recognizes a single "field = value" assignment. */
-field        : NAME^
+/*
+ * `field' recognizes a single "field = value" assignment.  If the field
+ * isn't one of those selected by bt_select_fields(), check_field_name()
+ * sets SkippingField, so no nodes are built for the value; and then the
+ * field's own node is discarded once it's been parsed.  The field name (like
+ * the entry type, in `entry') is interned rather than copied: that's
+ * what setting InterningName does.
+ */
+field        : << InterningName = TRUE; >>
+               NAME^
                << #1->nodetype = BTAST_FIELD; check_field_name (#1); >>
                EQUALS! value
                << 
@@ -400,14 +413,24 @@ field        : NAME^
                           "       first val = %p (%s)\n",
                           #1->text, #1->text, #2->text, #2->text);
 #endif
+                  if (SkippingField)      /* not wanted: throw it away */
+                  {
+                     SkippingField = FALSE;
+                     bt_free_ast (#0);
+                     #0 = NULL;
+                  }
                >>
              ;
 
 /* `value' is a sequence of simple_values, joined by the '#' operator. */
 value        : simple_value ( HASH! simple_value )* ;
 
-/* `simple_value' is a single string, number, or macro invocation. */
-simple_value : STRING      << #1->nodetype = BTAST_STRING; >>
-             | NUMBER      << #1->nodetype = BTAST_NUMBER; >>
-             | NAME        << #1->nodetype = BTAST_MACRO; >>
+/*
+ * `simple_value' is a single string, number, or macro invocation.  Its
+ * node is made by hand (see new_value_node()), so that none is made in
+ * a field that's being skipped.
+ */
+simple_value : STRING!     << #0 = new_value_node (&$1, STRING, BTAST_STRING); >>
+             | NUMBER!     << #0 = new_value_node (&$1, NUMBER, BTAST_NUMBER); >>
+             | NAME!       << #0 = new_value_node (&$1, NAME, BTAST_MACRO); >>
              ;
@@ -1,6 +1,9 @@
 /* src/bt_config.h.  Generated by configure.  */
 /* src/bt_config.h.in.  Generated from configure.ac by autoheader.  */
 
+/* Define to keep the counters and timings for bt_get_stats() */
+/* #undef BT_STATS */
+
 /* Define to one of `_getb67', `GETB67', `getb67' for Cray-2 and Cray-YMP
    systems. This function is required for `alloca.c' support on those systems.
    */
@@ -25,15 +28,27 @@
 /* Define to 1 if you don't have `vprintf' but do have `_doprnt.' */
 /* #undef HAVE_DOPRNT */
 
+/* Define to 1 if you have the <fcntl.h> header file. */
+#define HAVE_FCNTL_H 1
+
 /* Define to 1 if you have the <inttypes.h> header file. */
 #define HAVE_INTTYPES_H 1
 
+/* Define to 1 if you have the `pthread' library (-lpthread). */
+#define HAVE_LIBPTHREAD 1
+
 /* Define to 1 if you have the <limits.h> header file. */
 #define HAVE_LIMITS_H 1
 
 /* Define to 1 if you have the <memory.h> header file. */
 #define HAVE_MEMORY_H 1
 
+/* Define to 1 if you have the `mmap' function. */
+#define HAVE_MMAP 1
+
+/* Define to 1 if you have the <pthread.h> header file. */
+#define HAVE_PTHREAD_H 1
+
 /* Define to 1 if you have the <stdint.h> header file. */
 #define HAVE_STDINT_H 1
 
@@ -58,6 +73,12 @@
 /* Define to 1 if you have the `strupr' function. */
 /* #undef HAVE_STRUPR */
 
+/* Define to 1 if you have the `sysconf' function. */
+#define HAVE_SYSCONF 1
+
+/* Define to 1 if you have the <sys/mman.h> header file. */
+#define HAVE_SYS_MMAN_H 1
+
 /* Define to 1 if you have the <sys/stat.h> header file. */
 #define HAVE_SYS_STAT_H 1
 
@@ -113,3 +134,21 @@
 
 /* Define to empty if `const' does not conform to ANSI C. */
 /* #undef const */
+
+/* Storage class for the lexer, parser, error and macro-table state that
+   btparse keeps in global variables: each thread gets its own copy, so
+   separate threads may parse separate inputs at the same time.  Define
+   BT_THREAD_LOCAL to nothing (e.g. with -DBT_THREAD_LOCAL=) to go back
+   to plain globals on a compiler that chokes on this. */
+#ifndef BT_THREAD_LOCAL
+# if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#  define BT_THREAD_LOCAL _Thread_local
+# elif defined(__GNUC__)
+#  define BT_THREAD_LOCAL __thread
+# elif defined(_MSC_VER)
+#  define BT_THREAD_LOCAL __declspec(thread)
+# else
+#  define BT_THREAD_LOCAL
+# endif
+#endif
+#define zzTHREAD_LOCAL BT_THREAD_LOCAL
@@ -73,6 +73,7 @@ typedef int boolean;
 #define BTO_COLLAPSE  8                 /* collapse whitespace? */
 
 #define BTO_NOSTORE   16
+#define BTO_LAZY      32                /* postprocess fields when used */
 
 #define BTO_FULL (BTO_CONVERT | BTO_EXPAND | BTO_PASTE | BTO_COLLAPSE)
 #define BTO_MACRO (BTO_CONVERT | BTO_EXPAND | BTO_PASTE)
@@ -98,6 +99,28 @@ typedef enum
 
 #define NUM_METATYPES ((int) BTE_MACRODEF + 1)
 
+/*
+ * IDs of the atoms that are always in the atom table (see bt_intern()):
+ * the names of the standard entry types, the special entry types, and
+ * the standard fields.  Other names get IDs from BTA_NUM_PREDEFINED up,
+ * in the order they're first seen.
+ */
+typedef enum
+{
+   BTA_NONE,                            /* not an atom */
+   BTA_ARTICLE, BTA_BOOK, BTA_BOOKLET, BTA_CONFERENCE, BTA_INBOOK,
+   BTA_INCOLLECTION, BTA_INPROCEEDINGS, BTA_MANUAL, BTA_MASTERSTHESIS,
+   BTA_MISC, BTA_PHDTHESIS, BTA_PROCEEDINGS, BTA_TECHREPORT,
+   BTA_UNPUBLISHED,
+   BTA_COMMENT, BTA_PREAMBLE, BTA_STRING,
+   BTA_ADDRESS, BTA_ANNOTE, BTA_AUTHOR, BTA_BOOKTITLE, BTA_CHAPTER,
+   BTA_CROSSREF, BTA_EDITION, BTA_EDITOR, BTA_HOWPUBLISHED,
+   BTA_INSTITUTION, BTA_JOURNAL, BTA_KEY, BTA_MONTH, BTA_NOTE, BTA_NUMBER,
+   BTA_ORGANIZATION, BTA_PAGES, BTA_PUBLISHER, BTA_SCHOOL, BTA_SERIES,
+   BTA_TITLE, BTA_TYPE, BTA_VOLUME, BTA_YEAR,
+   BTA_NUM_PREDEFINED
+} bt_atom_id;
+
 typedef enum
 {
    BTAST_BOGUS,                           /* to detect uninitialized nodes */
@@ -125,18 +148,40 @@ typedef enum
 
 #define USER_DEFINED_AST 1
 
+/*
+ * AST nodes (and their text) normally come from malloc(); if the thread
+ * has selected an arena with bt_set_arena(), they come from that instead,
+ * and each node remembers which arena it's in so that it isn't freed on
+ * its own.  (NULL `arena' arguments mean "use the heap".)  The text of
+ * field names and entry types is different: it's an atom (see
+ * bt_intern()), shared by all nodes with the same name, and is never
+ * freed; `atom' is its ID (0 for ordinary text).
+ */
+typedef struct bt_arena_s bt_arena;
+
+#define zzastalloc()                            \
+   ((AST *) bt_arena_alloc (bt_get_arena (), sizeof (AST)))
+#define zzastdealloc(ast)                       \
+   if ((ast)->arena == NULL) free (ast);
+
 #define zzcr_ast(ast,attr,tok,txt)              \
 {                                               \
    (ast)->filename = InputFilename;             \
    (ast)->line = (attr)->line;                  \
    (ast)->offset = (attr)->offset;              \
-   (ast)->text = strdup ((attr)->text);         \
+   (ast)->arena = bt_get_arena ();              \
+   if (InterningName && (tok) == NAME)          \
+      (ast)->text = bt_intern ((attr)->text, &(ast)->atom); \
+   else                                         \
+      (ast)->text = bt_arena_strdup ((ast)->arena, (attr)->text); \
+   InterningName = FALSE;                       \
 }
 
 #define zzd_ast(ast)                            \
 /* printf ("zzd_ast: free'ing ast node with string %p (%s)\n", \
            (ast)->text, (ast)->text); */ \
-   if ((ast)->text != NULL) free ((ast)->text);
+   if ((ast)->arena == NULL && (ast)->atom == 0 && (ast)->text != NULL) \
+      free ((ast)->text);
 
 
 #ifdef USER_DEFINED_AST
@@ -145,10 +190,14 @@ typedef struct _ast
    struct _ast *right, *down;
    char *           filename;
    int              line;
-   int              offset;
+   int              offset;              /* -1 if unknown (past INT_MAX) */
    bt_nodetype    nodetype;
    bt_metatype    metatype;
    char *           text;
+   bt_arena *       arena;               /* NULL if on the heap */
+   int              atom;                /* ID of interned text, or 0 */
+   ushort           pending;             /* postprocessing still to do */
+   ushort           changed;             /* differs from the source text */
 } AST;
 #endif /* USER_DEFINED_AST */
 
@@ -210,6 +259,94 @@ typedef struct
 } bt_name_format;
 
 
+/*
+ * A parser reads a sequence of entries from one input; its innards are
+ * private to input.c.  See bt_parser_new().
+ */
+typedef struct bt_parser_s bt_parser;
+
+/*
+ * Called by bt_process_file() for each entry; returns a combination of
+ * these flags to say what to do next.
+ */
+typedef int (*bt_entry_callback) (AST * entry, boolean status, void * data);
+
+#define BTCB_FREE     0                 /* free entry and carry on */
+#define BTCB_KEEP     1                 /* callback keeps (and frees) entry */
+#define BTCB_STOP     2                 /* stop reading the file */
+
+/*
+ * Where bt_scan_buffer() found an entry, and what it is.  `type' and
+ * `key' point into the text being scanned, and aren't null-terminated.
+ */
+typedef struct
+{
+   const char *   type;                 /* entry type, as written */
+   size_t         type_len;
+   bt_metatype    metatype;
+   const char *   key;                  /* NULL if not a regular entry */
+   size_t         key_len;
+   size_t         offset;               /* of the `@' */
+   size_t         length;               /* up to and including closer */
+   int            line;                 /* line number of the `@' */
+} bt_entry_span;
+
+/* Called by bt_scan_buffer() for each entry; returns 0 or BTCB_STOP. */
+typedef int (*bt_span_callback) (bt_entry_span * span, void * data);
+
+/*
+ * An entry flattened into a single block of memory by bt_entry_compact():
+ * this header, then the offsets of the field names and of the field
+ * values, then all the text.  Offsets are relative to the start of the
+ * text, and offset 0 is an empty string.
+ */
+typedef struct
+{
+   bt_metatype    metatype;
+   int            line;
+   int            num_fields;
+   unsigned int   size;                 /* of the whole block, in bytes */
+   unsigned int   type;                 /* offset of entry type */
+   unsigned int   key;                  /* offset of key (0 if none) */
+   unsigned int   fields[1];            /* really 2 * num_fields */
+} bt_compact_entry;
+
+#define bt_compact_text(c)    ((char *) &(c)->fields[2 * (c)->num_fields])
+#define bt_compact_name(c,i)  (bt_compact_text (c) + (c)->fields[i])
+#define bt_compact_value(c,i) \
+   (bt_compact_text (c) + (c)->fields[(c)->num_fields + (i)])
+
+/* A map from key to entry; see bt_forest_index(). */
+typedef struct bt_keymap_s bt_keymap;
+
+/* An on-disk index of a file's entries; see bt_index_open(). */
+typedef struct bt_index_s bt_index;
+
+/* Writes entries back out as BibTeX; see bt_writer_new(). */
+typedef struct bt_writer_s bt_writer;
+
+/* Clusters of probable duplicate entries; see bt_find_duplicates(). */
+typedef struct bt_dupmap_s bt_dupmap;
+
+/*
+ * What the parser has done in this thread since the last
+ * bt_reset_stats(); see bt_get_stats().  Times are in seconds.
+ */
+typedef struct
+{
+   unsigned long  bytes_lexed;
+   unsigned long  tokens;
+   unsigned long  entries[NUM_METATYPES]; /* parsed OK or not, by metatype */
+   unsigned long  macro_lookups;
+   unsigned long  macro_hits;           /* lookups that found the macro */
+   unsigned long  strings_pasted;       /* compound values pasted together */
+   unsigned long  lex_reallocs;         /* lexical buffer reallocations */
+   unsigned long  ast_nodes;            /* AST nodes allocated */
+   double         parse_time;           /* lexing and parsing */
+   double         postprocess_time;
+} bt_stats;
+
+
 typedef enum
 {
    BTERR_NOTIFY,                /* notification about next action */
@@ -237,6 +374,7 @@ typedef struct
    char *      item_desc;
    int         item;
    char *      message;
+   int         offset;                  /* in the input, or -1 if unknown */
 } bt_error;
 
 typedef void (*bt_err_handler) (bt_error *);
@@ -271,18 +409,44 @@ extern char *strdup (const char *s);
 #endif
 
 
-/* init.c */
+/*
+ * init.c.  The macro table is per-thread (so are the error counts and the
+ * kept lexical buffer): macros defined in one thread aren't seen by any
+ * other, and every thread that parses or defines macros must call
+ * bt_cleanup() before it exits, or its table leaks.
+ */
 void  bt_initialize (void);
 void  bt_free_ast (AST *ast);
 void  bt_cleanup (void);
 
+/* arena.c */
+bt_arena * bt_arena_new    (size_t block_size);
+void       bt_arena_free   (bt_arena * arena);
+void *     bt_arena_alloc  (bt_arena * arena, size_t size);
+char *     bt_arena_strdup (bt_arena * arena, const char * s);
+bt_arena * bt_set_arena    (bt_arena * arena);
+bt_arena * bt_get_arena    (void);
+
+/* atoms.c */
+char * bt_intern    (const char * name, int * id);
+char * bt_atom_text (int id);
+
 /* input.c */
 void    bt_set_stringopts (bt_metatype metatype, ushort options);
+void    bt_select_fields (char ** fields);
 AST * bt_parse_entry_s (char *    entry_text,
                         char *    filename,
                         int       line,
                         ushort    options,
                         boolean * status);
+size_t bt_parse_entries_s (const char **  texts,
+                           const size_t * lens,
+                           size_t         n,
+                           char *         filename,
+                           int            line,
+                           ushort         options,
+                           AST **         entries,
+                           boolean *      statuses);
 AST * bt_parse_entry   (FILE *    infile,
                         char *    filename,
                         ushort    options,
@@ -290,6 +454,110 @@ AST * bt_parse_entry   (FILE *    infile,
 AST * bt_parse_file    (char *    filename,
                         ushort    options,
                         boolean * overall_status);
+boolean bt_process_file (char *            filename,
+                         ushort            options,
+                         bt_entry_callback callback,
+                         void *            data);
+AST * bt_parse_file_mmap (char *    filename,
+                          ushort    options,
+                          boolean * overall_status);
+AST * bt_parse_buffer  (const char * buf,
+                        size_t       len,
+                        char *       filename,
+                        ushort       options,
+                        boolean *    overall_status);
+bt_parser * bt_parser_new (FILE * infile, char * filename);
+bt_parser * bt_parser_new_buffer (const char * buf,
+                                  size_t       len,
+                                  char *       filename);
+AST * bt_parser_parse_entry (bt_parser * parser,
+                             ushort      options,
+                             boolean *   status);
+void  bt_parser_free   (bt_parser * parser);
+void  bt_parser_queue_errors (bt_parser * parser, int max_per_class);
+bt_error * bt_parser_errors (bt_parser * parser,
+                             int *       num_errors,
+                             int *       num_dropped);
+void  bt_parser_clear_errors (bt_parser * parser);
+
+/* parallel.c */
+AST * bt_parse_buffer_parallel (const char * buf,
+                                size_t       len,
+                                char *       filename,
+                                ushort       options,
+                                boolean *    overall_status,
+                                int          num_threads);
+AST * bt_parse_file_parallel (char *    filename,
+                              ushort    options,
+                              boolean * overall_status,
+                              int       num_threads);
+
+/* scan_entries.c */
+int   bt_scan_buffer (const char *     buf,
+                      size_t           len,
+                      bt_span_callback callback,
+                      void *           data,
+                      boolean *        status);
+int   bt_scan_file   (char *           filename,
+                      bt_span_callback callback,
+                      void *           data,
+                      boolean *        status);
+
+/* compact.c */
+bt_compact_entry * bt_entry_compact (AST * entry);
+
+/* index.c */
+bt_keymap * bt_forest_index (AST * entries);
+AST * bt_keymap_find   (bt_keymap * map, char * key);
+int   bt_keymap_find_keys (bt_keymap * map,
+                           char **     keys,
+                           int         num_keys,
+                           AST **      found);
+int   bt_keymap_duplicates (bt_keymap * map, AST *** dups);
+void  bt_keymap_free   (bt_keymap * map);
+boolean bt_index_build (char * filename, char * indexfile);
+bt_index * bt_index_open (char * filename, char * indexfile);
+AST * bt_index_lookup  (bt_index * index,
+                        char *     key,
+                        ushort     options,
+                        boolean *  status);
+void  bt_index_close   (bt_index * index);
+
+/* cache.c */
+boolean bt_forest_save (AST * entries, char * path);
+AST * bt_forest_load   (char * path, bt_arena ** arena);
+AST * bt_parse_file_cached (char *      filename,
+                            char *      cachefile,
+                            ushort      options,
+                            boolean *   status,
+                            bt_arena ** arena);
+
+/* writer.c */
+bt_writer * bt_writer_new (FILE * stream);
+void  bt_writer_set_quote  (bt_writer * writer, char quote);
+void  bt_writer_set_indent (bt_writer * writer, int indent);
+void  bt_writer_set_order  (bt_writer * writer, char ** fields);
+void  bt_writer_set_source (bt_writer * writer,
+                            const char * buf,
+                            size_t       len);
+void  bt_write_entry   (AST * entry, bt_writer * writer);
+void  bt_write_forest  (AST * entries, bt_writer * writer);
+boolean bt_writer_flush (bt_writer * writer);
+char * bt_writer_text  (bt_writer * writer, size_t * len);
+boolean bt_writer_free (bt_writer * writer);
+
+/* dedup.c */
+char * bt_entry_fingerprint (AST * entry);
+bt_dupmap * bt_find_duplicates (AST * entries, int num_threads);
+int   bt_dupmap_clusters (bt_dupmap * map);
+int   bt_dupmap_cluster  (bt_dupmap * map,
+                          int         num,
+                          AST ***     entries,
+                          char **     fingerprint);
+void  bt_dupmap_free     (bt_dupmap * map);
+
+/* lex_auxiliary.c */
+void  bt_keep_lex_buffer (boolean keep);
 
 /* post_parse.c */
 void bt_postprocess_string (char * s, ushort options);
@@ -303,6 +571,10 @@ int    bt_get_error_count (bt_errclass errclass);
 int *  bt_get_error_counts (int *counts);
 ushort bt_error_status (int *saved_counts);
 
+/* stats.c */
+boolean bt_get_stats (bt_stats * stats);
+void    bt_reset_stats (void);
+
 /* macros.c */
 void bt_add_macro_value (AST *assignment, ushort options);
 void bt_add_macro_text (char * macro, char * text, char * filename, int line);
@@ -323,6 +595,7 @@ AST *bt_next_value (AST *head,
                     bt_nodetype *nodetype,
                     char **text);
 char *bt_get_text (AST *node);
+char *bt_get_value (AST *node);
 
 /* modify.c */
 void bt_set_text (AST * node, char * new_text);
@@ -0,0 +1,721 @@
+/* ------------------------------------------------------------------------
+@NAME       : cache.c
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Saving a parsed forest of entries to a binary cache file,
+              and loading it back without parsing anything.
+
+              The cache file is a header, a table of AST nodes, a table
+              of macros (those that the forest's @string entries
+              define, as they stood when it was saved), and a blob of
+              null-terminated strings.  In the
+              file, the nodes' pointers are really offsets: `right' and
+              `down' are node numbers plus one, and `text' and
+              `filename' are string offsets plus one (0 being NULL in
+              both cases).  Loading maps the file privately and turns
+              the offsets back into pointers in place, so the nodes and
+              their text live in the mapping itself; the mapping belongs
+              to an arena, and goes away when that arena is freed.
+
+              The nodes are stored as this machine's AST structures, so
+              a cache is only good on the kind of machine that wrote it;
+              the header records enough (byte order, structure sizes) to
+              spot a foreign cache, which just looks stale.  For
+              bt_parse_file_cached(), the header also records what the
+              cache was made from: the size, modification time, and a
+              hash of the source file, the string options in effect, and
+              a hash of the macro table before parsing (since macros the
+              file uses without defining are expanded into the nodes).
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse library.  This library is
+              free software; you can redistribute it and/or modify it under
+              the terms of the GNU Library General Public License as
+              published by the Free Software Foundation; either version 2
+              of the License, or (at your option) any later version.
+-------------------------------------------------------------------------- */
+
+#include "bt_config.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if HAVE_STDINT_H
+# include <stdint.h>
+#elif HAVE_INTTYPES_H
+# include <inttypes.h>
+#endif
+#include "btparse.h"
+#include "error.h"
+#include "prototypes.h"
+#include "my_dmalloc.h"
+
+
+#define CACHE_MAGIC      "btforst"      /* 8 bytes, with the NUL */
+#define CACHE_VERSION    3
+#define CACHE_BYTE_ORDER 0x01020304     /* to spot foreign caches */
+#define NUM_OPTIONS      8              /* caller's, then per metatype */
+
+typedef struct
+{
+   uint64_t     source_size;            /* of the file parsed ... */
+   int64_t      source_mtime;           /* ... when it was changed ... */
+   uint64_t     source_hash;            /* ... and its contents */
+   uint64_t     fields_hash;            /* bt_select_fields(), or 0 */
+   uint64_t     macros_hash;            /* macros beforehand, or 0 */
+   uint16_t     options[NUM_OPTIONS];   /* how it was parsed */
+} cache_key;
+
+typedef struct
+{
+   char         magic[8];
+   uint32_t     version;
+   uint32_t     byte_order;
+   uint32_t     ast_size;               /* sizeof (AST) */
+   uint32_t     pointer_size;
+   cache_key    key;                    /* all zero from bt_forest_save() */
+   uint32_t     status;                 /* of the parse */
+   uint32_t     reserved;
+   uint64_t     num_nodes;
+   uint64_t     num_macros;
+   uint64_t     strings_size;
+} cache_header;
+
+typedef struct
+{
+   uint64_t     name;                   /* string offsets, plus one */
+   uint64_t     text;
+} cache_macro;
+
+/* What bt_forest_save() builds up before writing it all out. */
+typedef struct
+{
+   AST *        nodes;
+   size_t       num_nodes;
+   char *       strings;
+   size_t       strings_size;
+   size_t       strings_alloc;
+   char *       last_filename;          /* filenames are nearly always */
+   uint64_t     last_filename_offset;   /* the same, so just one copy */
+} forest_saver;
+
+#define ENCODE(n)       ((void *) (uintptr_t) (n))
+#define DECODE(p)       ((uint64_t) (uintptr_t) (p))
+
+
+/* ------------------------------------------------------------------------
+@NAME       : add_string()
+@INPUT      : saver
+              s - string to add to the string blob (may be NULL)
+@OUTPUT     :
+@RETURNS    : offset of the copy, plus one (0 if `s' is NULL)
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static uint64_t
+add_string (forest_saver * saver, const char * s)
+{
+   size_t   len;
+   size_t   offset;
+
+   if (s == NULL)
+      return 0;
+   len = strlen (s) + 1;
+   if (saver->strings_size + len > saver->strings_alloc)
+   {
+      while (saver->strings_size + len > saver->strings_alloc)
+         saver->strings_alloc = saver->strings_alloc
+                                ? saver->strings_alloc * 2 : 65536;
+      saver->strings = (char *) realloc (saver->strings,
+                                         saver->strings_alloc);
+      if (saver->strings == NULL)
+         internal_error ("out of memory saving forest");
+   }
+   offset = saver->strings_size;
+   memcpy (saver->strings + offset, s, len);
+   saver->strings_size += len;
+   return (uint64_t) offset + 1;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : count_nodes()
+@INPUT      : node - first of a list of siblings
+@RETURNS    : number of nodes in the list and all their descendants
+@DESCRIPTION: Follows `right' pointers with a loop and `down' pointers
+              by recursion, since a forest can have millions of entries
+              side by side but is only a few levels deep.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static size_t
+count_nodes (AST * node)
+{
+   size_t   count = 0;
+
+   for ( ; node != NULL; node = node->right)
+      count += 1 + count_nodes (node->down);
+   return count;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : flatten_nodes()
+@INPUT      : saver
+              node - first of a list of siblings
+@OUTPUT     : saver->nodes - the list and its descendants added, in
+                             preorder, with their pointers encoded
+@RETURNS    : the number of the first node, plus one (0 if `node' is
+              NULL)
+@DESCRIPTION: Preorder means that a node's children and right siblings
+              always come after it in the table; bt_forest_load()
+              insists on that, so a damaged cache can't make a loop.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static uint64_t
+flatten_nodes (forest_saver * saver, AST * node)
+{
+   uint64_t  first = 0;
+   size_t    prev = 0;
+   size_t    num;
+   AST *     out;
+
+   for ( ; node != NULL; node = node->right)
+   {
+      num = saver->num_nodes++;
+      out = &saver->nodes[num];
+      memset (out, 0, sizeof (AST));
+      if (node->filename != saver->last_filename ||
+          saver->last_filename_offset == 0)
+      {
+         saver->last_filename = node->filename;
+         saver->last_filename_offset = add_string (saver, node->filename);
+      }
+      out->filename = (char *) ENCODE (saver->last_filename_offset);
+      out->text = (char *) ENCODE (add_string (saver, node->text));
+      out->line = node->line;
+      out->offset = node->offset;
+      out->nodetype = node->nodetype;
+      out->metatype = node->metatype;
+      out->atom = (node->atom != 0);    /* re-interned on loading */
+      out->pending = node->pending;
+      out->changed = node->changed;
+
+      if (first == 0)
+         first = num + 1;
+      else
+         saver->nodes[prev].right = (AST *) ENCODE (num + 1);
+      prev = num;
+
+      out->down = (AST *) ENCODE (flatten_nodes (saver, node->down));
+   }
+   return first;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : save_forest()
+@INPUT      : entries - list of entries to save
+              path    - cache file to write
+              key     - what the entries were parsed from (or NULL)
+              status  - status of that parse
+@OUTPUT     :
+@RETURNS    : FALSE if the file couldn't be written (after printing a
+              message); TRUE otherwise
+@DESCRIPTION: Lays out the whole cache in memory, then writes it to a
+              temporary file which replaces `path', as bt_index_build()
+              does.  The macros saved are just those defined by the
+              forest's own @string entries, with the text they have now;
+              whatever else the caller has in the macro table stays out
+              of it.
+@CALLS      : bt_next_macro(), macro_defined()
+@CALLERS    : bt_forest_save(), bt_parse_file_cached()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static boolean
+save_forest (AST *      entries,
+             char *     path,
+             cache_key * key,
+             boolean    status)
+{
+   forest_saver  saver;
+   cache_header  header;
+   cache_macro * macros;
+   size_t        num_macros, alloc_macros;
+   AST *         entry;
+   AST *         field;
+   char *        name;
+   char *        text;
+   char *        tmpname;
+   FILE *        out;
+   boolean       ok;
+
+   memset (&saver, 0, sizeof (saver));
+   saver.nodes = (AST *) malloc ((count_nodes (entries) + 1) * sizeof (AST));
+   if (saver.nodes == NULL)
+      internal_error ("out of memory saving forest");
+   flatten_nodes (&saver, entries);
+
+   num_macros = 0;
+   alloc_macros = 64;
+   macros = (cache_macro *) malloc (alloc_macros * sizeof (cache_macro));
+   init_macros ();
+   for (entry = entries; entry != NULL; entry = entry->right)
+   {
+      if (entry->metatype != BTE_MACRODEF)
+         continue;
+      field = NULL;
+      while ((field = bt_next_macro (entry, field, &name)) != NULL)
+      {
+         if (name == NULL || ! macro_defined (name, &text))
+            continue;                   /* eg. parsed with BTO_NOSTORE */
+         if (num_macros == alloc_macros)
+         {
+            alloc_macros *= 2;
+            macros = (cache_macro *)
+               realloc (macros, alloc_macros * sizeof (cache_macro));
+         }
+         if (macros == NULL)
+            internal_error ("out of memory saving forest");
+         macros[num_macros].name = add_string (&saver, name);
+         macros[num_macros].text = add_string (&saver, text);
+         num_macros++;
+      }
+   }
+
+   memset (&header, 0, sizeof (header));
+   memcpy (header.magic, CACHE_MAGIC, sizeof (header.magic));
+   header.version = CACHE_VERSION;
+   header.byte_order = CACHE_BYTE_ORDER;
+   header.ast_size = sizeof (AST);
+   header.pointer_size = sizeof (void *);
+   if (key != NULL)
+      header.key = *key;
+   header.status = status;
+   header.num_nodes = saver.num_nodes;
+   header.num_macros = num_macros;
+   header.strings_size = saver.strings_size;
+
+   tmpname = (char *) malloc (strlen (path) + 5);
+   sprintf (tmpname, "%s.tmp", path);
+   out = fopen (tmpname, "wb");
+   ok = (out != NULL);
+   if (ok)
+   {
+      ok = (fwrite (&header, sizeof (header), 1, out) == 1 &&
+            fwrite (saver.nodes, sizeof (AST),
+                    saver.num_nodes, out) == saver.num_nodes &&
+            fwrite (macros, sizeof (cache_macro),
+                    num_macros, out) == num_macros &&
+            fwrite (saver.strings, 1,
+                    saver.strings_size, out) == saver.strings_size);
+      ok &= (fclose (out) == 0);
+   }
+   if (ok)
+      ok = (rename (tmpname, path) == 0);
+   if (!ok)
+   {
+      perror (path);
+      remove (tmpname);
+   }
+
+   free (tmpname);
+   free (macros);
+   free (saver.nodes);
+   free (saver.strings);
+   return ok;
+
+} /* save_forest() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : load_forest()
+@INPUT      : path     - cache file to load
+              filename - where the macros were defined, for warnings
+                         about redefining them (NULL means the file the
+                         forest was parsed from, if known)
+              key      - what the cache must have been made from (or
+                         NULL if it doesn't matter)
+@OUTPUT     : *entries - the forest (NULL if it was empty)
+              *status  - status of the parse that made it
+              *arena   - the arena that the forest lives in
+@RETURNS    : FALSE if the cache is missing, stale, foreign, or damaged;
+              TRUE if the forest was loaded
+@DESCRIPTION: Maps the cache, checks it over, and fixes up the nodes:
+              pointers are restored (and checked, so a damaged cache
+              can't make us wander off into the weeds), node and entry
+              types are checked too (as is that every atom has a
+              name), each node is
+              given to the new arena, and field names and entry types
+              are interned again.  Then the macros saved with the forest
+              are defined, just as if the @string entries had been
+              parsed again.
+@CALLS      : map_file_private(), arena_own_map(), bt_intern(),
+              bt_add_macro_text()
+@CALLERS    : bt_forest_load(), bt_parse_file_cached()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static boolean
+load_forest (char *       path,
+             char *       filename,
+             cache_key *  key,
+             AST **       entries,
+             boolean *    status,
+             bt_arena **  arena)
+{
+   char *               map;
+   size_t               map_len;
+   const cache_header * header;
+   AST *                nodes;
+   const cache_macro *  macros;
+   char *               strings;
+   uint64_t             i, n;
+   AST *                node;
+   bt_arena *           own;
+
+   *entries = NULL;
+   if (! map_file_private (path, &map, &map_len))
+      return FALSE;
+
+   header = (const cache_header *) map;
+   if (map_len < sizeof (cache_header) ||
+       memcmp (header->magic, CACHE_MAGIC, sizeof (header->magic)) != 0 ||
+       header->version != CACHE_VERSION ||
+       header->byte_order != CACHE_BYTE_ORDER ||
+       header->ast_size != sizeof (AST) ||
+       header->pointer_size != sizeof (void *) ||
+       (key != NULL && memcmp (&header->key, key, sizeof (cache_key)) != 0))
+   {
+      unmap_file (map, map_len);
+      return FALSE;
+   }
+   if (header->num_nodes > map_len / sizeof (AST) ||
+       header->num_macros > map_len / sizeof (cache_macro) ||
+       map_len != sizeof (cache_header)
+                  + header->num_nodes * sizeof (AST)
+                  + header->num_macros * sizeof (cache_macro)
+                  + header->strings_size ||
+       (header->strings_size > 0 && map[map_len - 1] != (char) 0))
+   {
+      unmap_file (map, map_len);
+      return FALSE;
+   }
+
+   nodes = (AST *) (header + 1);
+   macros = (const cache_macro *) (nodes + header->num_nodes);
+   strings = (char *) (macros + header->num_macros) - 1; /* for offset+1 */
+   n = header->num_nodes;
+
+   own = bt_arena_new (0);
+   arena_own_map (own, map, map_len);
+
+#define BAD_NODE(p)    (DECODE (p) != 0 && (DECODE (p) <= i+1 || DECODE (p) > n))
+#define BAD_STRING(p)  (DECODE (p) > header->strings_size)
+#define BAD_TYPE(p)    ((p)->nodetype < BTAST_ENTRY || \
+                        (p)->nodetype > BTAST_MACRO || \
+                        (unsigned) (p)->metatype > BTE_MACRODEF)
+
+   for (i = 0; i < n; i++)
+   {
+      node = &nodes[i];
+      if (BAD_NODE (node->right) || BAD_NODE (node->down) ||
+          BAD_STRING (node->text) || BAD_STRING (node->filename) ||
+          BAD_TYPE (node) || (node->atom && node->text == NULL))
+      {
+         bt_arena_free (own);
+         return FALSE;
+      }
+      node->right = node->right ? &nodes[DECODE (node->right) - 1] : NULL;
+      node->down = node->down ? &nodes[DECODE (node->down) - 1] : NULL;
+      node->text = node->text ? strings + DECODE (node->text) : NULL;
+      node->filename = node->filename
+         ? strings + DECODE (node->filename) : NULL;
+      node->arena = own;
+      if (node->atom)
+         node->text = bt_intern (node->text, &node->atom);
+   }
+
+   if (filename == NULL)
+      filename = (n > 0 && nodes[0].filename) ? nodes[0].filename : path;
+   for (i = 0; i < header->num_macros; i++)
+   {
+      if (macros[i].name == 0 || BAD_STRING (macros[i].name) ||
+          BAD_STRING (macros[i].text))
+         continue;
+      bt_add_macro_text (strings + macros[i].name,
+                         macros[i].text ? strings + macros[i].text : NULL,
+                         filename, 0);
+   }
+
+#undef BAD_NODE
+#undef BAD_STRING
+#undef BAD_TYPE
+
+   if (status) *status = (boolean) header->status;
+   *entries = (n > 0) ? nodes : NULL;
+   *arena = own;
+   return TRUE;
+
+} /* load_forest() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : hand_over()
+@INPUT      : own   - the arena a forest was loaded (or parsed) into
+              arena - where the caller wants it (NULL means adopt it
+                      into the current arena)
+@OUTPUT     : *arena
+@CALLS      : arena_adopt()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+hand_over (bt_arena * own, bt_arena ** arena)
+{
+   if (arena != NULL)
+      *arena = own;
+   else
+      arena_adopt (bt_get_arena (), own);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_forest_save()
+@INPUT      : entries - list of entries (eg. from bt_parse_file())
+              path    - cache file to write
+@OUTPUT     :
+@RETURNS    : FALSE if the file couldn't be written (after printing a
+              message); TRUE otherwise
+@DESCRIPTION: Saves a forest, along with the macros its @string
+              entries define, to a binary cache file that
+              bt_forest_load() can load without any parsing.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+boolean bt_forest_save (AST * entries, char * path)
+{
+   if (path == NULL)
+      usage_error ("bt_forest_save: no file name supplied");
+   return save_forest (entries, path, NULL, TRUE);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_forest_load()
+@INPUT      : path   - cache file written by bt_forest_save() (or
+                       bt_parse_file_cached())
+@OUTPUT     : *arena - the arena that the forest lives in: free it with
+                       bt_arena_free() when done with the forest.  If
+                       `arena' is NULL, the forest is put in the current
+                       thread's arena instead (see bt_set_arena()).
+@RETURNS    : the forest of entries, or NULL if it was empty or the
+              cache couldn't be loaded
+@DESCRIPTION: Loads a saved forest, and defines the macros that were
+              saved with it.  Since the nodes live in the cache file's
+              mapping, loading is quick however big the forest is, and
+              text that's never looked at is never even read from disk.
+@CALLS      : load_forest()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+AST * bt_forest_load (char * path, bt_arena ** arena)
+{
+   AST *       entries;
+   bt_arena *  own;
+
+   if (path == NULL)
+      usage_error ("bt_forest_load: no file name supplied");
+   if (arena == NULL && bt_get_arena () == NULL)
+      usage_error ("bt_forest_load: no arena to put the forest in");
+
+   if (! load_forest (path, NULL, NULL, &entries, NULL, &own))
+      return NULL;
+   hand_over (own, arena);
+   return entries;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : hash_source()
+@INPUT      : buf, len
+@RETURNS    : a 64-bit FNV-1a hash of the buffer
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static uint64_t
+hash_source (const char * buf, size_t len)
+{
+   uint64_t  hash = 14695981039346656037ULL;
+   size_t    i;
+
+   for (i = 0; i < len; i++)
+   {
+      hash ^= (unsigned char) buf[i];
+      hash *= 1099511628211ULL;
+   }
+   return hash;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : hash_fields()
+@INPUT      :
+@OUTPUT     :
+@RETURNS    : a hash of the fields selected by bt_select_fields(), or 0
+              if all fields are kept
+@DESCRIPTION: The names are hashed (atom IDs differ from one run to the
+              next), and the hashes added up, so the order they were
+              selected in doesn't matter.
+@CALLS      : selected_fields(), hash_source()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static uint64_t
+hash_fields (void)
+{
+   const int *  fields;
+   char *       name;
+   uint64_t     hash;
+   int          i;
+
+   if ((fields = selected_fields ()) == NULL)
+      return 0;
+   hash = 1;
+   for (i = 0; fields[i] != 0; i++)
+   {
+      name = bt_atom_text (fields[i]);
+      hash += hash_source (name, strlen (name));
+   }
+   return hash;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : hash_macros()
+@INPUT      :
+@OUTPUT     :
+@RETURNS    : a hash of the names and texts of every macro in the current
+              thread's macro table, or 0 if it's empty
+@DESCRIPTION: As with hash_fields(), the hashes of the macros are added
+              up, since the table's order means nothing.
+@CALLS      : next_macro(), hash_source()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static uint64_t
+hash_macros (void)
+{
+   unsigned int  pos;
+   char *        name;
+   char *        text;
+   uint64_t      hash;
+
+   init_macros ();
+   hash = 0;
+   for (pos = next_macro (0, &name, &text);
+        pos != 0;
+        pos = next_macro (pos, &name, &text))
+   {
+      hash += hash_source (name, strlen (name)) * 31
+              + (text ? hash_source (text, strlen (text)) : 1);
+   }
+   return hash;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parse_file_cached()
+@INPUT      : filename  - BibTeX file to parse
+              cachefile - where to keep its parsed form
+              options   - standard btparse options bitmap
+@OUTPUT     : *status   - FALSE if the file had serious errors
+              *arena    - the arena that the entries live in, as for
+                          bt_forest_load()
+@RETURNS    : the forest of entries, as for bt_parse_file()
+@DESCRIPTION: Like bt_parse_file_mmap(), but reuses `cachefile' if it
+              holds a forest parsed from this very file, with the same
+              options, string options, selected fields, and macros
+              defined beforehand.  "This very file" means the same
+              size, modification time, and contents (by hash), so the
+              file is still read, but not parsed.  If the cache is
+              missing or stale, the file is parsed, and then saved to
+              `cachefile' for next time.  Either way the file's macros
+              end up defined, and the entries come back in an arena.
+@CALLS      : map_file(), hash_fields(), hash_macros(), load_forest(),
+              bt_parse_buffer(), save_forest()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+AST * bt_parse_file_cached (char *      filename,
+                            char *      cachefile,
+                            ushort      options,
+                            boolean *   status,
+                            bt_arena ** arena)
+{
+   cache_key    key;
+   struct stat  st;
+   char *       buf;
+   size_t       len;
+   AST *        entries;
+   bt_arena *   own;
+   bt_arena *   prev_arena;
+   boolean      parse_status;
+   int          i;
+
+   if (filename == NULL || cachefile == NULL)
+      usage_error ("bt_parse_file_cached: must supply both file names");
+   if (options & BTO_STRINGMASK)        /* any string options set? */
+   {
+      usage_error ("bt_parse_file_cached: illegal options "
+                   "(string options not allowed");
+   }
+   if (arena == NULL && bt_get_arena () == NULL)
+      usage_error ("bt_parse_file_cached: no arena to put the forest in");
+
+   if (status) *status = FALSE;
+   if (stat (filename, &st) < 0)
+   {
+      perror (filename);
+      return NULL;
+   }
+   if (! map_file (filename, &buf, &len))
+      return NULL;
+
+   memset (&key, 0, sizeof (key));
+   key.source_size = (uint64_t) len;
+   key.source_mtime = (int64_t) st.st_mtime;
+   key.source_hash = hash_source (buf, len);
+   key.fields_hash = hash_fields ();
+   key.macros_hash = hash_macros ();
+   key.options[0] = options;
+   for (i = 0; i < NUM_METATYPES; i++)
+      key.options[i+1] = StringOptions[i];
+
+   /* no cache yet is nothing to complain about (unlike map_file()) */
+   if (stat (cachefile, &st) == 0 &&
+       load_forest (cachefile, filename, &key, &entries, status, &own))
+   {
+      unmap_file (buf, len);
+      hand_over (own, arena);
+      return entries;
+   }
+
+   own = bt_arena_new (0);
+   prev_arena = bt_set_arena (own);
+   entries = bt_parse_buffer (buf, len, filename, options, &parse_status);
+   bt_set_arena (prev_arena);
+   unmap_file (buf, len);
+
+   save_forest (entries, cachefile, &key, parse_status);
+   if (status) *status = parse_status;
+   hand_over (own, arena);
+   return entries;
+
+} /* bt_parse_file_cached() */
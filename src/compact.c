@@ -0,0 +1,166 @@
+/* ------------------------------------------------------------------------
+@NAME       : compact.c
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Converting an entry's AST to a compact structure: a single
+              block of memory holding the entry type, key, and the names
+              and values of all its fields, with no pointers in it (so it
+              can be copied or handed to another language as-is).
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse library.  This library is
+              free software; you can redistribute it and/or modify it under
+              the terms of the GNU Library General Public License as
+              published by the Free Software Foundation; either version 2
+              of the License, or (at your option) any later version.
+-------------------------------------------------------------------------- */
+
+#include "bt_config.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "btparse.h"
+#include "error.h"
+#include "prototypes.h"
+#include "my_dmalloc.h"
+
+
+/* ------------------------------------------------------------------------
+@NAME       : add_text()
+@INPUT      : text   - where the compact entry's text goes
+              *used  - how much of it is used so far
+              s      - string to add (NULL means none)
+@OUTPUT     : *used
+@RETURNS    : offset of the copy of `s' in `text' (0 if `s' is NULL)
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static unsigned int
+add_text (char * text, size_t * used, const char * s)
+{
+   size_t  len;
+   size_t  offset;
+
+   if (s == NULL)
+      return 0;
+   len = strlen (s) + 1;
+   offset = *used;
+   memcpy (text + offset, s, len);
+   *used += len;
+   return (unsigned int) offset;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_entry_compact()
+@INPUT      : entry - the AST of a single entry
+@OUTPUT     :
+@RETURNS    : the entry as a bt_compact_entry, in a single malloc'd block
+              (free it with free())
+@DESCRIPTION: Flattens an entry into a bt_compact_entry: a header,
+              followed by the offsets of each field's name and value, and
+              then the text itself, all null-terminated.  Offset 0 is
+              always an empty string, and is what the key of an entry
+              without one points to.  Each value is the field's text as
+              post-processed when the entry was parsed (or, if it was
+              parsed with BTO_LAZY, post-processed now); if that left it
+              as several simple values, they're fully processed into one
+              string as by bt_get_text().  Comment and preamble entries
+              come out with a single field, with an empty name.
+@GLOBALS    :
+@CALLS      : bt_next_field(), fetch_value() (traversal.c)
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+bt_compact_entry * bt_entry_compact (AST * entry)
+{
+   bt_compact_entry * compact;
+   int          num_fields;
+   char **      names;
+   char **      values;
+   boolean *    copied;                 /* values[i] from bt_get_text() */
+   AST *        field;
+   char *       name;
+   char *       key;
+   size_t       text_size;
+   size_t       used;
+   char *       text;
+   int          i;
+
+   if (entry == NULL || entry->nodetype != BTAST_ENTRY)
+      usage_error ("bt_entry_compact: not an entry");
+
+   /* First pass: find all the strings, and how much room they need. */
+   num_fields = 0;
+   if (entry->metatype == BTE_COMMENT || entry->metatype == BTE_PREAMBLE)
+      num_fields = 1;
+   else
+   {
+      for (field = NULL; (field = bt_next_field (entry, field, &name)); )
+         num_fields++;
+   }
+
+   names = (char **) malloc ((num_fields + 1) * 2 * sizeof (char *));
+   values = names + num_fields + 1;
+   copied = (boolean *) calloc (num_fields + 1, sizeof (boolean));
+   if (names == NULL || copied == NULL)
+      internal_error ("out of memory compacting entry");
+
+   if (entry->metatype == BTE_COMMENT || entry->metatype == BTE_PREAMBLE)
+   {
+      names[0] = NULL;
+      values[0] = fetch_value (entry, &copied[0]);
+   }
+   else
+   {
+      field = NULL;
+      for (i = 0; (field = bt_next_field (entry, field, &name)); i++)
+      {
+         names[i] = name;
+         values[i] = fetch_value (field, &copied[i]);
+      }
+   }
+
+   key = bt_entry_key (entry);
+   text_size = 1 + strlen (bt_entry_type (entry)) + 1
+             + (key ? strlen (key) + 1 : 0);
+   for (i = 0; i < num_fields; i++)
+   {
+      if (names[i] != NULL)
+         text_size += strlen (names[i]) + 1;
+      if (values[i] != NULL)
+         text_size += strlen (values[i]) + 1;
+   }
+
+   /* Second pass: lay it all out in one block. */
+   compact = (bt_compact_entry *)
+      malloc (offsetof (bt_compact_entry, fields)
+              + 2 * num_fields * sizeof (unsigned int) + text_size);
+   if (compact == NULL)
+      internal_error ("out of memory compacting entry");
+   compact->metatype = entry->metatype;
+   compact->line = entry->line;
+   compact->num_fields = num_fields;
+
+   text = bt_compact_text (compact);
+   text[0] = (char) 0;
+   used = 1;
+   compact->type = add_text (text, &used, bt_entry_type (entry));
+   compact->key = add_text (text, &used, key);
+   for (i = 0; i < num_fields; i++)
+   {
+      compact->fields[i] = add_text (text, &used, names[i]);
+      compact->fields[num_fields + i] = add_text (text, &used, values[i]);
+      if (copied[i] && values[i] != NULL)
+         free (values[i]);
+   }
+   compact->size = (unsigned int) ((text + used) - (char *) compact);
+
+   free (names);
+   free (copied);
+   return compact;
+
+} /* bt_entry_compact() */
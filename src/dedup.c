@@ -0,0 +1,709 @@
+/* ------------------------------------------------------------------------
+@NAME       : dedup.c
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Finding entries that are probably the same work, even
+              though their keys (and formatting, and spelling of accents)
+              differ.  Each regular entry gets a fingerprint made from
+              its title, the last name of its first author, and its
+              year, each normalized the way BibTeX would before
+              comparing or sorting: purified (bt_purify_string()) and
+              lowercased (bt_change_case()).  Entries with the same
+              fingerprint make a cluster.
+
+              Working out the fingerprints -- splitting names and
+              purifying strings -- is most of the cost, so that is
+              shared among several threads, as in parallel.c.  Fetching
+              the values happens first, in the calling thread, since
+              that may expand macros.  Clustering is a single pass over
+              a hash table of the fingerprints, so no pair of entries is
+              ever compared unless their fingerprints hash the same.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse library.  This library is
+              free software; you can redistribute it and/or modify it under
+              the terms of the GNU Library General Public License as
+              published by the Free Software Foundation; either version 2
+              of the License, or (at your option) any later version.
+-------------------------------------------------------------------------- */
+
+#include "bt_config.h"
+#include <stdlib.h>
+#include <string.h>
+#if HAVE_STDINT_H
+# include <stdint.h>
+#elif HAVE_INTTYPES_H
+# include <inttypes.h>
+#endif
+#if HAVE_PTHREAD_H && HAVE_LIBPTHREAD
+# include <pthread.h>
+# define USE_THREADS 1
+#else
+# define USE_THREADS 0
+#endif
+#include "btparse.h"
+#include "error.h"
+#include "prototypes.h"
+#include "my_dmalloc.h"
+
+
+#define BATCH_SIZE      4096            /* entries per hand-out to a worker */
+#define MIN_SLOTS       16              /* must be a power of 2 */
+#define PART_SEP        '/'             /* purified text never has one */
+
+
+/*
+ * A growable buffer of fingerprint text.  Each worker has its own, so
+ * fingerprints are referred to by offset until all the workers are done.
+ */
+typedef struct
+{
+   char *       text;
+   size_t       used;
+   size_t       alloc;
+} fp_buffer;
+
+/*
+ * One regular entry with a title.  The values are fetched by the
+ * calling thread; the rest is filled in by whichever worker gets it,
+ * apart from `next' and `last', which link up the clusters.
+ */
+typedef struct
+{
+   AST *        entry;
+   char *       title;
+   char *       author;                 /* or the editor */
+   char *       year;
+   unsigned char copied;                /* values to free (COPIED_* bits) */
+   int          worker;                 /* whose buffer has the fingerprint */
+   size_t       offset;                 /* ... and where in it */
+   uint32_t     len;                    /* of the fingerprint */
+   uint32_t     hash;
+   uint32_t     next;                   /* record number + 1, or 0 */
+   uint32_t     last;                   /* (only for the first in a cluster) */
+   uint32_t     size;                   /* ditto */
+} fp_record;
+
+#define COPIED_TITLE  1
+#define COPIED_AUTHOR 2
+#define COPIED_YEAR   4
+
+typedef struct
+{
+   fp_record *  records;
+   uint32_t     num_records;
+   uint32_t     next_batch;             /* first record of next hand-out */
+#if USE_THREADS
+   pthread_mutex_t
+                lock;                   /* protects next_batch */
+#endif
+} fp_job;
+
+typedef struct
+{
+   fp_job *     job;
+   int          num;                    /* index in the workers array */
+   fp_buffer    buf;                    /* fingerprint text */
+   fp_buffer    scratch;                /* for splitting names */
+   int *        err_counts;             /* worker's errors, once done */
+} fp_worker;
+
+struct bt_dupmap_s
+{
+   int          num_clusters;
+   int *        starts;                 /* cluster i is members[starts[i]] */
+                                        /* up to members[starts[i+1]] */
+   AST **       members;
+   char **      fingerprints;           /* one per cluster, in `text' */
+   char *       text;
+};
+
+
+/* ------------------------------------------------------------------------
+@NAME       : buffer_room()
+@INPUT      : buf
+              len - number of bytes about to be added
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Makes sure there's space for `len' more bytes (plus a NUL)
+              at the end of the buffer.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+buffer_room (fp_buffer * buf, size_t len)
+{
+   if (buf->used + len + 1 <= buf->alloc)
+      return;
+   buf->alloc = 2 * buf->alloc + len + 1;
+   buf->text = (char *) realloc (buf->text, buf->alloc);
+   if (buf->text == NULL)
+      internal_error ("out of memory making fingerprints");
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : add_part()
+@INPUT      : buf
+              text - part of the fingerprint (may be NULL)
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Appends `text' to the fingerprint being built at the end of
+              `buf', purified, lowercased, and with its whitespace
+              collapsed.
+@CALLS      : bt_purify_string(), bt_change_case(), bt_postprocess_string()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+add_part (fp_buffer * buf, const char * text)
+{
+   char *  part;
+   size_t  len;
+
+   len = (text != NULL) ? strlen (text) : 0;
+   buffer_room (buf, len);
+   part = buf->text + buf->used;
+   if (len > 0)
+      memcpy (part, text, len);
+   part[len] = (char) 0;
+
+   bt_purify_string (part, 0);
+   bt_change_case ('l', part, 0);
+   bt_postprocess_string (part, BTO_COLLAPSE);
+   buf->used += strlen (part);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : add_last_name()
+@INPUT      : buf
+              scratch  - somewhere to collapse the names
+              names    - author (or editor) field's value; may be NULL
+              filename - for warnings
+              line     - ditto
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Appends the (normalized) last name of the first of `names'
+              to the fingerprint being built at the end of `buf'.
+@CALLS      : bt_split_list(), bt_split_name()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+add_last_name (fp_buffer * buf,
+               fp_buffer * scratch,
+               const char * names,
+               char *      filename,
+               int         line)
+{
+   bt_stringlist * list;
+   bt_name *       name;
+   size_t          len;
+   int             i;
+
+   if (names == NULL)
+      return;
+
+   /* The name-splitting code needs its whitespace collapsed. */
+   len = strlen (names);
+   scratch->used = 0;
+   buffer_room (scratch, len);
+   memcpy (scratch->text, names, len + 1);
+   bt_postprocess_string (scratch->text, BTO_COLLAPSE);
+
+   list = bt_split_list (scratch->text, "and", filename, line, "name");
+   if (list == NULL)
+      return;
+   if (list->num_items > 0 && list->items[0] != NULL)
+   {
+      name = bt_split_name (list->items[0], filename, line, 1);
+      scratch->used = 0;
+      for (i = 0; i < name->part_len[BTN_LAST]; i++)
+      {
+         if (name->parts[BTN_LAST][i] == NULL)
+            continue;
+         len = strlen (name->parts[BTN_LAST][i]);
+         buffer_room (scratch, len + 1);
+         if (scratch->used > 0)
+            scratch->text[scratch->used++] = ' ';
+         memcpy (scratch->text + scratch->used, name->parts[BTN_LAST][i], len);
+         scratch->used += len;
+      }
+      scratch->text[scratch->used] = (char) 0;
+      add_part (buf, scratch->text);
+      bt_free_name (name);
+   }
+   bt_free_list (list);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : make_fingerprint()
+@INPUT      : buf     - where to put it
+              scratch - working space
+              record  - the entry and its values
+@OUTPUT     : record->offset, record->len, record->hash
+@RETURNS    :
+@DESCRIPTION: Appends the fingerprint of an entry to `buf' (with a NUL
+              after it), and notes where it is and its hash (FNV-1a, as
+              for keys in index.c).  The parts are separated by slashes,
+              which bt_purify_string() never leaves behind.
+@CALLS      : add_part(), add_last_name()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+make_fingerprint (fp_buffer * buf, fp_buffer * scratch, fp_record * record)
+{
+   uint32_t     hash = 2166136261U;
+   const char * p;
+   size_t       i;
+
+   record->offset = buf->used;
+   add_part (buf, record->title);
+   buffer_room (buf, 1);
+   buf->text[buf->used++] = PART_SEP;
+   add_last_name (buf, scratch, record->author,
+                  record->entry->filename, record->entry->line);
+   buffer_room (buf, 1);
+   buf->text[buf->used++] = PART_SEP;
+   add_part (buf, record->year);
+   buf->text[buf->used++] = (char) 0;   /* (add_part() left room for it) */
+
+   record->len = (uint32_t) (buf->used - 1 - record->offset);
+   p = buf->text + record->offset;
+   for (i = 0; i < record->len; i++)
+   {
+      hash ^= (unsigned char) p[i];
+      hash *= 16777619U;
+   }
+   record->hash = hash;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : fingerprint_records()
+@INPUT      : arg - an fp_worker, pointing to the fp_job
+@OUTPUT     :
+@RETURNS    : NULL
+@DESCRIPTION: Worker thread body: keeps taking the next batch of records
+              off the job and making their fingerprints, until there are
+              none left.  Then saves the thread's error counts, for the
+              caller to add to its own.
+@CALLS      : make_fingerprint()
+@CALLERS    : bt_find_duplicates()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void *
+fingerprint_records (void * arg)
+{
+   fp_worker *  self = (fp_worker *) arg;
+   fp_job *     job = self->job;
+   fp_record *  record;
+   uint32_t     first, i;
+
+   for (;;)
+   {
+#if USE_THREADS
+      pthread_mutex_lock (&job->lock);
+#endif
+      first = job->next_batch;
+      if (first < job->num_records)
+         job->next_batch += BATCH_SIZE;
+#if USE_THREADS
+      pthread_mutex_unlock (&job->lock);
+#endif
+      if (first >= job->num_records)
+         break;
+
+      for (i = first; i < job->num_records && i - first < BATCH_SIZE; i++)
+      {
+         record = &job->records[i];
+         record->worker = self->num;
+         make_fingerprint (&self->buf, &self->scratch, record);
+      }
+   }
+
+   self->err_counts = bt_get_error_counts (NULL);
+   return NULL;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : fetch_values()
+@INPUT      : entry
+@OUTPUT     : record - entry and the values of its title, author (or
+                       failing that, editor) and year fields
+@RETURNS    : FALSE if it's not a regular entry, or has no title
+@DESCRIPTION: Gets an entry's values ready for make_fingerprint().  This
+              has to be done in the thread that parsed the entry, as
+              the values may not have been postprocessed yet.
+@CALLS      : fetch_value() (traversal.c)
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static boolean
+fetch_values (AST * entry, fp_record * record)
+{
+   AST *     field;
+   AST *     editor = NULL;
+   int       atom;
+   boolean   copied;
+
+   memset (record, 0, sizeof (fp_record));
+   if (entry->metatype != BTE_REGULAR)
+      return FALSE;
+   record->entry = entry;
+
+   for (field = entry->down; field != NULL; field = field->right)
+   {
+      if (field->nodetype != BTAST_FIELD || field->text == NULL)
+         continue;
+      atom = field->atom;
+      if (atom == 0)                    /* renamed by bt_set_text() */
+         bt_intern (field->text, &atom);
+
+      if (atom == BTA_TITLE && record->title == NULL)
+      {
+         record->title = fetch_value (field, &copied);
+         if (copied) record->copied |= COPIED_TITLE;
+      }
+      else if (atom == BTA_AUTHOR && record->author == NULL)
+      {
+         record->author = fetch_value (field, &copied);
+         if (copied) record->copied |= COPIED_AUTHOR;
+      }
+      else if (atom == BTA_YEAR && record->year == NULL)
+      {
+         record->year = fetch_value (field, &copied);
+         if (copied) record->copied |= COPIED_YEAR;
+      }
+      else if (atom == BTA_EDITOR && editor == NULL)
+         editor = field;
+   }
+
+   if (record->author == NULL && editor != NULL)
+   {
+      record->author = fetch_value (editor, &copied);
+      if (copied) record->copied |= COPIED_AUTHOR;
+   }
+   return (record->title != NULL);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : free_values()
+@INPUT      : record
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Frees whichever of the record's values fetch_values() had
+              to copy.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+free_values (fp_record * record)
+{
+   if (record->copied & COPIED_TITLE)  free (record->title);
+   if (record->copied & COPIED_AUTHOR) free (record->author);
+   if (record->copied & COPIED_YEAR)   free (record->year);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_entry_fingerprint()
+@INPUT      : entry - a regular entry
+@OUTPUT     :
+@RETURNS    : the entry's fingerprint (in a malloc'd string), or NULL if
+              it's not a regular entry or has no title
+@DESCRIPTION: Works out the fingerprint that bt_find_duplicates() uses
+              for one entry: its title, the last name of its first author
+              (or editor), and its year, separated by slashes, each
+              purified and lowercased.
+@CALLS      : fetch_values(), make_fingerprint()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+char * bt_entry_fingerprint (AST * entry)
+{
+   fp_record  record;
+   fp_buffer  buf, scratch;
+
+   if (entry == NULL || ! fetch_values (entry, &record))
+   {
+      if (entry != NULL)
+         free_values (&record);
+      return NULL;
+   }
+
+   memset (&buf, 0, sizeof (buf));
+   memset (&scratch, 0, sizeof (scratch));
+   make_fingerprint (&buf, &scratch, &record);
+   free_values (&record);
+   if (scratch.text)
+      free (scratch.text);
+   return buf.text;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_find_duplicates()
+@INPUT      : entries     - list of entries, as returned by bt_parse_file()
+              num_threads - how many threads to use for the fingerprints
+                            (0 means one per processor)
+@OUTPUT     :
+@RETURNS    : a map of the clusters of (probably) duplicate entries
+@DESCRIPTION: Works out the fingerprint of every regular entry with a
+              title (see bt_entry_fingerprint()), and groups the entries
+              with the same fingerprint.  Only groups of two or more
+              become clusters; they are numbered in the order of their
+              first entries, and the entries in each are in list order.
+              The entries are not copied, so the map is only good for as
+              long as the list is.
+@GLOBALS    :
+@CALLS      : fetch_values(), fingerprint_records()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+bt_dupmap * bt_find_duplicates (AST * entries, int num_threads)
+{
+   fp_job       job;
+   fp_worker *  workers;
+   int          num_workers;
+   uint32_t     alloc_records;
+   uint32_t     num_batches;
+   uint32_t *   slots;
+   uint32_t     num_slots, mask;
+   uint32_t     i, j, s;
+   fp_record *  record,
+             *  head;
+   const char * text;
+   size_t       num_members,
+                text_size;
+   bt_dupmap *  map;
+   AST *        entry;
+   int          w;
+#if USE_THREADS
+   pthread_t *  threads;
+#endif
+
+   /* Fetch the values here, since it may mean expanding macros. */
+   memset (&job, 0, sizeof (job));
+   alloc_records = 0;
+   for (entry = entries; entry != NULL; entry = entry->right)
+   {
+      if (job.num_records == alloc_records)
+      {
+         alloc_records = (alloc_records > 0) ? alloc_records * 2 : 1024;
+         job.records = (fp_record *)
+            realloc (job.records, alloc_records * sizeof (fp_record));
+         if (job.records == NULL)
+            internal_error ("out of memory finding duplicates");
+      }
+      record = &job.records[job.num_records];
+      if (fetch_values (entry, record))
+         job.num_records++;
+      else
+         free_values (record);
+   }
+
+   if (num_threads <= 0)
+      num_threads = default_num_threads ();
+#if !USE_THREADS
+   num_threads = 1;
+#endif
+   num_batches = (job.num_records + BATCH_SIZE - 1) / BATCH_SIZE;
+   num_workers = ((uint32_t) num_threads < num_batches) ? num_threads
+                                                         : (int) num_batches;
+   if (num_workers < 1)
+      num_workers = 1;
+   workers = (fp_worker *) calloc (num_workers, sizeof (fp_worker));
+   for (w = 0; w < num_workers; w++)
+   {
+      workers[w].job = &job;
+      workers[w].num = w;
+   }
+
+#if USE_THREADS
+   pthread_mutex_init (&job.lock, NULL);
+   threads = (pthread_t *) calloc (num_workers, sizeof (pthread_t));
+   for (w = 1; w < num_workers; w++)
+   {
+      if (pthread_create (&threads[w], NULL,
+                          fingerprint_records, &workers[w]) != 0)
+         internal_error ("couldn't create fingerprint thread");
+   }
+#endif
+
+   fingerprint_records (&workers[0]);   /* do our share of the work */
+
+#if USE_THREADS
+   for (w = 1; w < num_workers; w++)
+   {
+      pthread_join (threads[w], NULL);
+      add_error_counts (workers[w].err_counts);
+   }
+   free (threads);
+   pthread_mutex_destroy (&job.lock);
+#endif
+
+   /*
+    * Now cluster the records in one pass, with a hash table of the first
+    * record with each fingerprint; later ones are chained on to it.
+    */
+   num_slots = MIN_SLOTS;
+   while (num_slots < 2 * job.num_records)
+      num_slots *= 2;
+   mask = num_slots - 1;
+   slots = (uint32_t *) calloc (num_slots, sizeof (uint32_t));
+   if (slots == NULL)
+      internal_error ("out of memory finding duplicates");
+
+   map = (bt_dupmap *) calloc (1, sizeof (bt_dupmap));
+   if (map == NULL)
+      internal_error ("out of memory finding duplicates");
+   num_members = text_size = 0;
+   for (i = 0; i < job.num_records; i++)
+   {
+      record = &job.records[i];
+      free_values (record);
+      text = workers[record->worker].buf.text + record->offset;
+      for (s = record->hash & mask; slots[s] != 0; s = (s + 1) & mask)
+      {
+         head = &job.records[slots[s] - 1];
+         if (head->hash == record->hash && head->len == record->len &&
+             memcmp (workers[head->worker].buf.text + head->offset,
+                     text, record->len) == 0)
+            break;
+      }
+
+      if (slots[s] == 0)
+      {
+         slots[s] = i + 1;
+         record->last = i + 1;
+         record->size = 1;
+         continue;
+      }
+      head = &job.records[slots[s] - 1];
+      job.records[head->last - 1].next = i + 1;
+      head->last = i + 1;
+      if (++head->size == 2)
+      {
+         map->num_clusters++;
+         num_members += 2;
+         text_size += head->len + 1;
+      }
+      else
+         num_members++;
+   }
+   free (slots);
+
+   /* Gather up the clusters, with their first entries in list order. */
+   map->starts = (int *) malloc ((map->num_clusters + 1) * sizeof (int));
+   map->members = (AST **) malloc ((num_members + 1) * sizeof (AST *));
+   map->fingerprints = (char **)
+      malloc ((map->num_clusters + 1) * sizeof (char *));
+   map->text = (char *) malloc (text_size + 1);
+   if (map->starts == NULL || map->members == NULL ||
+       map->fingerprints == NULL || map->text == NULL)
+      internal_error ("out of memory finding duplicates");
+
+   num_members = text_size = 0;
+   for (i = 0, w = 0; i < job.num_records; i++)
+   {
+      head = &job.records[i];
+      if (head->size < 2)
+         continue;
+      map->starts[w] = (int) num_members;
+      map->fingerprints[w] = map->text + text_size;
+      memcpy (map->text + text_size,
+              workers[head->worker].buf.text + head->offset, head->len + 1);
+      text_size += head->len + 1;
+      for (j = i + 1; j != 0; j = job.records[j - 1].next)
+         map->members[num_members++] = job.records[j - 1].entry;
+      w++;
+   }
+   map->starts[w] = (int) num_members;
+
+   for (w = 0; w < num_workers; w++)
+   {
+      if (workers[w].buf.text) free (workers[w].buf.text);
+      if (workers[w].scratch.text) free (workers[w].scratch.text);
+      if (workers[w].err_counts) free (workers[w].err_counts);
+   }
+   free (workers);
+   free (job.records);
+
+   return map;
+
+} /* bt_find_duplicates() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_dupmap_clusters()
+@INPUT      : map - a map from bt_find_duplicates()
+@OUTPUT     :
+@RETURNS    : number of clusters in the map
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+int bt_dupmap_clusters (bt_dupmap * map)
+{
+   return (map != NULL) ? map->num_clusters : 0;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_dupmap_cluster()
+@INPUT      : map
+              num - which cluster (from 0)
+@OUTPUT     : *entries     - (if not NULL) set to point to an array of
+                             the entries in the cluster, in order; the
+                             array belongs to the map
+              *fingerprint - (if not NULL) set to their fingerprint,
+                             which also belongs to the map
+@RETURNS    : number of entries in the cluster (0 if there's no such
+              cluster)
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+int bt_dupmap_cluster (bt_dupmap * map,
+                       int         num,
+                       AST ***     entries,
+                       char **     fingerprint)
+{
+   if (map == NULL || num < 0 || num >= map->num_clusters)
+   {
+      if (entries) *entries = NULL;
+      if (fingerprint) *fingerprint = NULL;
+      return 0;
+   }
+   if (entries) *entries = map->members + map->starts[num];
+   if (fingerprint) *fingerprint = map->fingerprints[num];
+   return map->starts[num+1] - map->starts[num];
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_dupmap_free()
+@INPUT      : map
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Frees a duplicates map (but not the entries in it).
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void bt_dupmap_free (bt_dupmap * map)
+{
+   if (map == NULL) return;
+   free (map->starts);
+   free (map->members);
+   free (map->fingerprints);
+   free (map->text);
+   free (map);
+}
@@ -16,6 +16,7 @@
 #define ZZCOL
 #define USER_ZZSYN
 
+#include "bt_config.h"
 #include "config.h"
 #include "btparse.h"
 #include "attrib.h"
@@ -23,7 +24,11 @@
 #include "error.h"
 #include "my_dmalloc.h"
 
-extern char * InputFilename;            /* for zzcr_ast call in pccts/ast.c */
+extern BT_THREAD_LOCAL char * InputFilename; /* for zzcr_ast in pccts/ast.c */
+extern BT_THREAD_LOCAL boolean SkippingField; /* ditto (parse_auxiliary.c) */
+extern BT_THREAD_LOCAL boolean InterningName; /* ditto */
+void  check_field_name (AST * field); /* parse_auxiliary.c */
+AST * new_value_node (Attrib * attr, int tok, bt_nodetype nodetype);
 #define zzSET_SIZE 4
 #include "antlr.h"
 #include "ast.h"
@@ -7,6 +7,7 @@
               err_handlers
               errclass_counts
               error_buf
+              ErrorQueue
 @CALLS      : 
 @CREATED    : 1996/08/28, Greg Ward
 @MODIFIED   : 
@@ -25,6 +26,12 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
+#if HAVE_PTHREAD_H && HAVE_LIBPTHREAD
+# include <pthread.h>
+# define USE_THREADS 1
+#else
+# define USE_THREADS 0
+#endif
 #include "btparse.h"
 #include "error.h"
 #include "my_dmalloc.h"
@@ -71,8 +78,35 @@ static bt_err_handler err_handlers[NUM_ERRCLASSES] =
    print_error
 };
 
-static int errclass_counts[NUM_ERRCLASSES] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-static char error_buf[MAX_ERROR+1];
+/* 
+ * The error counts and message buffer are per-thread, so that parsers
+ * running in different threads neither see each other's errors nor
+ * scribble over each other's messages.
+ */
+static BT_THREAD_LOCAL int errclass_counts[NUM_ERRCLASSES] =
+   { 0, 0, 0, 0, 0, 0, 0, 0 };
+static BT_THREAD_LOCAL char error_buf[MAX_ERROR+1];
+
+/*
+ * If a parser has asked for its errors to be queued rather than printed
+ * (bt_parser_queue_errors()), this is its queue while it's parsing.  Only
+ * the non-fatal classes (up to BTERR_SYNTAX) are queued; at most
+ * `max_per_class' errors of each class are kept, and the rest are just
+ * counted -- without even formatting their messages.  Those that are
+ * kept are formatted straight away, though: the arguments are often
+ * bits of the scanner's buffer or the AST, which won't last.
+ */
+struct error_queue_s
+{
+   bt_error *   errors;
+   int          num_errors;
+   int          alloc_errors;
+   int          max_per_class;          /* 0 for no limit */
+   int          num_kept[NUM_ERRCLASSES];
+   int          num_dropped;
+};
+
+static BT_THREAD_LOCAL error_queue * ErrorQueue = NULL;
 
 
 /* ----------------------------------------------------------------------
@@ -86,9 +120,12 @@ void print_error (bt_error *err)
 
    something_printed = FALSE;
 
+#if USE_THREADS
+   flockfile (stderr);                  /* keep each message on one line */
+#endif
    if (err->filename)
    {
-      fprintf (stderr, err->filename);
+      fputs (err->filename, stderr);
       something_printed = TRUE;
    }
    if (err->line > 0)                   /* going to print a line number? */
@@ -111,7 +148,7 @@ void print_error (bt_error *err)
    {
       if (something_printed)
          fprintf (stderr, ", ");
-      fprintf (stderr, name);
+      fputs (name, stderr);
       something_printed = TRUE;
    }
 
@@ -119,6 +156,9 @@ void print_error (bt_error *err)
       fprintf (stderr, ": ");
 
    fprintf (stderr, "%s\n", err->message);
+#if USE_THREADS
+   funlockfile (stderr);
+#endif
 
 } /* print_error() */
 
@@ -133,24 +173,35 @@ void
 report_error (bt_errclass class, 
               char *      filename,
               int         line,
+              int         offset,
               char *      item_desc,
               int         item,
               char *      fmt,
               va_list     arglist)
 {
-   bt_error  err;
+   bt_error     err;
+   error_queue *queue;
 #if !HAVE_VSNPRINTF
-   int       msg_len;
+   int          msg_len;
 #endif
 
    err.class = class;
    err.filename = filename;
    err.line = line;
+   err.offset = offset;
    err.item_desc = item_desc;
    err.item = item;
 
    errclass_counts[(int) class]++;
 
+   queue = (class <= BTERR_SYNTAX) ? ErrorQueue : NULL;
+   if (queue != NULL && queue->max_per_class > 0 &&
+       queue->num_kept[class] >= queue->max_per_class)
+   {
+      queue->num_dropped++;             /* don't bother formatting it */
+      return;
+   }
+
 
    /* 
     * Blech -- we're writing to a static buffer because there's no easy
@@ -179,7 +230,22 @@ report_error (bt_errclass class,
 #endif
 
    err.message = error_buf;
-   if (err_handlers[class])
+   if (queue != NULL)
+   {
+      if (queue->num_errors >= queue->alloc_errors)
+      {
+         queue->alloc_errors = (queue->alloc_errors > 0)
+            ? queue->alloc_errors * 2 : 16;
+         queue->errors = (bt_error *)
+            realloc (queue->errors, queue->alloc_errors * sizeof (bt_error));
+         if (queue->errors == NULL)
+            internal_error ("out of memory queueing error");
+      }
+      err.message = strdup (error_buf);
+      queue->errors[queue->num_errors++] = err;
+      queue->num_kept[class]++;
+   }
+   else if (err_handlers[class])
       (*err_handlers[class]) (&err);
 
    switch (err_actions[class])
@@ -203,7 +269,7 @@ GEN_ERRFUNC (general_error,
               int         item,
               char *      fmt,
               ...),
-             class, filename, line, item_desc, item, fmt)
+             class, filename, line, -1, item_desc, item, fmt)
 
 GEN_ERRFUNC (error,
              (bt_errclass class,
@@ -211,30 +277,138 @@ GEN_ERRFUNC (error,
               int         line, 
               char *      fmt,
               ...),
-             class, filename, line, NULL, -1, fmt)
+             class, filename, line, -1, NULL, -1, fmt)
 
 GEN_ERRFUNC (ast_error,
              (bt_errclass class,
               AST *       ast,
               char *      fmt,
               ...),
-             class, ast->filename, ast->line, NULL, -1, fmt)
+             class, ast->filename, ast->line, ast->offset, NULL, -1, fmt)
 
 GEN_ERRFUNC (notify,
              (char * fmt, ...),
-             BTERR_NOTIFY, NULL, -1, NULL, -1, fmt)
+             BTERR_NOTIFY, NULL, -1, -1, NULL, -1, fmt)
 
 GEN_ERRFUNC (usage_warning,
              (char * fmt, ...),
-             BTERR_USAGEWARN, NULL, -1, NULL, -1, fmt)
+             BTERR_USAGEWARN, NULL, -1, -1, NULL, -1, fmt)
 
 GEN_ERRFUNC (usage_error,
              (char * fmt, ...),
-             BTERR_USAGEERR, NULL, -1, NULL, -1, fmt)
+             BTERR_USAGEERR, NULL, -1, -1, NULL, -1, fmt)
 
 GEN_ERRFUNC (internal_error,
              (char * fmt, ...),
-             BTERR_INTERNAL, NULL, -1, NULL, -1, fmt)
+             BTERR_INTERNAL, NULL, -1, -1, NULL, -1, fmt)
+
+
+/* ----------------------------------------------------------------------
+ * Error queues (for bt_parser_queue_errors() and friends, in input.c).
+ */
+
+/* ------------------------------------------------------------------------
+@NAME       : new_error_queue()
+@INPUT      : max_per_class - most errors of any one class to keep (0 for
+                              no limit)
+@OUTPUT     : 
+@RETURNS    : a new, empty error queue
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+error_queue * new_error_queue (int max_per_class)
+{
+   error_queue * queue;
+
+   queue = (error_queue *) calloc (1, sizeof (error_queue));
+   if (queue == NULL)
+      internal_error ("out of memory creating error queue");
+   queue->max_per_class = max_per_class;
+   return queue;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : clear_error_queue()
+@INPUT      : queue
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Throws away all the errors in a queue (and the count of
+              those dropped), so that it can take a full complement
+              of each class again.
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+void clear_error_queue (error_queue * queue)
+{
+   int    i;
+
+   for (i = 0; i < queue->num_errors; i++)
+      free (queue->errors[i].message);
+   queue->num_errors = 0;
+   queue->num_dropped = 0;
+   for (i = 0; i < NUM_ERRCLASSES; i++)
+      queue->num_kept[i] = 0;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : free_error_queue()
+@INPUT      : queue - (may be NULL)
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Frees a queue and all the errors in it.
+@GLOBALS    : ErrorQueue (cleared if it's this queue)
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+void free_error_queue (error_queue * queue)
+{
+   if (queue == NULL) return;
+   clear_error_queue (queue);
+   if (queue->errors)
+      free (queue->errors);
+   if (ErrorQueue == queue)
+      ErrorQueue = NULL;
+   free (queue);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : set_error_queue()
+@INPUT      : queue - where errors in the current thread go from now on,
+                      or NULL to go back to printing them
+@OUTPUT     : 
+@RETURNS    : 
+@GLOBALS    : ErrorQueue
+@CALLERS    : bt_parser_parse_entry()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+void set_error_queue (error_queue * queue)
+{
+   ErrorQueue = queue;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : error_queue_records()
+@INPUT      : queue
+@OUTPUT     : *num_errors  - number of errors in the queue
+              *num_dropped - (if not NULL) number of errors not kept,
+                             because their class was full
+@RETURNS    : the errors, in the order they were reported (owned by the
+              queue; good until it's cleared or freed)
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+bt_error * error_queue_records (error_queue * queue,
+                                int * num_errors, int * num_dropped)
+{
+   *num_errors = queue->num_errors;
+   if (num_dropped) *num_dropped = queue->num_dropped;
+   return queue->errors;
+}
 
 
 /* ======================================================================
@@ -307,6 +481,29 @@ int *bt_get_error_counts (int *counts)
 }
 
 
+/* ------------------------------------------------------------------------
+@NAME       : add_error_counts()
+@INPUT      : counts - error counts (eg. from bt_get_error_counts()) 
+                       gathered in another thread
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Adds some error counts to the current thread's, so that
+              errors found by worker threads count as the caller's.
+@GLOBALS    : errclass_counts
+@CALLS      : 
+@CALLERS    : bt_parse_buffer_parallel()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+void add_error_counts (int *counts)
+{
+   int    i;
+
+   for (i = 0; i < NUM_ERRCLASSES; i++)
+      errclass_counts[i] += counts[i];
+}
+
+
 /* ------------------------------------------------------------------------
 @NAME       : bt_error_status
 @INPUT      : saved_counts - an array of error counts as returned by 
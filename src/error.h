@@ -23,22 +23,29 @@
 
 #define MAX_ERROR 1024
 
-#define ERRFUNC_BODY(class,filename,line,item_desc,item,format)            \
+#define ERRFUNC_BODY(class,filename,line,offset,item_desc,item,format)     \
 {                                                                          \
    va_list  arglist;                                                       \
                                                                            \
    va_start (arglist, format);                                             \
-   report_error (class, filename, line, item_desc, item, format, arglist); \
+   report_error (class, filename, line, offset, item_desc, item,           \
+                 format, arglist);                                         \
    va_end (arglist);                                                       \
 }
 
-#define GEN_ERRFUNC(name,params,class,filename,line,item_desc,item,format) \
+#define GEN_ERRFUNC(name,params,                                          \
+                    class,filename,line,offset,item_desc,item,format)     \
 void name params                                                           \
-ERRFUNC_BODY (class, filename, line, item_desc, item, format)
+ERRFUNC_BODY (class, filename, line, offset, item_desc, item, format)
 
 #define GEN_PRIVATE_ERRFUNC(name,params,                                  \
-                            class,filename,line,item_desc,item,format)    \
-static GEN_ERRFUNC(name,params,class,filename,line,item_desc,item,format)
+                            class,filename,line,offset,item_desc,item,    \
+                            format)                                       \
+static GEN_ERRFUNC(name,params,                                           \
+                   class,filename,line,offset,item_desc,item,format)
+
+/* A queue of errors, kept instead of printed; see bt_parser_queue_errors(). */
+typedef struct error_queue_s error_queue;
 
 /*
  * Prototypes for functions exported by error.c but only used within
@@ -48,7 +55,8 @@ static GEN_ERRFUNC(name,params,class,filename,line,item_desc,item,format)
 
 void print_error (bt_error *err);
 void report_error (bt_errclass class, 
-                   char * filename, int line, char * item_desc, int item,
+                   char * filename, int line, int offset,
+                   char * item_desc, int item,
                    char * format, va_list arglist);
 
 void general_error (bt_errclass class,
@@ -62,4 +70,13 @@ void usage_warning (char * format, ...);
 void usage_error (char * format, ...);
 void internal_error (char * format, ...);
 
+void add_error_counts (int * counts);
+
+error_queue * new_error_queue (int max_per_class);
+void free_error_queue (error_queue * queue);
+void set_error_queue (error_queue * queue);
+bt_error * error_queue_records (error_queue * queue,
+                                int * num_errors, int * num_dropped);
+void clear_error_queue (error_queue * queue);
+
 #endif
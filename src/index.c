@@ -0,0 +1,830 @@
+/* ------------------------------------------------------------------------
+@NAME       : index.c
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Finding entries by key.  There are two kinds of index
+              here: key maps of a parsed forest of entries, and
+              persistent on-disk indexes of BibTeX files.
+
+              A key map (see bt_forest_index()) is just an in-memory hash
+              table from key to entry AST.
+
+              An on-disk index is for getting at individual entries by
+              key without parsing the whole file.
+              bt_index_build() makes an index with a quick scan of the
+              file (see scan_entries.c); bt_index_open() maps it into
+              memory, and bt_index_lookup() finds a key in it and parses
+              just that one entry.
+
+              The index file is laid out so that it can be used straight
+              out of mmap(): a header, an array of records (one per keyed
+              entry, then one per @string entry), a hash table of record
+              numbers addressed by key, and finally the keys themselves.
+              All numbers are in the byte order of the machine that built
+              the index; an index from a machine with a different byte
+              order just looks stale.  The header records the size and
+              modification time of the file that was indexed, so that an
+              out-of-date index can be detected and rebuilt.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse library.  This library is
+              free software; you can redistribute it and/or modify it under
+              the terms of the GNU Library General Public License as
+              published by the Free Software Foundation; either version 2
+              of the License, or (at your option) any later version.
+-------------------------------------------------------------------------- */
+
+#include "bt_config.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if HAVE_STDINT_H
+# include <stdint.h>
+#elif HAVE_INTTYPES_H
+# include <inttypes.h>
+#endif
+#include "btparse.h"
+#include "error.h"
+#include "prototypes.h"
+#include "my_dmalloc.h"
+
+
+#define INDEX_MAGIC      "btindex"      /* 8 bytes, with the NUL */
+#define INDEX_VERSION    1
+#define INDEX_BYTE_ORDER 0x01020304     /* to spot foreign indexes */
+#define MIN_SLOTS        16             /* must be a power of 2 */
+
+typedef struct
+{
+   char         magic[8];
+   uint32_t     version;
+   uint32_t     byte_order;
+   uint64_t     source_size;            /* of the file indexed ... */
+   int64_t      source_mtime;           /* ... and when it was changed */
+   uint32_t     num_entries;            /* records for keyed entries */
+   uint32_t     num_macros;             /* records for @string entries */
+   uint32_t     num_slots;              /* hash table size (power of 2) */
+   uint32_t     keys_size;              /* bytes of key text */
+} index_header;
+
+typedef struct
+{
+   uint64_t     offset;                 /* of the `@' in the file */
+   uint32_t     length;                 /* of the whole entry */
+   uint32_t     line;                   /* line number of the `@' */
+   uint32_t     key;                    /* offset of key in key text */
+   uint32_t     key_len;
+} index_record;
+
+struct bt_index_s
+{
+   char *       filename;               /* file that was indexed */
+   char *       source;                 /* ... and its contents */
+   size_t       source_len;
+   char *       map;                    /* the index file itself */
+   size_t       map_len;
+   const index_header *
+                header;
+   const index_record *
+                records;
+   const uint32_t *
+                slots;                  /* record number + 1, or 0 */
+   const char * keys;
+};
+
+
+/*
+ * A key map is a hash table with open addressing (linear probing), as
+ * in macros.c, but it never changes once built, so it's simply made
+ * twice as big as the number of keys.
+ */
+typedef struct
+{
+   AST *        entry;                  /* NULL if slot empty */
+   uint32_t     hash;
+} keymap_slot;
+
+struct bt_keymap_s
+{
+   keymap_slot * slots;
+   uint32_t     size;                   /* number of slots */
+   AST **       dups;                   /* entries with repeated keys */
+   int          num_dups;
+};
+
+
+/*
+ * What bt_index_build() collects from the scan: the records, and the
+ * keys they point to.
+ */
+typedef struct
+{
+   index_record * entries;
+   uint32_t       num_entries;
+   index_record * macros;
+   uint32_t       num_macros;
+   uint32_t       alloc_entries;
+   uint32_t       alloc_macros;
+   char *         keys;
+   size_t         keys_size;
+   size_t         keys_alloc;
+} index_builder;
+
+
+/* ------------------------------------------------------------------------
+@NAME       : hash_key()
+@INPUT      : key, len
+@OUTPUT     :
+@RETURNS    : hash value of `key', ignoring case
+@DESCRIPTION: FNV-1a hash of the lowercased key.  This is part of the
+              index file format, so mustn't change without bumping
+              INDEX_VERSION.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static uint32_t
+hash_key (const char * key, size_t len)
+{
+   uint32_t  hash = 2166136261U;
+
+   while (len-- > 0)
+   {
+      hash ^= (unsigned char) tolower ((unsigned char) *key++);
+      hash *= 16777619U;
+   }
+   return hash;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : keymap_slot_for()
+@INPUT      : map
+              key, len - key to look for
+              hash     - hash_key (key, len)
+@OUTPUT     :
+@RETURNS    : the slot holding `key', or the empty slot where it would go
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static keymap_slot *
+keymap_slot_for (bt_keymap * map, const char * key, size_t len,
+                 uint32_t hash)
+{
+   uint32_t      mask = map->size - 1;
+   uint32_t      i;
+   keymap_slot * slot;
+   const char *  other;
+
+   for (i = hash & mask; (slot = &map->slots[i])->entry != NULL;
+        i = (i + 1) & mask)
+   {
+      if (slot->hash != hash)
+         continue;
+      other = bt_entry_key (slot->entry);
+      if (strncasecmp (other, key, len) == 0 && other[len] == (char) 0)
+         break;
+   }
+   return slot;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_forest_index()
+@INPUT      : entries - list of entries, as returned by bt_parse_file()
+@OUTPUT     :
+@RETURNS    : a key map of the entries
+@DESCRIPTION: Builds a hash table mapping the key of each regular entry
+              in `entries' to the entry, ignoring case (as BibTeX
+              does).  If a key occurs more than once, the first entry
+              with that key is the one in the map; the others are
+              reported with a warning, and can be had from
+              bt_keymap_duplicates().  The entries are not copied, so
+              the map is only good for as long as the list is.
+@GLOBALS    :
+@CALLS      : ast_error()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+bt_keymap * bt_forest_index (AST * entries)
+{
+   bt_keymap *   map;
+   AST *         entry;
+   uint32_t      num_keys;
+   int           alloc_dups;
+   char *        key;
+   size_t        len;
+   uint32_t      hash;
+   keymap_slot * slot;
+
+   num_keys = 0;
+   for (entry = entries; entry != NULL; entry = entry->right)
+   {
+      if (bt_entry_key (entry) != NULL)
+         num_keys++;
+   }
+
+   map = (bt_keymap *) calloc (1, sizeof (bt_keymap));
+   if (map == NULL)
+      internal_error ("out of memory building key map");
+   map->size = MIN_SLOTS;
+   while (map->size < 2 * num_keys)
+      map->size *= 2;
+   map->slots = (keymap_slot *) calloc (map->size, sizeof (keymap_slot));
+   if (map->slots == NULL)
+      internal_error ("out of memory building key map");
+   alloc_dups = 0;
+
+   for (entry = entries; entry != NULL; entry = entry->right)
+   {
+      if ((key = bt_entry_key (entry)) == NULL)
+         continue;
+
+      len = strlen (key);
+      hash = hash_key (key, len);
+      slot = keymap_slot_for (map, key, len, hash);
+      if (slot->entry == NULL)
+      {
+         slot->entry = entry;
+         slot->hash = hash;
+         continue;
+      }
+
+      ast_error (BTERR_CONTENT, entry,
+                 "repeated entry key \"%s\" (first used at line %d)",
+                 key, slot->entry->line);
+      if (map->num_dups == alloc_dups)
+      {
+         alloc_dups = (alloc_dups > 0) ? alloc_dups * 2 : 16;
+         map->dups = (AST **) realloc (map->dups, alloc_dups * sizeof (AST *));
+         if (map->dups == NULL)
+            internal_error ("out of memory building key map");
+      }
+      map->dups[map->num_dups++] = entry;
+   }
+
+   return map;
+
+} /* bt_forest_index() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_keymap_find()
+@INPUT      : map - a key map from bt_forest_index()
+              key - key to look for (case doesn't matter)
+@OUTPUT     :
+@RETURNS    : the (first) entry with that key, or NULL if there isn't one
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+AST * bt_keymap_find (bt_keymap * map, char * key)
+{
+   size_t  len;
+
+   if (map == NULL || key == NULL)
+      return NULL;
+   len = strlen (key);
+   return keymap_slot_for (map, key, len, hash_key (key, len))->entry;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_keymap_find_keys()
+@INPUT      : map      - a key map from bt_forest_index()
+              keys     - keys to look for
+              num_keys - how many there are
+@OUTPUT     : found    - found[i] is the entry for keys[i], or NULL
+@RETURNS    : number of keys found
+@DESCRIPTION: Looks up a whole batch of keys at once, eg. all the
+              citations in a document.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+int bt_keymap_find_keys (bt_keymap * map,
+                         char **     keys,
+                         int         num_keys,
+                         AST **      found)
+{
+   int     i;
+   int     num_found = 0;
+
+   for (i = 0; i < num_keys; i++)
+   {
+      found[i] = bt_keymap_find (map, keys[i]);
+      if (found[i] != NULL)
+         num_found++;
+   }
+   return num_found;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_keymap_duplicates()
+@INPUT      : map
+@OUTPUT     : *dups - (if not NULL) set to point to an array of the entries
+                      whose keys had already been used by an earlier
+                      entry, in order; the array belongs to the map
+@RETURNS    : number of such entries
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+int bt_keymap_duplicates (bt_keymap * map, AST *** dups)
+{
+   if (dups) *dups = map->dups;
+   return map->num_dups;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_keymap_free()
+@INPUT      : map
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Frees a key map (but not the entries in it).
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void bt_keymap_free (bt_keymap * map)
+{
+   if (map == NULL) return;
+   free (map->slots);
+   if (map->dups)
+      free (map->dups);
+   free (map);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : add_record()
+@INPUT      : records - array to add to (may be reallocated)
+              num     - number in use
+              alloc   - number allocated
+@OUTPUT     :
+@RETURNS    : pointer to the new (uninitialized) record
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static index_record *
+add_record (index_record ** records, uint32_t * num, uint32_t * alloc)
+{
+   if (*num == *alloc)
+   {
+      *alloc = (*alloc > 0) ? *alloc * 2 : 1024;
+      *records = (index_record *)
+         realloc (*records, *alloc * sizeof (index_record));
+      if (*records == NULL)
+         internal_error ("out of memory building index");
+   }
+   return &(*records)[(*num)++];
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : index_span()
+@INPUT      : span - an entry found by bt_scan_buffer()
+              data - the index_builder
+@OUTPUT     :
+@RETURNS    : 0 (to keep scanning)
+@DESCRIPTION: bt_scan_buffer() callback for bt_index_build(): makes a
+              record for each regular entry and @string entry, and saves
+              the keys of the regular entries.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static int
+index_span (bt_entry_span * span, void * data)
+{
+   index_builder * builder = (index_builder *) data;
+   index_record *  record;
+
+   if (span->key != NULL)
+   {
+      record = add_record (&builder->entries, &builder->num_entries,
+                           &builder->alloc_entries);
+      if (builder->keys_size + span->key_len > builder->keys_alloc)
+      {
+         builder->keys_alloc = 2 * builder->keys_alloc + span->key_len;
+         builder->keys = (char *) realloc (builder->keys, builder->keys_alloc);
+         if (builder->keys == NULL)
+            internal_error ("out of memory building index");
+      }
+      memcpy (builder->keys + builder->keys_size, span->key, span->key_len);
+      record->key = (uint32_t) builder->keys_size;
+      record->key_len = (uint32_t) span->key_len;
+      builder->keys_size += span->key_len;
+   }
+   else if (span->metatype == BTE_MACRODEF)
+   {
+      record = add_record (&builder->macros, &builder->num_macros,
+                           &builder->alloc_macros);
+      record->key = record->key_len = 0;
+   }
+   else
+      return 0;
+
+   record->offset = span->offset;
+   record->length = (uint32_t) span->length;
+   record->line = (uint32_t) span->line;
+   return 0;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : find_slot()
+@INPUT      : slots, num_slots - the hash table
+              records, keys    - what it refers to
+              key, len         - key to look for
+@OUTPUT     :
+@RETURNS    : the slot holding `key', or the empty slot where it would go
+@DESCRIPTION: Open addressing with linear probing, as in macros.c; keys
+              are compared without regard to case.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static uint32_t
+find_slot (const uint32_t *     slots,
+           uint32_t             num_slots,
+           const index_record * records,
+           const char *         keys,
+           const char *         key,
+           size_t               len)
+{
+   uint32_t             mask = num_slots - 1;
+   uint32_t             i;
+   const index_record * record;
+
+   for (i = hash_key (key, len) & mask; slots[i] != 0; i = (i + 1) & mask)
+   {
+      record = &records[slots[i] - 1];
+      if (record->key_len == len &&
+          strncasecmp (keys + record->key, key, len) == 0)
+         break;
+   }
+   return i;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : source_stat()
+@INPUT      : filename
+@OUTPUT     : *size, *mtime
+@RETURNS    : FALSE if the file couldn't be stat'd
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static boolean
+source_stat (char * filename, uint64_t * size, int64_t * mtime)
+{
+   struct stat  st;
+
+   if (stat (filename, &st) < 0)
+      return FALSE;
+   *size = (uint64_t) st.st_size;
+   *mtime = (int64_t) st.st_mtime;
+   return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_index_build()
+@INPUT      : filename  - BibTeX file to index
+              indexfile - where to put the index
+@OUTPUT     :
+@RETURNS    : FALSE if either file couldn't be read or written (after
+              printing a message); TRUE otherwise
+@DESCRIPTION: Scans `filename' with bt_scan_buffer() and writes an index
+              of all its regular entries (by key) and @string entries to
+              `indexfile'.  If a key occurs more than once, the first
+              entry with it is the one indexed.  The index is written to
+              a temporary file, which then replaces `indexfile', so a
+              process using the old index is never caught out by a
+              half-written one.
+@GLOBALS    :
+@CALLS      : map_file(), bt_scan_buffer(), unmap_file()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+boolean bt_index_build (char * filename, char * indexfile)
+{
+   index_builder builder;
+   index_header  header;
+   char *        buf;
+   size_t        len;
+   uint32_t *    slots;
+   uint32_t      num_records;
+   uint32_t      i, slot;
+   char *        tmpname;
+   FILE *        out;
+   boolean       ok;
+
+   if (filename == NULL || indexfile == NULL)
+      usage_error ("bt_index_build: must supply both file names");
+
+   memset (&header, 0, sizeof (header));
+   memcpy (header.magic, INDEX_MAGIC, sizeof (header.magic));
+   header.version = INDEX_VERSION;
+   header.byte_order = INDEX_BYTE_ORDER;
+   if (! source_stat (filename, &header.source_size, &header.source_mtime))
+   {
+      perror (filename);
+      return FALSE;
+   }
+   if (! map_file (filename, &buf, &len))
+      return FALSE;
+
+   memset (&builder, 0, sizeof (builder));
+   bt_scan_buffer (buf, len, index_span, &builder, NULL);
+   unmap_file (buf, len);
+
+   /* Hash the keyed entries, keeping only the first of any duplicates. */
+   header.num_slots = MIN_SLOTS;
+   while (header.num_slots < 2 * builder.num_entries)
+      header.num_slots *= 2;
+   slots = (uint32_t *) calloc (header.num_slots, sizeof (uint32_t));
+   if (slots == NULL)
+      internal_error ("out of memory building index");
+   num_records = 0;
+   for (i = 0; i < builder.num_entries; i++)
+   {
+      index_record * record = &builder.entries[i];
+
+      slot = find_slot (slots, header.num_slots,
+                        builder.entries, builder.keys,
+                        builder.keys + record->key, record->key_len);
+      if (slots[slot] == 0)
+      {
+         builder.entries[num_records] = *record;
+         slots[slot] = ++num_records;
+      }
+   }
+   header.num_entries = num_records;
+   header.num_macros = builder.num_macros;
+   header.keys_size = (uint32_t) builder.keys_size;
+
+   tmpname = (char *) malloc (strlen (indexfile) + 5);
+   sprintf (tmpname, "%s.tmp", indexfile);
+   out = fopen (tmpname, "wb");
+   ok = (out != NULL);
+   if (ok)
+   {
+      ok = (fwrite (&header, sizeof (header), 1, out) == 1 &&
+            fwrite (builder.entries, sizeof (index_record),
+                    header.num_entries, out) == header.num_entries &&
+            fwrite (builder.macros, sizeof (index_record),
+                    header.num_macros, out) == header.num_macros &&
+            fwrite (slots, sizeof (uint32_t),
+                    header.num_slots, out) == header.num_slots &&
+            fwrite (builder.keys, 1,
+                    header.keys_size, out) == header.keys_size);
+      ok &= (fclose (out) == 0);
+   }
+   if (ok)
+      ok = (rename (tmpname, indexfile) == 0);
+   if (!ok)
+   {
+      perror (indexfile);
+      remove (tmpname);
+   }
+
+   free (tmpname);
+   free (slots);
+   free (builder.entries);
+   free (builder.macros);
+   free (builder.keys);
+   return ok;
+
+} /* bt_index_build() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : records_ok()
+@INPUT      : index - an index whose header has been checked, and whose
+                      source file has been mapped
+@OUTPUT     :
+@RETURNS    : TRUE if every record and hash slot points somewhere sensible
+@DESCRIPTION: Checks that each record's entry lies within the source
+              file and its key within the key text, and that each slot
+              holds a real record number -- with at least one slot
+              empty, so that find_slot() stops.  A damaged index that
+              got past this could only give wrong answers, not make us
+              read out of bounds.
+@CALLERS    : bt_index_open()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static boolean
+records_ok (bt_index * index)
+{
+   const index_header * header = index->header;
+   const index_record * record;
+   uint32_t             num_records;
+   uint32_t             i;
+   boolean              have_empty;
+
+   num_records = header->num_entries + header->num_macros;
+   for (i = 0; i < num_records; i++)
+   {
+      record = &index->records[i];
+      if (record->offset > index->source_len ||
+          record->length > index->source_len - record->offset ||
+          record->key > header->keys_size ||
+          record->key_len > header->keys_size - record->key)
+         return FALSE;
+   }
+
+   have_empty = FALSE;
+   for (i = 0; i < header->num_slots; i++)
+   {
+      if (index->slots[i] == 0)
+         have_empty = TRUE;
+      else if (index->slots[i] > header->num_entries)
+         return FALSE;
+   }
+   return have_empty;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_index_open()
+@INPUT      : filename  - BibTeX file that was indexed
+              indexfile - its index, as made by bt_index_build()
+@OUTPUT     :
+@RETURNS    : the opened index, or NULL if the index is missing, stale
+              or damaged (or `filename' couldn't be read)
+@DESCRIPTION: Maps an index file into memory and checks that it really
+              is an index of `filename' as it is now.  If not, NULL is
+              returned without any fuss: the caller is expected to run
+              bt_index_build() and try again.  Otherwise, the BibTeX file
+              is mapped as well, and the @string entries in it are
+              parsed (in the current thread) so that their macros are
+              available to the entries looked up later.
+@GLOBALS    :
+@CALLS      : map_file(), parse_chunk(), default_postprocess()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+bt_index * bt_index_open (char * filename, char * indexfile)
+{
+   bt_index *           index;
+   const index_header * header;
+   const index_record * macro;
+   uint64_t             size,
+                        index_size;
+   int64_t              mtime,
+                        index_mtime;
+   size_t               expect_len;
+   uint32_t             i;
+   AST *                entries;
+   boolean              status;
+
+   if (filename == NULL || indexfile == NULL)
+      usage_error ("bt_index_open: must supply both file names");
+
+   /* no index yet is nothing to complain about (unlike map_file()) */
+   if (! source_stat (filename, &size, &mtime) ||
+       ! source_stat (indexfile, &index_size, &index_mtime))
+      return NULL;
+   index = (bt_index *) calloc (1, sizeof (bt_index));
+   if (index == NULL)
+      internal_error ("out of memory opening index");
+   if (! map_file (indexfile, &index->map, &index->map_len))
+   {
+      free (index);
+      return NULL;
+   }
+
+   header = (const index_header *) index->map;
+   if (index->map_len < sizeof (index_header) ||
+       memcmp (header->magic, INDEX_MAGIC, sizeof (header->magic)) != 0 ||
+       header->version != INDEX_VERSION ||
+       header->byte_order != INDEX_BYTE_ORDER ||
+       header->source_size != size ||
+       header->source_mtime != mtime)
+   {
+      bt_index_close (index);
+      return NULL;
+   }
+   expect_len = sizeof (index_header)
+              + ((size_t) header->num_entries + header->num_macros)
+                * sizeof (index_record)
+              + (size_t) header->num_slots * sizeof (uint32_t)
+              + header->keys_size;
+   if (index->map_len != expect_len || header->num_slots == 0 ||
+       (header->num_slots & (header->num_slots - 1)) != 0)
+   {
+      bt_index_close (index);
+      return NULL;
+   }
+
+   index->header = header;
+   index->records = (const index_record *) (header + 1);
+   index->slots = (const uint32_t *)
+      (index->records + header->num_entries + header->num_macros);
+   index->keys = (const char *) (index->slots + header->num_slots);
+
+   if (! map_file (filename, &index->source, &index->source_len) ||
+       index->source_len != size)
+   {
+      bt_index_close (index);
+      return NULL;
+   }
+   if (! records_ok (index))
+   {
+      bt_index_close (index);
+      return NULL;
+   }
+   index->filename = strdup (filename);
+
+   for (i = 0; i < header->num_macros; i++)
+   {
+      macro = &index->records[header->num_entries + i];
+      entries = parse_chunk (index->source + macro->offset, macro->length,
+                             index->filename, (int) macro->line,
+                             (size_t) macro->offset, 0, &status);
+      if (entries != NULL)
+         default_postprocess (entries, 0);
+      bt_free_ast (entries);
+   }
+
+   return index;
+
+} /* bt_index_open() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_index_lookup()
+@INPUT      : index   - an index from bt_index_open()
+              key     - key of the entry wanted (case doesn't matter)
+              options - standard btparse options bitmap
+@OUTPUT     : *status - FALSE if the entry had serious errors
+@RETURNS    : the entry's AST, or NULL if `key' isn't in the index
+@DESCRIPTION: Looks `key' up in the index, and parses just that entry
+              from the indexed file.  Line numbers and offsets in the AST
+              (and in any error messages) are those of the whole file.
+@GLOBALS    :
+@CALLS      : parse_chunk(), default_postprocess()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+AST * bt_index_lookup (bt_index * index,
+                       char *     key,
+                       ushort     options,
+                       boolean *  status)
+{
+   const index_record * record;
+   uint32_t             slot;
+   AST *                entry;
+
+   if (options & BTO_STRINGMASK)        /* any string options set? */
+   {
+      usage_error ("bt_index_lookup: illegal options "
+                   "(string options not allowed");
+   }
+   if (status) *status = TRUE;
+   if (index == NULL || key == NULL)
+      return NULL;
+
+   slot = find_slot (index->slots, index->header->num_slots,
+                     index->records, index->keys, key, strlen (key));
+   if (index->slots[slot] == 0)
+      return NULL;
+
+   record = &index->records[index->slots[slot] - 1];
+   entry = parse_chunk (index->source + record->offset, record->length,
+                        index->filename, (int) record->line,
+                        (size_t) record->offset, options, status);
+   if (entry != NULL)
+   {
+      bt_free_ast (entry->right);       /* can't happen, but just in case */
+      entry->right = NULL;
+      default_postprocess (entry, options);
+   }
+   return entry;
+
+} /* bt_index_lookup() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_index_close()
+@INPUT      : index
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Unmaps an index (and the file it indexes), and frees it.
+              The macros defined by bt_index_open() are left alone.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void bt_index_close (bt_index * index)
+{
+   if (index == NULL) return;
+   unmap_file (index->map, index->map_len);
+   unmap_file (index->source, index->source_len);
+   if (index->filename)
+      free (index->filename);
+   free (index);
+}
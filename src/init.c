@@ -18,6 +18,7 @@
 #include "bt_config.h"
 #include "stdpccts.h"                   /* for zzfree_ast() prototype */
 #include "parse_auxiliary.h"            /* for fix_token_names() proto */
+#include "lex_auxiliary.h"              /* for free_spare_lex_buffer() */
 #include "prototypes.h"                 /* for other prototypes */
 #include "my_dmalloc.h"
 
@@ -32,6 +33,8 @@ void bt_initialize (void)
 
 void bt_free_ast (AST *ast)
 {
+   if (ast != NULL && ast->arena != NULL)
+      return;                           /* freed along with its arena */
    zzfree_ast (ast);
 }
 
@@ -39,4 +42,5 @@ void bt_free_ast (AST *ast)
 void bt_cleanup (void)
 {
    done_macros ();
+   free_spare_lex_buffer ();
 }
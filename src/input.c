@@ -3,9 +3,11 @@
 @DESCRIPTION: Routines for input of BibTeX data.
 @GLOBALS    : InputFilename
               StringOptions
+              SelectedFields
 @CALLS      : 
 @CREATED    : 1997/10/14, Greg Ward (from code in bibparse.c)
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16: added bt_parser objects, so that several inputs
+              can be parsed at once (in one thread or in many)
 @VERSION    : $Id: input.c 640 1999-11-29 01:13:10Z greg $
 @COPYRIGHT  : Copyright (c) 1996-99 by Gregory P. Ward.  All rights reserved.
 
@@ -18,16 +20,67 @@
 #include "bt_config.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <limits.h>
 #include <assert.h>
+#if HAVE_MMAP && HAVE_SYS_MMAN_H && HAVE_FCNTL_H && HAVE_UNISTD_H
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+# define USE_MMAP 1
+#else
+# define USE_MMAP 0
+#endif
 #include "stdpccts.h"
 #include "lex_auxiliary.h"
 #include "prototypes.h"
 #include "error.h"
+#include "stats.h"
 #include "my_dmalloc.h"
 
 
-char *   InputFilename;
+/*
+ * A parser owns everything needed to read a sequence of entries from one
+ * input: the input itself, the error counts at the start of the current
+ * entry, and -- while it's not the active parser -- the saved state of
+ * the scanner and of the lexical buffer.  (The active parser's state
+ * lives in the thread-local PCCTS and lex_auxiliary.c globals.)
+ */
+struct bt_parser_s
+{
+   FILE *       infile;                 /* stream we're reading from, or */
+   char *       instring;               /* string we're reading from, or */
+   const char * inbuf;                  /* buffer we're reading from */
+   size_t       inbuf_len;
+   int          line;                   /* starting line (not for infile) */
+   int          offset;                 /* starting offset (ditto) */
+   char *       filename;               /* for messages and the ASTs */
+   boolean      raw;                    /* skip post-processing? */
+   boolean      fresh;                  /* restart for every entry? */
+   boolean      started;                /* scanner primed? */
+   boolean      done;                   /* hit eof and cleaned up? */
+   int *        err_counts;             /* error counts before this entry */
+   error_queue *errors;                 /* if errors are queued, not printed */
+   struct zzdlg_state
+                dlg_state;              /* DLG state, lookahead token and */
+   int          token;                  /* lexical state -- only valid */
+   lex_state    lex_state;              /* while not ActiveParser */
+};
+
+BT_THREAD_LOCAL char * InputFilename;
+extern BT_THREAD_LOCAL boolean DroppedField; /* from parse_auxiliary.c */
+
+/* 
+ * ActiveParser is the parser whose state is currently in the scanner
+ * globals (if any).  FileParser and StringParser are the parsers used
+ * behind the scenes by bt_parse_entry() and bt_parse_entry_s().
+ */
+static BT_THREAD_LOCAL bt_parser * ActiveParser = NULL;
+static BT_THREAD_LOCAL bt_parser * FileParser = NULL;
+static BT_THREAD_LOCAL bt_parser * StringParser = NULL;
+
 ushort   StringOptions[NUM_METATYPES] = 
 {
    0,                                   /* BTE_UNKNOWN */
@@ -37,6 +90,13 @@ ushort   StringOptions[NUM_METATYPES] =
    BTO_MACRO                            /* BTE_MACRODEF */
 };
 
+/* 
+ * If non-NULL, the only fields of regular entries that are put in the
+ * AST (zero-terminated list of atom IDs, from bt_select_fields()).
+ * Like StringOptions, shared by all threads.
+ */
+static int * SelectedFields = NULL;
+
 
 /* ------------------------------------------------------------------------
 @NAME       : bt_set_filename
@@ -82,53 +142,149 @@ void bt_set_stringopts (bt_metatype metatype, ushort options)
 }
 
 
+/* ------------------------------------------------------------------------
+@NAME       : bt_select_fields
+@INPUT      : fields - NULL-terminated list of field names, or NULL
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Sets the list of fields to keep when parsing regular
+              entries: any other field is recognized by the parser as
+              usual, but is then thrown away at once -- its value text
+              is never copied into the AST, nor post-processed.  Macro
+              definitions, comments, and preambles are unaffected.
+              Passing NULL (or an empty list) goes back to keeping all
+              fields.  The names are interned (see bt_intern()), so
+              they're matched regardless of case, by atom ID.
+@GLOBALS    : SelectedFields
+@CALLS      : 
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+void bt_select_fields (char ** fields)
+{
+   int    i, num;
+
+   if (SelectedFields != NULL)
+   {
+      free (SelectedFields);
+      SelectedFields = NULL;
+   }
+
+   if (fields == NULL || fields[0] == NULL)
+      return;
+
+   for (num = 0; fields[num] != NULL; num++)
+      ;
+   SelectedFields = (int *) malloc ((num + 1) * sizeof (int));
+   if (SelectedFields == NULL)
+      internal_error ("out of memory selecting fields");
+   for (i = 0; i < num; i++)
+      bt_intern (fields[i], &SelectedFields[i]);
+   SelectedFields[num] = 0;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : field_selected
+@INPUT      : atom - atom ID of the name of a field in a regular entry
+@OUTPUT     : 
+@RETURNS    : TRUE if the field should be kept, ie. if no fields were
+              selected with bt_select_fields(), or `atom' is one of them
+@GLOBALS    : SelectedFields
+@CALLERS    : check_field_name() (parse_auxiliary.c)
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+boolean field_selected (int atom)
+{
+   int    i;
+
+   if (SelectedFields == NULL)
+      return TRUE;
+   for (i = 0; SelectedFields[i] != 0; i++)
+   {
+      if (SelectedFields[i] == atom)
+         return TRUE;
+   }
+   return FALSE;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : selected_fields
+@INPUT      : 
+@OUTPUT     : 
+@RETURNS    : the atom IDs of the fields selected by bt_select_fields()
+              (zero-terminated), or NULL if all fields are kept
+@GLOBALS    : SelectedFields
+@CALLERS    : hash_fields() (cache.c)
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+const int * selected_fields (void)
+{
+   return SelectedFields;
+}
+
+
 /* ------------------------------------------------------------------------
 @NAME       : start_parse
-@INPUT      : infile     input stream we'll read from (or NULL if reading 
-                         from string)
-              instring   input string we'll read from (or NULL if reading
-                         from stream)
-              line       line number of the start of the string (just
-                         use 1 if the string is standalone and independent;
-                         if it comes from a file, you should supply the
-                         line number where it starts for better error
-                         messages) (ignored if infile != NULL)
+@INPUT      : parser     the parser to start; exactly one of its input 
+                         sources must be set:
+                           infile    input stream
+                           instring  null-terminated string
+                           inbuf     buffer of inbuf_len characters
+                         For strings and buffers, parser->line is the line
+                         number of the start of the text (just use 1 if
+                         the text is standalone and independent; if it
+                         comes from a file, you should supply the line
+                         number where it starts for better error messages),
+                         and parser->offset is likewise the character
+                         offset of the start of the text
 @OUTPUT     : 
 @RETURNS    : 
 @DESCRIPTION: Prepares things for parsing, in particular initializes the 
               lexical state and lexical buffer, prepares DLG for
-              reading (either from a stream or a string), and reads
+              reading (from a stream, a string, or a buffer), and reads
               the first token.
 @GLOBALS    : 
-@CALLS      : initialize_lexer_state()
+@CALLS      : initialize_lexer_state(), reset_overflow_count()
               alloc_lex_buffer()
-              zzrdstream() or zzrdstr()
+              zzrdstream(), zzrdstr(), or zzrdbuf()
               zzgettok()
 @CALLERS    : 
 @CREATED    : 1997/06/21, GPW
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16 (takes a parser; added buffer input and
+                          starting offset)
 -------------------------------------------------------------------------- */
 static void
-start_parse (FILE *infile, char *instring, int line)
+start_parse (bt_parser *parser)
 {
-   if ( (infile == NULL) == (instring == NULL) )
+   if ((parser->infile != NULL) + (parser->instring != NULL)
+       + (parser->inbuf != NULL) != 1)
    {
-      internal_error ("start_parse(): exactly one of infile and "
-                      "instring may be non-NULL");
+      internal_error ("start_parse(): exactly one of infile, instring, "
+                      "and inbuf may be non-NULL");
    }
    initialize_lexer_state ();
+   reset_overflow_count ();
    alloc_lex_buffer (ZZLEXBUFSIZE);
-   if (infile)
+   if (parser->infile)
+   {
+      zzrdstream (parser->infile);
+   }
+   else if (parser->instring)
    {
-      zzrdstream (infile);
+      zzrdstr ((zzchar_t *) parser->instring);
+      zzline = parser->line;
    }
    else
    {
-      zzrdstr (instring);
-      zzline = line;
+      zzrdbuf ((zzchar_t *) parser->inbuf, parser->inbuf_len);
+      zzline = parser->line;
    }
       
-   zzendcol = zzbegcol = 0;
+   zzendcol = zzbegcol = parser->offset;
    zzgettok ();
 }
 
@@ -136,24 +292,102 @@ start_parse (FILE *infile, char *instring, int line)
 
 /* ------------------------------------------------------------------------
 @NAME       : finish_parse()
-@INPUT      : err_counts - pointer to error count list (which is local to
-                           the parsing functions, hence has to be passed in)
+@INPUT      : parser - the parser we're done with
 @OUTPUT     : 
 @RETURNS    : 
 @DESCRIPTION: Frees up what was needed to parse a whole file or a sequence
               of strings: the lexical buffer and the error count list.
-@GLOBALS    : 
+              Works whether or not `parser' is the active parser.
+@GLOBALS    : ActiveParser
 @CALLS      : free_lex_buffer()
 @CALLERS    : 
 @CREATED    : 1997/06/21, GPW
+@MODIFIED   : (takes a parser instead of the error count list)
+-------------------------------------------------------------------------- */
+static void
+finish_parse (bt_parser *parser)
+{
+   if (parser == ActiveParser)
+   {
+      if (parser->started)
+         free_lex_buffer ();
+      ActiveParser = NULL;
+   }
+   else if (parser->lex_state.toktext != NULL)
+   {
+      free (parser->lex_state.toktext);
+      parser->lex_state.toktext = NULL;
+   }
+
+   free (parser->err_counts);
+   parser->err_counts = NULL;
+   parser->started = FALSE;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : suspend_parser()
+@INPUT      : parser - the currently active parser
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Saves all the state of the DLG scanner, the ANTLR lookahead
+              token, and the lexical state from lex_auxiliary.c into
+              `parser', so that another parser can use them.  The
+              lexical buffer goes with it.
+@GLOBALS    : ActiveParser
+@CALLS      : zzsave_dlg_state(), save_lexer_state()
+@CALLERS    : activate_parser()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static void
+suspend_parser (bt_parser *parser)
+{
+   if (parser->started)
+   {
+      zzsave_dlg_state (&parser->dlg_state);
+      parser->token = zztoken;
+      save_lexer_state (&parser->lex_state);
+   }
+   ActiveParser = NULL;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : activate_parser()
+@INPUT      : parser - the parser about to be used
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Makes `parser' the one that owns the (thread-local) 
+              scanner and parser globals: suspends whichever parser 
+              currently has them, and reinstates `parser's own state
+              if it had any.  Cheap if `parser' is already active, which
+              is the usual case of reading one file at a time.
+@GLOBALS    : ActiveParser, InputFilename
+@CALLS      : suspend_parser(), restore_lexer_state(), 
+              zzrestore_dlg_state()
+@CALLERS    : parse_next_entry()
+@CREATED    : 2026/10/16
 @MODIFIED   : 
 -------------------------------------------------------------------------- */
 static void
-finish_parse (int **err_counts)
+activate_parser (bt_parser *parser)
 {
-   free_lex_buffer ();
-   free (*err_counts);
-   *err_counts = NULL;
+   if (parser != ActiveParser)
+   {
+      if (ActiveParser != NULL)
+         suspend_parser (ActiveParser);
+
+      if (parser->started)
+      {
+         restore_lexer_state (&parser->lex_state);
+         zzrestore_dlg_state (&parser->dlg_state);
+         zztoken = parser->token;
+      }
+      ActiveParser = parser;
+   }
+
+   InputFilename = parser->filename;
 }
 
 
@@ -188,6 +422,359 @@ parse_status (int *saved_counts)
 }   
 
 
+
+
+/* ------------------------------------------------------------------------
+@NAME       : default_postprocess()
+@INPUT      : entry   - a freshly parsed entry
+              options - non-string options from the caller
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Post-processes an entry according to the string options
+              set for its metatype with bt_set_stringopts() (this is also
+              when @string entries add their macros to the table).
+@GLOBALS    : StringOptions, ParseStats
+@CALLS      : bt_postprocess_entry()
+@CALLERS    : parse_next_entry(), bt_parse_buffer_parallel()
+@CREATED    : 2026/10/16 (from code in parse_next_entry())
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+void default_postprocess (AST * entry, ushort options)
+{
+#if BT_STATS
+   double  start = stats_clock ();
+#endif
+
+   bt_postprocess_entry (entry, StringOptions[entry->metatype] | options);
+#if BT_STATS
+   ParseStats.postprocess_time += stats_clock () - start;
+#endif
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : parse_next_entry()
+@INPUT      : parser  - parser to read from (file or string)
+              options - standard btparse options bitmap (already checked
+                        by the caller)
+@OUTPUT     : *status - success flag, as for bt_parse_entry()
+@RETURNS    : AST for the next entry, or NULL at eof (or on bad input)
+@DESCRIPTION: The guts of bt_parser_parse_entry(), bt_parse_entry(), and
+              bt_parse_entry_s(): makes `parser' active, starts the
+              scanner if this is the first entry (or if we're reading from
+              a string -- each string is a fresh start), enters the parser,
+              and post-processes the resulting entry.  An entry that had
+              fields dropped (see bt_select_fields()), or serious errors
+              patched over, is marked `changed', since it's no longer
+              what its source text says.
+@GLOBALS    : 
+@CALLS      : activate_parser(), start_parse(), finish_parse(), ANTLR
+@CREATED    : 2026/10/16 (from code in bt_parse_entry())
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static AST *
+parse_next_entry (bt_parser * parser, ushort options, boolean * status)
+{
+   AST *  entry_ast = NULL;
+   boolean ok;
+#if BT_STATS
+   double start;
+#endif
+
+   activate_parser (parser);
+   parser->err_counts = bt_get_error_counts (parser->err_counts);
+
+   if (parser->infile != NULL ? feof (parser->infile)
+                              : (parser->inbuf != NULL && parser->started
+                                 && !parser->fresh && zzchar == EOF))
+   {
+      if (!parser->done)                /* haven't already done the cleanup */
+      {
+         finish_parse (parser);
+         parser->done = TRUE;
+      }
+      else
+      {
+         usage_warning ("bt_parser_parse_entry: second attempt to read "
+                        "past eof");
+      }
+
+      if (status) *status = TRUE;
+      return NULL;
+   }
+
+   zzast_sp = zzastTOP;                 /* workaround apparent pccts bug */
+
+#if defined(LL_K) || defined(ZZINF_LOOK) || defined(DEMAND_LOOK)
+# error One of LL_K, ZZINF_LOOK, or DEMAND_LOOK was defined
+#endif
+   if (parser->instring != NULL         /* each string starts afresh */
+       || parser->fresh                 /* (as does each batch entry); */
+       || !parser->started)             /* only read from input stream if */
+   {                                    /* starting afresh with a file */
+      start_parse (parser);
+      parser->started = TRUE;
+   }
+
+   SkippingField = FALSE;               /* in case of error last time */
+   InterningName = FALSE;
+   DroppedField = FALSE;
+#if BT_STATS
+   start = stats_clock ();
+#endif
+   entry (&entry_ast);                  /* enter the parser */
+   ++zzasp;                             /* why is this done? */
+   zzaFreeChunks ();                    /* in case the stacks grew */
+   zzastFreeChunks ();
+#if BT_STATS                            /* lexer and parser together */
+   ParseStats.parse_time += stats_clock () - start;
+#endif
+
+   if (entry_ast == NULL)               /* can happen with very bad input */
+   {
+      if (status) *status = FALSE;
+      return entry_ast;
+   }
+   COUNT (entries[entry_ast->metatype]);
+
+#if DEBUG
+   dump_ast ("parse_next_entry(): single entry, after parsing:\n", 
+             entry_ast);
+#endif
+   if (!parser->raw)
+      default_postprocess (entry_ast, options);
+#if DEBUG
+   dump_ast ("parse_next_entry(): single entry, after post-processing:\n", 
+             entry_ast);
+#endif
+
+   ok = parse_status (parser->err_counts);
+   if (DroppedField || !ok)
+      entry_ast->changed = TRUE;
+   if (status) *status = ok;
+   return entry_ast;
+
+} /* parse_next_entry() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parser_new()
+@INPUT      : infile   - stream to read entries from
+              filename - name of the file (for error messages and the
+                         `filename' field of AST nodes); not copied, so
+                         it must outlive the parser and its ASTs
+@OUTPUT     : 
+@RETURNS    : a new parser, to be passed to bt_parser_parse_entry() and
+              eventually bt_parser_free()
+@DESCRIPTION: Creates a parser for a single input stream.  Unlike 
+              bt_parse_entry(), which can only work on one file at a 
+              time, any number of parsers may be alive at once, and calls
+              on them may be freely interleaved.  Parsers in different
+              threads run independently; a single parser must only be
+              used by one thread.
+@GLOBALS    : 
+@CALLS      : 
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+bt_parser * bt_parser_new (FILE * infile, char * filename)
+{
+   bt_parser *  parser;
+
+   if (infile == NULL)
+      usage_error ("bt_parser_new: no input stream supplied");
+
+   parser = (bt_parser *) calloc (1, sizeof (bt_parser));
+   parser->infile = infile;
+   parser->filename = filename;
+   return parser;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parser_new_buffer()
+@INPUT      : buf      - text to parse; need not be null-terminated
+              len      - number of characters in `buf'
+              filename - as for bt_parser_new()
+@OUTPUT     : 
+@RETURNS    : a new parser
+@DESCRIPTION: Like bt_parser_new(), but the parser scans directly out of
+              an in-memory buffer (eg. a memory-mapped file) rather than 
+              going through stdio.  The buffer is only read, never 
+              modified, and must stay put until the parser is freed.
+@GLOBALS    : 
+@CALLS      : 
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+bt_parser * bt_parser_new_buffer (const char * buf, 
+                                  size_t       len, 
+                                  char *       filename)
+{
+   bt_parser *  parser;
+
+   if (buf == NULL && len > 0)
+      usage_error ("bt_parser_new_buffer: no buffer supplied");
+
+   parser = (bt_parser *) calloc (1, sizeof (bt_parser));
+   parser->inbuf = (buf != NULL) ? buf : "";
+   parser->inbuf_len = len;
+   parser->line = 1;
+   parser->filename = filename;
+   return parser;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parser_parse_entry()
+@INPUT      : parser  - parser created by bt_parser_new()
+              options - standard btparse options bitmap
+@OUTPUT     : *status - as for bt_parse_entry()
+@RETURNS    : AST for the next entry, or NULL if no entries left in the
+              parser's input (same as bt_parse_entry())
+@DESCRIPTION: Reads and parses the next entry from a parser's input 
+              stream.
+@GLOBALS    : 
+@CALLS      : parse_next_entry()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+AST * bt_parser_parse_entry (bt_parser * parser,
+                             ushort      options,
+                             boolean *   status)
+{
+   AST *  entry;
+
+   if (parser == NULL)
+      usage_error ("bt_parser_parse_entry: no parser supplied");
+
+   if (options & BTO_STRINGMASK)        /* any string options set? */
+   {
+      usage_error ("bt_parser_parse_entry: illegal options "
+                   "(string options not allowed)");
+   }
+
+   if (parser->errors == NULL)
+      return parse_next_entry (parser, options, status);
+
+   set_error_queue (parser->errors);
+   entry = parse_next_entry (parser, options, status);
+   set_error_queue (NULL);
+   return entry;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parser_free()
+@INPUT      : parser - parser created by bt_parser_new()
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Frees a parser and everything it owns (the lexical buffer, 
+              saved error counts).  Doesn't close the input stream, and
+              doesn't touch any ASTs it has returned.
+@GLOBALS    : 
+@CALLS      : finish_parse()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+void bt_parser_free (bt_parser * parser)
+{
+   if (parser == NULL) return;
+   finish_parse (parser);
+   free_error_queue (parser->errors);
+   free (parser);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parser_queue_errors()
+@INPUT      : parser        - parser created by bt_parser_new()
+              max_per_class - most errors of each class to keep (0 for
+                              no limit), or negative to go back to
+                              printing errors
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Asks for the warnings and errors found while reading from
+              `parser' (with bt_parser_parse_entry()) to be kept in a
+              queue on the parser, instead of being printed.  Past the
+              limit for its class, an error is only counted (as dropped):
+              its message isn't even formatted, so a really messy input
+              doesn't spend its time on warnings no one will read.  The
+              error counts and the status returned for each entry are
+              the same either way.  Fatal errors (BTERR_USAGEERR and
+              BTERR_INTERNAL) are never queued.
+@GLOBALS    : 
+@CALLS      : new_error_queue(), free_error_queue()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+void bt_parser_queue_errors (bt_parser * parser, int max_per_class)
+{
+   if (parser == NULL)
+      usage_error ("bt_parser_queue_errors: no parser supplied");
+
+   free_error_queue (parser->errors);
+   parser->errors = (max_per_class >= 0)
+      ? new_error_queue (max_per_class) : NULL;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parser_errors()
+@INPUT      : parser
+@OUTPUT     : *num_errors  - number of errors queued
+              *num_dropped - (if not NULL) number of errors not queued
+                             because their class was full
+@RETURNS    : the queued errors, in the order they were found (NULL if
+              there are none); they belong to the parser, and are good
+              until bt_parser_clear_errors() or bt_parser_free()
+@DESCRIPTION: Fetches the errors queued on a parser since
+              bt_parser_queue_errors() or the last bt_parser_clear_errors().
+              The `filename' of each is the parser's filename, and isn't
+              copied.
+@GLOBALS    : 
+@CALLS      : error_queue_records()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+bt_error * bt_parser_errors (bt_parser * parser,
+                             int *       num_errors,
+                             int *       num_dropped)
+{
+   if (parser == NULL || num_errors == NULL)
+      usage_error ("bt_parser_errors: no parser or count supplied");
+
+   if (parser->errors == NULL)
+   {
+      *num_errors = 0;
+      if (num_dropped) *num_dropped = 0;
+      return NULL;
+   }
+   return error_queue_records (parser->errors, num_errors, num_dropped);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parser_clear_errors()
+@INPUT      : parser
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Empties a parser's error queue (eg. after each entry), so
+              that each class can take its full limit again.
+@GLOBALS    : 
+@CALLS      : clear_error_queue()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+void bt_parser_clear_errors (bt_parser * parser)
+{
+   if (parser == NULL)
+      usage_error ("bt_parser_clear_errors: no parser supplied");
+   if (parser->errors != NULL)
+      clear_error_queue (parser->errors);
+}
+
+
 /* ------------------------------------------------------------------------
 @NAME       : bt_parse_entry_s()
 @INPUT      : entry_text - string containing the entire entry to parse,
@@ -207,10 +794,10 @@ parse_status (int *saved_counts)
               errors such as warnings and notifications count as "success"
               for the purposes of this function's return value.)
 @DESCRIPTION: Parses a BibTeX entry contained in a string.
-@GLOBALS    : 
-@CALLS      : ANTLR
+@GLOBALS    : StringParser
+@CALLS      : parse_next_entry()
 @CREATED    : 1997/01/18, GPW (from code in bt_parse_entry())
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16 (uses a private, per-thread parser)
 -------------------------------------------------------------------------- */
 AST * bt_parse_entry_s (char *    entry_text,
                         char *    filename,
@@ -218,8 +805,7 @@ AST * bt_parse_entry_s (char *    entry_text,
                         ushort    options,
                         boolean * status)
 {
-   AST *        entry_ast = NULL;
-   static int * err_counts = NULL;
+   AST *        entry_ast;
 
    if (options & BTO_STRINGMASK)        /* any string options set? */
    {
@@ -227,43 +813,102 @@ AST * bt_parse_entry_s (char *    entry_text,
                    "(string options not allowed");
    }
 
-   InputFilename = filename;
-   err_counts = bt_get_error_counts (err_counts);
-
    if (entry_text == NULL)              /* signal to clean up */
    {
-      finish_parse (&err_counts);
+      bt_parser_free (StringParser);
+      StringParser = NULL;
       if (status) *status = TRUE;
       return NULL;
    }
 
-   zzast_sp = ZZAST_STACKSIZE;          /* workaround apparent pccts bug */
-   start_parse (NULL, entry_text, line);
+   if (StringParser == NULL)
+      StringParser = (bt_parser *) calloc (1, sizeof (bt_parser));
 
-   entry (&entry_ast);                  /* enter the parser */
-   ++zzasp;                             /* why is this done? */
+   StringParser->filename = filename;
+   StringParser->instring = entry_text;
+   StringParser->line = line;
+   entry_ast = parse_next_entry (StringParser, options, status);
+   StringParser->instring = NULL;       /* don't hang on to caller's data */
 
-   if (entry_ast == NULL)               /* can happen with very bad input */
+   return entry_ast;
+
+} /* bt_parse_entry_s () */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parse_entries_s()
+@INPUT      : texts    - array of `n' strings, each holding one entry
+              lens     - lengths of the strings, or NULL if they're all
+                         null-terminated (if given, the strings needn't
+                         be null-terminated, and may contain nulls)
+              n        - number of strings
+              filename - as for bt_parse_entry_s()
+              line     - line number of the start of each string (ditto)
+              options  - standard btparse options bitmap
+@OUTPUT     : entries  - array of `n' ASTs, one per string (NULL where no
+                         entry was found)
+              statuses - (if not NULL) array of `n' success flags, as
+                         for bt_parse_entry_s()
+@RETURNS    : the number of strings parsed without serious errors
+@DESCRIPTION: Parses a whole batch of entries, each in its own string --
+              as bt_parse_entry_s() would, one at a time, but with one
+              parser (and lexical buffer) for the lot, and no cleanup
+              call needed afterwards.
+@GLOBALS    : 
+@CALLS      : parse_next_entry()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+size_t bt_parse_entries_s (const char **  texts,
+                           const size_t * lens,
+                           size_t         n,
+                           char *         filename,
+                           int            line,
+                           ushort         options,
+                           AST **         entries,
+                           boolean *      statuses)
+{
+   bt_parser    parser;
+   boolean      status;
+   size_t       num_ok;
+   size_t       i;
+
+   if (options & BTO_STRINGMASK)        /* any string options set? */
    {
-      if (status) *status = FALSE;
-      return entry_ast;
+      usage_error ("bt_parse_entries_s: illegal options "
+                   "(string options not allowed)");
    }
+   if (n > 0 && (texts == NULL || entries == NULL))
+      usage_error ("bt_parse_entries_s: no texts or entries supplied");
 
-#if DEBUG
-   dump_ast ("bt_parse_entry_s: single entry, after parsing:\n", 
-             entry_ast);
-#endif
-   bt_postprocess_entry (entry_ast,
-                         StringOptions[entry_ast->metatype] | options);
-#if DEBUG
-   dump_ast ("bt_parse_entry_s: single entry, after post-processing:\n",
-             entry_ast);
-#endif
+   memset (&parser, 0, sizeof (parser));
+   parser.filename = filename;
+   parser.line = line;
+   parser.fresh = TRUE;
 
-   if (status) *status = parse_status (err_counts);
-   return entry_ast;
+   num_ok = 0;
+   for (i = 0; i < n; i++)
+   {
+      if (lens == NULL)
+      {
+         parser.instring = (char *) (texts[i] != NULL ? texts[i] : "");
+      }
+      else
+      {
+         parser.inbuf = (texts[i] != NULL) ? texts[i] : "";
+         parser.inbuf_len = (texts[i] != NULL) ? lens[i] : 0;
+      }
+      entries[i] = parse_next_entry (&parser, options, &status);
+      if (statuses) statuses[i] = status;
+      if (status) num_ok++;
+   }
 
-} /* bt_parse_entry_s () */
+   parser.instring = NULL;              /* don't hang on to caller's data */
+   parser.inbuf = NULL;
+   finish_parse (&parser);
+   return num_ok;
+
+} /* bt_parse_entries_s () */
 
 
 /* ------------------------------------------------------------------------
@@ -273,21 +918,26 @@ AST * bt_parse_entry_s (char *    entry_text,
 @OUTPUT     : *top    - AST for the entry, or NULL if no entries left in file
 @RETURNS    : same as bt_parse_entry_s()
 @DESCRIPTION: Starts (or continues) parsing from a file.
-@GLOBALS    : 
-@CALLS      : 
+@GLOBALS    : FileParser
+@CALLS      : parse_next_entry()
 @CREATED    : Jan 1997, GPW
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16 (uses a private, per-thread parser)
 -------------------------------------------------------------------------- */
 AST * bt_parse_entry (FILE *    infile,
                       char *    filename,
                       ushort    options,
                       boolean * status)
 {
-   AST *         entry_ast = NULL;
-   static int *  err_counts = NULL;
-   static FILE * prev_file = NULL;
+   AST *         entry_ast;
+
+   /*
+    * This is the old single-file interface: it keeps one parser per
+    * thread, created on the first call for a given file and freed on
+    * reaching end-of-file.  Code that wants to interleave calls on
+    * different files should use bt_parser_new() and friends instead.
+    */
 
-   if (prev_file != NULL && infile != prev_file)
+   if (FileParser != NULL && infile != FileParser->infile)
    {
       usage_error ("bt_parse_entry: you can't interleave calls "
                    "across different files");
@@ -299,23 +949,15 @@ AST * bt_parse_entry (FILE *    infile,
                    "(string options not allowed)");
    }
 
-   InputFilename = filename;
-   err_counts = bt_get_error_counts (err_counts);
-
-   if (feof (infile))
+   if (FileParser == NULL)
    {
-      if (prev_file != NULL)            /* haven't already done the cleanup */
-      {
-         prev_file = NULL;
-         finish_parse (&err_counts);
-      }
-      else
+      if (feof (infile))
       {
          usage_warning ("bt_parse_entry: second attempt to read past eof");
+         if (status) *status = TRUE;
+         return NULL;
       }
-
-      if (status) *status = TRUE;
-      return NULL;
+      FileParser = bt_parser_new (infile, filename);
    }
 
    /* 
@@ -352,56 +994,79 @@ AST * bt_parse_entry (FILE *    infile,
     * realloc_lex_buffer() (in lex_auxiliary.c), and by rewriting the ZZCOPY
     * macro to call realloc_lex_buffer() when overflow is detected.
     * 
-    * I handle the extra token-read by hanging on to a static file
-    * pointer, prev_file, between calls to bt_parse_entry() -- when
-    * the program starts it is NULL, and we reset it to NULL on
-    * finishing a file.  Thus, any call that is the first on a given
-    * file will allocate the lexical buffer and read the first token;
-    * thereafter, we skip those steps, and free the buffer on reaching
-    * end-of-file.  Currently, this method precludes interleaving
-    * calls to bt_parse_entry() on different files -- perhaps I could
-    * fix this with the zz{save,restore}_{antlr,dlg}_state()
-    * functions?
+    * The extra token-read is handled by the parser object: the first
+    * call on a given parser allocates the lexical buffer and reads the
+    * first token; thereafter, we skip those steps, and free the buffer
+    * on reaching end-of-file.  Interleaving is handled by
+    * activate_parser(), which uses zz{save,restore}_dlg_state() (plus
+    * save_lexer_state() and restore_lexer_state() for our own lexical
+    * state) to swap parsers in and out.
     */
 
-   zzast_sp = ZZAST_STACKSIZE;          /* workaround apparent pccts bug */
-
-#if defined(LL_K) || defined(ZZINF_LOOK) || defined(DEMAND_LOOK)
-# error One of LL_K, ZZINF_LOOK, or DEMAND_LOOK was defined
-#endif
-   if (prev_file == NULL)               /* only read from input stream if */
-   {                                    /* starting afresh with a file */
-      start_parse (infile, NULL, 0);
-      prev_file = infile;
-   }
-   assert (prev_file == infile);
-
-   entry (&entry_ast);                  /* enter the parser */
-   ++zzasp;                             /* why is this done? */
+   FileParser->filename = filename;
+   entry_ast = parse_next_entry (FileParser, options, status);
 
-   if (entry_ast == NULL)               /* can happen with very bad input */
+   if (FileParser->done)                /* hit eof: forget about this file */
    {
-      if (status) *status = FALSE;
-      return entry_ast;
+      bt_parser_free (FileParser);
+      FileParser = NULL;
    }
 
-#if DEBUG
-   dump_ast ("bt_parse_entry(): single entry, after parsing:\n", 
-             entry_ast);
-#endif
-   bt_postprocess_entry (entry_ast,
-                         StringOptions[entry_ast->metatype] | options);
-#if DEBUG
-   dump_ast ("bt_parse_entry(): single entry, after post-processing:\n", 
-             entry_ast);
-#endif
-
-   if (status) *status = parse_status (err_counts);
    return entry_ast;
 
 } /* bt_parse_entry() */
 
 
+/* ------------------------------------------------------------------------
+@NAME       : parse_forest()
+@INPUT      : parser
+              options
+@OUTPUT     : *status - FALSE if any entries had serious errors
+@RETURNS    : linked list of ASTs for all the good entries left in 
+              `parser's input
+@DESCRIPTION: Reads all entries from a parser and links them together
+              (through their `right' pointers).  Entries with serious 
+              errors are omitted from the list.
+@GLOBALS    : 
+@CALLS      : bt_parser_parse_entry()
+@CALLERS    : bt_parse_file(), bt_parse_buffer(), bt_parse_file_mmap()
+@CREATED    : 2026/10/16 (from code in bt_parse_file())
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static AST *
+parse_forest (bt_parser * parser, ushort options, boolean * status)
+{
+   AST *       entries,
+       *       cur_entry, 
+       *       last;
+   boolean     entry_status,
+               overall_status;
+
+   entries = NULL;
+   last = NULL;
+
+   /* explicit loop over entries, with junk cleaned out by read_entry () */
+
+   overall_status = TRUE;              /* assume success */
+   while ((cur_entry = bt_parser_parse_entry
+          (parser, options, &entry_status)))
+   {
+      overall_status &= entry_status;
+      if (!entry_status) continue;      /* bad entry -- try next one */
+      if (!cur_entry) break;            /* at eof -- we're done */
+      if (last == NULL)                 /* this is the first entry */
+         entries = cur_entry;
+      else                              /* have already seen one */
+         last->right = cur_entry;
+
+      last = cur_entry;
+   }
+
+   if (status) *status = overall_status;
+   return entries;
+}
+
+
 /* ------------------------------------------------------------------------
 @NAME       : bt_parse_file ()
 @INPUT      : filename - name of file to open.  If NULL or "-", we read
@@ -414,26 +1079,20 @@ AST * bt_parse_entry (FILE *    infile,
               of ASTs (or, if you like, a forest) for the entries in it.
               (Any entries with serious errors are omitted from the list.)
 @GLOBALS    : 
-@CALLS      : bt_parse_entry()
+@CALLS      : bt_parser_new(), bt_parser_parse_entry(), bt_parser_free()
 @CREATED    : 1997/01/18, from process_file() in bibparse.c
-@MODIFIED   : 
-@COMMENTS   : This function bears a *striking* resemblance to bibparse.c's
-              process_file().  Eventually, I plan to replace this with 
-              a generalized process_file() that takes a function pointer
-              to call for each entry.  Until I decide on the right interface
-              for that, though, I'm sticking with this simpler (but possibly
-              memory-intensive) approach.
+@MODIFIED   : 2026/10/16 (uses its own parser, so doesn't interfere with
+              bt_parse_entry())
+@COMMENTS   : This keeps every entry in the file in memory at once; use
+              bt_process_file() to deal with one entry at a time.
 -------------------------------------------------------------------------- */
 AST * bt_parse_file (char *    filename, 
                      ushort    options, 
                      boolean * status)
 {
-   FILE *  infile;
-   AST *   entries,
-       *   cur_entry, 
-       *   last;
-   boolean entry_status,
-           overall_status;
+   FILE *      infile;
+   bt_parser * parser;
+   AST *       entries;
 
    if (options & BTO_STRINGMASK)        /* any string options set? */
    {
@@ -448,7 +1107,6 @@ AST * bt_parse_file (char *    filename,
 
    if (filename != NULL && strcmp (filename, "-") != 0)
    {
-      InputFilename = filename;
       infile = fopen (filename, "r");
       if (infile == NULL)
       {
@@ -458,30 +1116,14 @@ AST * bt_parse_file (char *    filename,
    }
    else
    {
-      InputFilename = "(stdin)";
+      filename = "(stdin)";
       infile = stdin;
    }
 
-   entries = NULL;
-   last = NULL;
-      
 #if 1
-   /* explicit loop over entries, with junk cleaned out by read_entry () */
-
-   overall_status = TRUE;              /* assume success */
-   while ((cur_entry = bt_parse_entry
-          (infile, InputFilename, options, &entry_status)))
-   {
-      overall_status &= entry_status;
-      if (!entry_status) continue;      /* bad entry -- try next one */
-      if (!cur_entry) break;            /* at eof -- we're done */
-      if (last == NULL)                 /* this is the first entry */
-         entries = cur_entry;
-      else                              /* have already seen one */
-         last->right = cur_entry;
-
-      last = cur_entry;
-   }
+   parser = bt_parser_new (infile, filename);
+   entries = parse_forest (parser, options, status);
+   bt_parser_free (parser);
 
 #else
    /* let the PCCTS lexer/parser handle everything */
@@ -493,7 +1135,373 @@ AST * bt_parse_file (char *    filename,
 
    fclose (infile);
    InputFilename = NULL;
-   if (status) *status = overall_status;
    return entries;
 
 } /* bt_parse_file() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parse_buffer ()
+@INPUT      : buf      - text to parse (need not be null-terminated)
+              len      - number of characters in `buf'
+              filename - for error messages and the ASTs (may be NULL)
+              options
+@OUTPUT     : *status
+@RETURNS    : linked list of ASTs, as for bt_parse_file()
+@DESCRIPTION: Parses all the BibTeX entries in a block of memory, 
+              scanning straight out of it rather than through stdio.
+@GLOBALS    : 
+@CALLS      : bt_parser_new_buffer(), parse_forest(), bt_parser_free()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+AST * bt_parse_buffer (const char * buf,
+                       size_t       len,
+                       char *       filename,
+                       ushort       options,
+                       boolean *    status)
+{
+   bt_parser * parser;
+   AST *       entries;
+
+   if (options & BTO_STRINGMASK)        /* any string options set? */
+   {
+      usage_error ("bt_parse_buffer: illegal options "
+                   "(string options not allowed");
+   }
+
+   parser = bt_parser_new_buffer (buf, len, filename);
+   entries = parse_forest (parser, options, status);
+   bt_parser_free (parser);
+   InputFilename = NULL;
+   return entries;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : forget_offsets()
+@INPUT      : node - a list of ASTs
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Sets the offset of every node in the list, and below it,
+              to -1 (unknown).
+@CALLERS    : parse_chunk()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+forget_offsets (AST * node)
+{
+   for (; node != NULL; node = node->right)
+   {
+      node->offset = -1;
+      forget_offsets (node->down);
+   }
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : parse_chunk()
+@INPUT      : buf      - text to parse (need not be null-terminated)
+              len      - number of characters in `buf'
+              filename - for error messages and the ASTs
+              line     - line number of the start of `buf'
+              offset   - character offset of the start of `buf' 
+                         (offsets beyond INT_MAX don't fit in the AST,
+                         so if the chunk reaches that far, its nodes all
+                         get an offset of -1)
+              options
+@OUTPUT     : *status
+@RETURNS    : linked list of ASTs for the entries in `buf'
+@DESCRIPTION: Like bt_parse_buffer(), but for a piece of a larger buffer:
+              line numbers and offsets in the ASTs and error messages
+              are relative to the whole thing.  The entries are *not*
+              post-processed; the caller must run default_postprocess()
+              over them, in order.
+@GLOBALS    : 
+@CALLS      : bt_parser_new_buffer(), parse_forest(), bt_parser_free()
+@CALLERS    : bt_parse_buffer_parallel() (via its worker threads)
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+AST * parse_chunk (const char * buf,
+                   size_t       len,
+                   char *       filename,
+                   int          line,
+                   size_t       offset,
+                   ushort       options,
+                   boolean *    status)
+{
+   bt_parser * parser;
+   AST *       entries;
+   boolean     too_far;
+
+   too_far = (offset > (size_t) INT_MAX || len > (size_t) INT_MAX - offset);
+   parser = bt_parser_new_buffer (buf, len, filename);
+   parser->line = line;
+   parser->offset = too_far ? 0 : (int) offset;
+   parser->raw = TRUE;
+   entries = parse_forest (parser, options, status);
+   bt_parser_free (parser);
+   InputFilename = NULL;
+   if (too_far)
+      forget_offsets (entries);
+   return entries;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : load_file()
+@INPUT      : filename - file to load (not stdin)
+              writable - whether the caller wants to modify the copy
+@OUTPUT     : *buf     - the file's contents (NULL if the file is empty)
+              *len     - length of the file
+@RETURNS    : FALSE if the file couldn't be opened or read (after
+              printing a message); TRUE otherwise
+@DESCRIPTION: Gets a whole file into memory, with mmap() if the system
+              has it or by reading it into a malloc'd buffer if not.  The
+              buffer must be released with unmap_file().  A writable
+              mapping is still private: changes never reach the file.
+@GLOBALS    : 
+@CALLS      : 
+@CALLERS    : map_file(), map_file_private()
+@CREATED    : 2026/10/16 (from code in bt_parse_file_mmap())
+@MODIFIED   : 2026/10/16 (added `writable', for map_file_private())
+-------------------------------------------------------------------------- */
+static boolean
+load_file (char * filename, char ** buf, size_t * len, boolean writable)
+{
+#if USE_MMAP
+   int         fd;
+   struct stat st;
+
+   fd = open (filename, O_RDONLY);
+   if (fd < 0 || fstat (fd, &st) < 0)
+   {
+      perror (filename);
+      if (fd >= 0) close (fd);
+      return FALSE;
+   }
+
+   *len = (size_t) st.st_size;
+   if (*len == 0)                       /* can't map an empty file */
+   {
+      *buf = NULL;
+   }
+   else
+   {
+      *buf = (char *) mmap (NULL, *len,
+                            writable ? PROT_READ|PROT_WRITE : PROT_READ,
+                            MAP_PRIVATE, fd, 0);
+      if (*buf == (char *) MAP_FAILED)
+      {
+         perror (filename);
+         close (fd);
+         return FALSE;
+      }
+   }
+   close (fd);
+
+#else
+   FILE *      infile;
+   size_t      alloc;
+   size_t      got;
+
+   infile = fopen (filename, "rb");
+   if (infile == NULL)
+   {
+      perror (filename);
+      return FALSE;
+   }
+
+   alloc = 65536;
+   *buf = (char *) malloc (alloc);
+   *len = 0;
+   while ((got = fread (*buf + *len, 1, alloc - *len, infile)) > 0)
+   {
+      *len += got;
+      if (*len == alloc)
+      {
+         alloc *= 2;
+         *buf = (char *) realloc (*buf, alloc);
+      }
+   }
+   fclose (infile);
+#endif
+
+   return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : map_file()
+@INPUT      : filename - file to load (not stdin)
+@OUTPUT     : *buf     - the file's contents (NULL if the file is empty)
+              *len     - length of the file
+@RETURNS    : FALSE if the file couldn't be opened or read (after
+              printing a message); TRUE otherwise
+@DESCRIPTION: Gets a whole file into memory, read-only; see load_file().
+@CALLERS    : bt_parse_file_mmap(), bt_parse_file_parallel(), index.c
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+boolean map_file (char * filename, char ** buf, size_t * len)
+{
+   return load_file (filename, buf, len, FALSE);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : map_file_private()
+@INPUT      : filename - file to load (not stdin)
+@OUTPUT     : *buf, *len - as for map_file()
+@RETURNS    : as for map_file()
+@DESCRIPTION: Like map_file(), but the caller may modify its copy.
+@CALLERS    : load_forest() (in cache.c)
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+boolean map_file_private (char * filename, char ** buf, size_t * len)
+{
+   return load_file (filename, buf, len, TRUE);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : unmap_file()
+@INPUT      : buf, len - as returned by map_file()
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Releases a file loaded by map_file().
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+void unmap_file (char * buf, size_t len)
+{
+   if (buf == NULL) return;
+#if USE_MMAP
+   munmap (buf, len);
+#else
+   free (buf);
+#endif
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parse_file_mmap ()
+@INPUT      : filename - name of file to parse; NULL or "-" means stdin
+              options
+@OUTPUT     : *status
+@RETURNS    : linked list of ASTs, as for bt_parse_file()
+@DESCRIPTION: Same as bt_parse_file(), but maps the whole file into memory
+              and parses it with bt_parse_buffer(), which avoids the
+              per-character overhead of stdio.  On systems without 
+              mmap(), the file is read into memory in one go instead.
+              Stdin can't be mapped, so it's handed to bt_parse_file().
+@GLOBALS    : 
+@CALLS      : map_file(), bt_parse_buffer(), unmap_file(), bt_parse_file()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+AST * bt_parse_file_mmap (char *    filename,
+                          ushort    options,
+                          boolean * status)
+{
+   AST *       entries;
+   char *      buf;
+   size_t      len;
+
+   if (options & BTO_STRINGMASK)        /* any string options set? */
+   {
+      usage_error ("bt_parse_file_mmap: illegal options "
+                   "(string options not allowed");
+   }
+
+   if (filename == NULL || strcmp (filename, "-") == 0)
+      return bt_parse_file (filename, options, status);
+
+   if (! map_file (filename, &buf, &len))
+      return NULL;
+   entries = bt_parse_buffer (buf, len, filename, options, status);
+   unmap_file (buf, len);
+   return entries;
+
+} /* bt_parse_file_mmap() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_process_file ()
+@INPUT      : filename - name of file to read; NULL or "-" means stdin
+              options  - standard btparse options bitmap
+              callback - function to call for each entry
+              data     - passed to `callback' untouched
+@OUTPUT     : 
+@RETURNS    : FALSE if the file couldn't be opened or any entries had
+              serious errors; TRUE otherwise
+@DESCRIPTION: Reads, parses and post-processes a file one entry at a
+              time, handing each entry to `callback' as soon as it's
+              complete.  `callback' gets the entry, its status (as for
+              bt_parse_entry()), and `data'; it returns BTCB_KEEP if it
+              wants to hang on to the entry (in which case it's
+              responsible for freeing it), and BTCB_STOP to stop reading
+              the file.  Any entry not kept is freed once the callback
+              returns, so only one entry is in memory at a time.
+@GLOBALS    : 
+@CALLS      : bt_parser_new(), bt_parser_parse_entry(), bt_parser_free()
+@CREATED    : 2026/10/16 (generalized from process_file() in bibparse.c)
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+boolean bt_process_file (char *            filename,
+                         ushort            options,
+                         bt_entry_callback callback,
+                         void *            data)
+{
+   FILE *      infile;
+   bt_parser * parser;
+   AST *       entry;
+   boolean     entry_status,
+               overall_status;
+   int         action;
+
+   if (options & BTO_STRINGMASK)        /* any string options set? */
+   {
+      usage_error ("bt_process_file: illegal options "
+                   "(string options not allowed");
+   }
+   if (callback == NULL)
+      usage_error ("bt_process_file: no callback supplied");
+
+   if (filename != NULL && strcmp (filename, "-") != 0)
+   {
+      infile = fopen (filename, "r");
+      if (infile == NULL)
+      {
+         perror (filename);
+         return FALSE;
+      }
+   }
+   else
+   {
+      filename = "(stdin)";
+      infile = stdin;
+   }
+
+   parser = bt_parser_new (infile, filename);
+   overall_status = TRUE;               /* assume success */
+   while ((entry = bt_parser_parse_entry (parser, options, &entry_status)))
+   {
+      overall_status &= entry_status;
+      action = (*callback) (entry, entry_status, data);
+      if (! (action & BTCB_KEEP))
+         bt_free_ast (entry);
+      if (action & BTCB_STOP)
+         break;
+   }
+   bt_parser_free (parser);
+
+   if (infile != stdin)
+      fclose (infile);
+   InputFilename = NULL;
+   return overall_status;
+
+} /* bt_process_file() */
@@ -32,9 +32,15 @@
 #include "bt_config.h"
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <ctype.h>
 #include <stdarg.h>
 #include <assert.h>
+#if defined(__AVX2__)
+# include <immintrin.h>
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+#endif
 #include "lex_auxiliary.h"
 #include "stdpccts.h"
 #include "error.h"
@@ -43,12 +49,14 @@
 
 #define DUPE_TEXT 0
 
-extern char * InputFilename;            /* from input.c */
+extern BT_THREAD_LOCAL char * InputFilename; /* from input.c */
 
 GEN_PRIVATE_ERRFUNC (lexical_warning, (char * fmt, ...),
-                     BTERR_LEXWARN, InputFilename, zzline, NULL, -1, fmt)
+                     BTERR_LEXWARN, InputFilename, zzline, zzbegcol,
+                     NULL, -1, fmt)
 GEN_PRIVATE_ERRFUNC (lexical_error, (char * fmt, ...),
-                     BTERR_LEXERR, InputFilename, zzline, NULL, -1, fmt)
+                     BTERR_LEXERR, InputFilename, zzline, zzbegcol,
+                     NULL, -1, fmt)
 
 
 
@@ -56,8 +64,36 @@ GEN_PRIVATE_ERRFUNC (lexical_error, (char * fmt, ...),
  * Global variables
  */
 
+/* 
+ * All of the lexical state is thread-local (BT_THREAD_LOCAL, from
+ * bt_config.h), so that each thread scans its own input.  Within one
+ * thread, save_lexer_state() and restore_lexer_state() let several
+ * parsers (see input.c) take turns with it.
+ */
+
 /* First, the lexical buffer.  This is used elsewhere, so can't be static */
-char *         zztoktext = NULL;
+BT_THREAD_LOCAL char * zztoktext = NULL;
+
+/*
+ * If KeepLexBuffer is set (by bt_keep_lex_buffer()), free_lex_buffer()
+ * hangs on to the buffer as SpareBuffer (of SpareSize characters)
+ * rather than freeing it, and the next alloc_lex_buffer() takes it back.
+ * That way a buffer that has grown to hold some huge token isn't thrown
+ * away and grown all over again for the next string or file.
+ */
+static BT_THREAD_LOCAL boolean KeepLexBuffer = FALSE;
+static BT_THREAD_LOCAL char *  SpareBuffer = NULL;
+static BT_THREAD_LOCAL int     SpareSize = 0;
+
+/*
+ * Number of times the lexical buffer has overflowed since the scanner
+ * was started (see lexer_overflow()); only the first few are reported.
+ * Unlike the rest of the lexical state, this isn't reset at the end of
+ * each entry, only by reset_overflow_count() when a parse starts.
+ */
+#define MAX_OVERFLOW_NOTIFY 3
+
+static BT_THREAD_LOCAL int OverflowCount;
 
 /* 
  * Now, the lexical state -- first, stuff that arises from scanning 
@@ -93,12 +129,16 @@ char *         zztoktext = NULL;
  *     the beginning of entry, to help people catch "old style" implicit
  *     comments
  */
-static enum { toplevel, after_at, after_type, in_comment, in_entry } 
+enum entry_state { toplevel, after_at, after_type, in_comment, in_entry };
+
+static BT_THREAD_LOCAL enum entry_state
                EntryState;
-static char    EntryOpener;             /* '(' or '{' */
-static bt_metatype
+static BT_THREAD_LOCAL char
+               EntryOpener;             /* '(' or '{' */
+static BT_THREAD_LOCAL bt_metatype
                EntryMetatype;
-static int     JunkCount;               /* non-whitespace chars at toplevel */
+static BT_THREAD_LOCAL int
+               JunkCount;               /* non-whitespace chars at toplevel */
 
 /*
  * String state -- these are maintained and used by the functions called
@@ -128,12 +168,18 @@ static int     JunkCount;               /* non-whitespace chars at toplevel */
  *
  * (See bibtex.g for an explanation of my runaway string detection heuristic.)
  */
-static char    StringOpener = '\0';     /* '{' or '"' */
-static int     BraceDepth;              /* depth of brace-nesting */
-static int     ParenDepth;              /* depth of parenthesis-nesting */
-static int     StringStart = -1;        /* start line of current string */
-static int     ApparentRunaway;         /* current string looks like runaway */
-static int     QuoteWarned;             /* already warned about " in string? */
+static BT_THREAD_LOCAL char
+               StringOpener = '\0';     /* '{' or '"' */
+static BT_THREAD_LOCAL int
+               BraceDepth;              /* depth of brace-nesting */
+static BT_THREAD_LOCAL int
+               ParenDepth;              /* depth of parenthesis-nesting */
+static BT_THREAD_LOCAL int
+               StringStart = -1;        /* start line of current string */
+static BT_THREAD_LOCAL int
+               ApparentRunaway;         /* current string looks like runaway */
+static BT_THREAD_LOCAL int
+               QuoteWarned;             /* already warned about " in string? */
 
 
 
@@ -192,6 +238,8 @@ void zzd_attr (Attrib *attr)
  *   alloc_lex_buffer()
  *   realloc_lex_buffer()
  *   free_lex_buffer()
+ *   free_spare_lex_buffer()
+ *   bt_keep_lex_buffer()
  *   lexer_overflow()
  *   zzcopy()              (only if ZZCOPY_FUNCTION is defined and true)
  */
@@ -201,19 +249,35 @@ void zzd_attr (Attrib *attr)
  * alloc_lex_buffer()
  * 
  * allocates the lexical buffer with `size' characters.  Clears the buffer,
- * points zzlextext at it, and sets zzbufsize to `size'.
+ * points zzlextext at it, and sets zzbufsize to `size'.  If there's a
+ * spare buffer (see free_lex_buffer()) at least that big, uses it instead
+ * (and sets zzbufsize to its size).
  *
  * Does nothing if the buffer is already allocated.
  *
- * globals: zztoktext, zzlextext, zzbufsize
+ * globals: zztoktext, zzlextext, zzbufsize, SpareBuffer, SpareSize
  * callers: bt_parse_entry() (in input.c)
  */
 void alloc_lex_buffer (int size)
 {
    if (zztoktext == NULL)
    {
-      zztoktext = (char *) malloc (size * sizeof (char));
-      memset (zztoktext, 0, size);
+      if (SpareBuffer != NULL && SpareSize >= size)
+      {
+         zztoktext = SpareBuffer;
+         zztoktext[0] = (char) 0;
+         size = SpareSize;
+         SpareBuffer = NULL;
+         SpareSize = 0;
+      }
+      else
+      {
+         free_spare_lex_buffer ();
+         zztoktext = (char *) malloc (size * sizeof (char));
+         if (zztoktext == NULL)
+            internal_error ("out of memory allocating lexical buffer");
+         memset (zztoktext, 0, size);
+      }
       zzlextext = zztoktext;
       zzbufsize = size;
    }
@@ -251,7 +315,11 @@ realloc_lex_buffer (int     size_increment,
       internal_error ("attempt to reallocate unallocated lexical buffer");
 
    zztoktext = (char *) realloc (zztoktext, zzbufsize+size_increment);
-   memset (zztoktext+zzbufsize, 0, size_increment);
+   if (zztoktext == NULL)
+      internal_error ("out of memory growing lexical buffer");
+   COUNT (lex_reallocs);
+   if (size_increment > 0)
+      memset (zztoktext+zzbufsize, 0, size_increment);
    zzbufsize += size_increment;
 
    beg = zzbegexpr - zzlextext;
@@ -271,7 +339,16 @@ realloc_lex_buffer (int     size_increment,
 /*
  * free_lex_buffer()
  *
- * Frees the lexical buffer allocated by alloc_lex_buffer().
+ * Frees the lexical buffer allocated by alloc_lex_buffer() -- or, if
+ * bt_keep_lex_buffer() asked for it, keeps it as the spare buffer for
+ * the next alloc_lex_buffer().
+ *
+ * free_spare_lex_buffer()
+ *
+ * Frees the spare buffer, if there is one.
+ *
+ * globals: zztoktext, zzbufsize, KeepLexBuffer, SpareBuffer, SpareSize
+ * callers: finish_parse() (in input.c); bt_cleanup()
  */
 void free_lex_buffer (void)
 {
@@ -279,22 +356,72 @@ void free_lex_buffer (void)
       internal_error ("attempt to free unallocated (or already freed) " 
                       "lexical buffer");
 
-   free (zztoktext);
+   if (KeepLexBuffer && zzbufsize >= SpareSize)
+   {
+      free_spare_lex_buffer ();
+      SpareBuffer = zztoktext;
+      SpareSize = zzbufsize;
+   }
+   else
+   {
+      free (zztoktext);
+   }
    zztoktext = NULL;
 } /* free_lex_buffer() */
 
 
+void free_spare_lex_buffer (void)
+{
+   if (SpareBuffer != NULL)
+      free (SpareBuffer);
+   SpareBuffer = NULL;
+   SpareSize = 0;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_keep_lex_buffer()
+@INPUT      : keep - TRUE to keep the lexical buffer between parses
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: The lexical buffer holds the text of the current token,
+              and grows as needed to fit the longest one.  Normally it's
+              freed when the parser is done with its input (at end of
+              file, or when bt_parse_entry_s() is called with a NULL
+              string), and the next parse starts again with a small one.
+              If `keep' is TRUE, the buffer is kept instead and used
+              again by the next parse in the same thread -- which saves
+              growing it over and over if the input has huge values.
+              Setting `keep' back to FALSE frees the kept buffer; so does
+              bt_cleanup().  Only affects the current thread.
+@GLOBALS    : KeepLexBuffer
+@CALLS      : free_spare_lex_buffer()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+void bt_keep_lex_buffer (boolean keep)
+{
+   KeepLexBuffer = keep;
+   if (! keep)
+      free_spare_lex_buffer ();
+}
+
+
 /*
  * lexer_overflow()
  *
- * Prints a warning and calls realloc_lex_buffer() to increase the size
- * of the lexical buffer by ZZLEXBUFSIZE (a constant -- hence the buffer
- * size increases linearly, not exponentially).
+ * Calls realloc_lex_buffer() to double the size of the lexical buffer
+ * (so that a token of n characters costs O(n) copying all told, not
+ * O(n^2)), and prints a notification about it -- but only for the first
+ * few overflows since the scanner was started, since a really big token
+ * could otherwise cause a stream of them.
  *
  * Also prints a couple of lines of useful debugging stuff if DEBUG is true.
  */ 
 void lexer_overflow (unsigned char **lastpos, unsigned char **nextpos)
 {
+   int   increment;
+
 #if DEBUG
    char   head[16], tail[16];
 
@@ -302,17 +429,26 @@ void lexer_overflow (unsigned char **lastpos, unsigned char **nextpos)
    printf ("        zzbegcol=%d, zzendcol=%d, zzline=%d\n",
            zzbegcol, zzendcol, zzline);
    strncpy (head, zzlextext, 15); head[15] = 0;
-   strncpy (tail, zzlextext+ZZLEXBUFSIZE-15, 15); tail[15] = 0;
+   strncpy (tail, zzlextext+zzbufsize-15, 15); tail[15] = 0;
    printf ("        zzlextext=>%s...%s< (last char=%d (%c))\n",
            head, tail, 
-           zzlextext[ZZLEXBUFSIZE-1], zzlextext[ZZLEXBUFSIZE-1]);
+           zzlextext[zzbufsize-1], zzlextext[zzbufsize-1]);
    printf ("        zzchar = %d (%c), zzbegexpr=zzlextext+%d\n",
            zzchar, zzchar, zzbegexpr-zzlextext);
 #endif
 
-   notify ("lexical buffer overflowed (reallocating to %d bytes)",
-                    zzbufsize+ZZLEXBUFSIZE);
-   realloc_lex_buffer (ZZLEXBUFSIZE, lastpos, nextpos);
+   increment = (zzbufsize < INT_MAX / 2) ? zzbufsize : INT_MAX - zzbufsize;
+   if (increment <= 0)
+      internal_error ("lexical buffer overflowed (token too long)");
+
+   OverflowCount++;
+   if (OverflowCount < MAX_OVERFLOW_NOTIFY)
+      notify ("lexical buffer overflowed (reallocating to %d bytes)",
+              zzbufsize+increment);
+   else if (OverflowCount == MAX_OVERFLOW_NOTIFY)
+      notify ("lexical buffer overflowed (reallocating to %d bytes; "
+              "won't report any more)", zzbufsize+increment);
+   realloc_lex_buffer (increment, lastpos, nextpos);
 
 } /* lexer_overflow () */
 
@@ -342,6 +478,8 @@ void zzcopy (char **nextpos, char **lastpos, int *ovf_flag)
  * Report/maintain lexical state 
  *   report_state()        (only meaningful if DEBUG)
  *   initialize_lexer_state()
+ *   save_lexer_state()
+ *   restore_lexer_state()
  *
  * Note that the lexical action functions, below, also fiddle with
  * the lexical state variables an awful lot.
@@ -379,12 +517,77 @@ void initialize_lexer_state (void)
 }
 
 
+void reset_overflow_count (void)
+{
+   OverflowCount = 0;
+}
+
+
 bt_metatype entry_metatype (void)
 {
    return EntryMetatype;
 }
 
 
+/*
+ * save_lexer_state()
+ *
+ * Copies the lexical state (including the lexical buffer pointer) into
+ * `state', and forgets about the buffer -- it now belongs to `state', and
+ * the next call to alloc_lex_buffer() will allocate a fresh one.
+ *
+ * restore_lexer_state()
+ *
+ * Undoes save_lexer_state(): reinstates the lexical state and buffer
+ * from `state'.  Any buffer currently allocated must already have been
+ * saved or freed.
+ *
+ * Neither of these touches the DLG state; use zzsave_dlg_state() and
+ * zzrestore_dlg_state() for that.
+ *
+ * callers: suspend_parser(), activate_parser() (in input.c)
+ */
+void save_lexer_state (lex_state *state)
+{
+   state->toktext = zztoktext;
+   state->entry_state = (int) EntryState;
+   state->entry_opener = EntryOpener;
+   state->entry_metatype = EntryMetatype;
+   state->junk_count = JunkCount;
+   state->string_opener = StringOpener;
+   state->brace_depth = BraceDepth;
+   state->paren_depth = ParenDepth;
+   state->string_start = StringStart;
+   state->apparent_runaway = ApparentRunaway;
+   state->quote_warned = QuoteWarned;
+   state->overflow_count = OverflowCount;
+
+   zztoktext = NULL;
+}
+
+
+void restore_lexer_state (lex_state *state)
+{
+   if (zztoktext != NULL)
+      internal_error ("restore_lexer_state: lexical buffer still in use");
+
+   zztoktext = state->toktext;
+   EntryState = (enum entry_state) state->entry_state;
+   EntryOpener = state->entry_opener;
+   EntryMetatype = state->entry_metatype;
+   JunkCount = state->junk_count;
+   StringOpener = state->string_opener;
+   BraceDepth = state->brace_depth;
+   ParenDepth = state->paren_depth;
+   StringStart = state->string_start;
+   ApparentRunaway = state->apparent_runaway;
+   QuoteWarned = state->quote_warned;
+   OverflowCount = state->overflow_count;
+
+   state->toktext = NULL;
+}
+
+
 
 /* ----------------------------------------------------------------------
  * Lexical actions (START and LEX_ENTRY modes)
@@ -576,6 +779,90 @@ void rparen (void)
  */
 
 
+/*
+ * string_run_span ()
+ *
+ * Returns the number of characters at `s' before the first one that
+ * ends a run of ordinary string text (see STRING_STOP_CHAR in
+ * lex_auxiliary.h), looking no further than `end' -- or, if `end' is
+ * NULL, than the null that terminates `s'.  This is where the scanner
+ * spends most of its time on real files, so with SSE2 or AVX2 we look
+ * at 16 or 32 characters at a time; strcspn() does the same for us (in
+ * any decent C library) when there's no `end'.
+ *
+ * callers: zzrun() (in pccts/dlgauto.h, via ZZRUN_SPAN)
+ */
+size_t string_run_span (const unsigned char *s, const unsigned char *end)
+{
+   const unsigned char * p = s;
+
+   if (end == NULL)
+      return strcspn ((const char *) s, "\n{}()\"");
+
+#if defined(__AVX2__)
+   {
+      __m256i  nl = _mm256_set1_epi8 ('\n');
+      __m256i  lb = _mm256_set1_epi8 ('{');
+      __m256i  rb = _mm256_set1_epi8 ('}');
+      __m256i  lp = _mm256_set1_epi8 ('(');
+      __m256i  rp = _mm256_set1_epi8 (')');
+      __m256i  qu = _mm256_set1_epi8 ('"');
+      __m256i  v;
+      unsigned int mask;
+
+      while (end - p >= 32)
+      {
+         v = _mm256_loadu_si256 ((const __m256i *) p);
+         mask = (unsigned int) _mm256_movemask_epi8
+            (_mm256_or_si256
+             (_mm256_or_si256 (_mm256_or_si256 (_mm256_cmpeq_epi8 (v, nl),
+                                                _mm256_cmpeq_epi8 (v, qu)),
+                               _mm256_or_si256 (_mm256_cmpeq_epi8 (v, lb),
+                                                _mm256_cmpeq_epi8 (v, rb))),
+              _mm256_or_si256 (_mm256_cmpeq_epi8 (v, lp),
+                               _mm256_cmpeq_epi8 (v, rp))));
+         if (mask != 0)
+            return (p - s) + __builtin_ctz (mask);
+         p += 32;
+      }
+   }
+#endif
+#if defined(__SSE2__)
+   {
+      __m128i  nl = _mm_set1_epi8 ('\n');
+      __m128i  lb = _mm_set1_epi8 ('{');
+      __m128i  rb = _mm_set1_epi8 ('}');
+      __m128i  lp = _mm_set1_epi8 ('(');
+      __m128i  rp = _mm_set1_epi8 (')');
+      __m128i  qu = _mm_set1_epi8 ('"');
+      __m128i  v;
+      unsigned int mask;
+
+      while (end - p >= 16)
+      {
+         v = _mm_loadu_si128 ((const __m128i *) p);
+         mask = (unsigned int) _mm_movemask_epi8
+            (_mm_or_si128
+             (_mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (v, nl),
+                                          _mm_cmpeq_epi8 (v, qu)),
+                            _mm_or_si128 (_mm_cmpeq_epi8 (v, lb),
+                                          _mm_cmpeq_epi8 (v, rb))),
+              _mm_or_si128 (_mm_cmpeq_epi8 (v, lp),
+                            _mm_cmpeq_epi8 (v, rp))));
+         if (mask != 0)
+            return (p - s) + __builtin_ctz (mask);
+         p += 16;
+      }
+   }
+#endif
+
+   while (p < end && ! STRING_STOP_CHAR (*p))
+      p++;
+   return p - s;
+
+} /* string_run_span () */
+
+
 /*
  * start_string ()
  *
@@ -19,6 +19,7 @@
 
 #include "btparse.h"
 #include "attrib.h"
+#include "stats.h"
 
 #define ZZCOPY_FUNCTION 0
 
@@ -33,6 +34,60 @@
    *(zznextpos++) = zzchar;
 #endif
 
+/*
+ * Inside strings, most of the text is matched by the catch-all rule in
+ * bibtex.g (anything but newline, braces, parens, or quote) and just
+ * zzmore()'d; let the scanner copy such runs in bulk (see zzrun() in
+ * pccts/dlgauto.h).  A run can't start with a tab or CR, because a lone
+ * one of those is matched by its own rule -- but it can contain them.
+ * Keep this in step with the LEX_STRING rules in bibtex.g!
+ */
+#define STRING_STOP_CHAR(c) \
+   ((c) == '\n' || (c) == '{' || (c) == '}' || \
+    (c) == '(' || (c) == ')' || (c) == '"')
+
+#define ZZRUN_MODE              LEX_STRING
+#define ZZRUN_START(c) \
+   (! STRING_STOP_CHAR (c) && (c) != '\t' && (c) != '\r')
+#define ZZRUN_STOP(c)           STRING_STOP_CHAR (c)
+#define ZZRUN_SPAN(s,end)       string_run_span (s, end)
+#define ZZRUN_OVERFLOW(lp,np)   lexer_overflow (lp, np)
+
+/*
+ * With --enable-stats, count what the scanner does, and the AST nodes
+ * that the parser allocates (see pccts/dlgauto.h and pccts/ast.c).  This
+ * is called for every token, so it's just a count; the time is taken
+ * once per entry, in parse_next_entry().
+ */
+#if BT_STATS
+# define ZZGETTOK_END           COUNT (tokens)
+# define ZZLEXED(n)             COUNT_N (bytes_lexed, n)
+# define zzastcount()           COUNT (ast_nodes)
+#endif
+
+
+/* 
+ * The lexical state that lives in lex_auxiliary.c, bundled up so that
+ * input.c can switch between several parsers in one thread.  (The DLG
+ * state -- zzline, zzchar and friends -- is saved separately, in a
+ * struct zzdlg_state.)
+ */
+typedef struct
+{
+   char *       toktext;                /* the lexical buffer */
+   int          entry_state;
+   char         entry_opener;
+   bt_metatype  entry_metatype;
+   int          junk_count;
+   char         string_opener;
+   int          brace_depth;
+   int          paren_depth;
+   int          string_start;
+   int          apparent_runaway;
+   int          quote_warned;
+   int          overflow_count;
+} lex_state;
+
 
 /* Function prototypes: */
 
@@ -41,13 +96,18 @@ void zzcr_attr (Attrib *a, int tok, char *txt);
 
 void alloc_lex_buffer (int size);
 void free_lex_buffer (void);
+void free_spare_lex_buffer (void);
 void lexer_overflow (unsigned char **lastpos, unsigned char **nextpos);
 #if ZZCOPY_FUNCTION
 void zzcopy (char **nextpos, char **lastpos, int *ovf_flag);
 #endif
+size_t string_run_span (const unsigned char *s, const unsigned char *end);
 
 void initialize_lexer_state (void);
+void reset_overflow_count (void);
 bt_metatype entry_metatype (void);
+void save_lexer_state (lex_state *state);
+void restore_lexer_state (lex_state *state);
 
 void newline (void);
 void comment (void);
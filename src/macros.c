@@ -1,7 +1,7 @@
 /* ------------------------------------------------------------------------
 @NAME       : macros.c
-@DESCRIPTION: Front-end to the standard PCCTS symbol table code (sym.c)
-              to abstract my "macro table".
+@DESCRIPTION: The "macro table": a hash table mapping macro names
+              (case-insensitively) to their expansion text.
 @GLOBALS    : 
 @CALLS      : 
 @CREATED    : 1997/01/12, Greg Ward
@@ -18,37 +18,59 @@
 #include "bt_config.h"
 #include <stdlib.h>
 #include <string.h>
-#include "sym.h"
+#include <ctype.h>
+#include "btparse.h"
 #include "prototypes.h"
 #include "error.h"
+#include "stats.h"
 #include "my_dmalloc.h"
 #include "bt_debug.h"
 
 
 /*
- * NUM_MACROS and STRING_SIZE define the size of the static data
- * structure that holds the macro table.  The defaults are to allocate
- * 4096 bytes of string space that will be divided up amongst 547
- * macros.  This should be fine for most applications, but if you have a
- * big macro table you might need to change these and recompile (don't
- * forget to rebuild and reinstall Text::BibTeX if you're using it!).
- * You can set these as high as you like; just remember that a block of
- * STRING_SIZE bytes will be allocated and not freed as long as you're
- * using btparse.  Also, NUM_MACROS defines the size of a hashtable, so
- * it should probably be a prime a bit greater than a power of 2 -- or
- * something like that.  I'm not sure of the exact Knuthian
- * specification.
+ * The macro table is a hash table with open addressing (linear probing).
+ * It starts with INITIAL_SIZE slots and doubles whenever it gets more
+ * than half full, so there's no limit on the number of macros.  Macro
+ * names are copied into an arena belonging to the table (they're
+ * usually short, and never change), and their expansion text is
+ * strdup()'d.  Deleting a macro shifts back any later entries in the
+ * same cluster rather than leaving a tombstone, so deletions don't slow
+ * down later lookups.  The arena only gives back the names of deleted
+ * macros when the whole table is emptied, but redefining a macro reuses
+ * its existing slot and name.
  */
-#define NUM_MACROS 547
-#define STRING_SIZE 4096
+#define INITIAL_SIZE    512             /* must be a power of 2 */
+#define NAME_BLOCK_SIZE 8192            /* arena block size for names */
 
-Sym *AllMacros = NULL;                  /* `scope' so we can get back list */
-                                        /* of all macros when done */
+typedef struct
+{
+   char *       name;                   /* NULL if slot empty */
+   char *       text;
+   unsigned int hash;
+} macro_slot;
+
+typedef struct
+{
+   macro_slot * slots;
+   unsigned int size;                   /* number of slots */
+   unsigned int count;                  /* number in use */
+   bt_arena *   names;                  /* where the names live */
+} macro_table;
+
+/* 
+ * The macro table is per-thread: each thread that parses BibTeX data
+ * gets its own, created on first use (or by bt_initialize()) and freed
+ * by bt_cleanup() -- which every such thread must call before exiting,
+ * or its table leaks.  No thread sees another's macros.
+ */
+static BT_THREAD_LOCAL macro_table Macros = { NULL, 0, 0, NULL };
+
+#define CHECK_MACRO_TABLE() if (Macros.slots == NULL) init_macros ()
 
 
 GEN_PRIVATE_ERRFUNC (macro_warning,
                      (char * filename, int line, char * fmt, ...),
-                     BTERR_CONTENT, filename, line, NULL, -1, fmt)
+                     BTERR_CONTENT, filename, line, -1, NULL, -1, fmt)
 
 
 /* ------------------------------------------------------------------------
@@ -56,17 +78,26 @@ GEN_PRIVATE_ERRFUNC (macro_warning,
 @INPUT      : 
 @OUTPUT     : 
 @RETURNS    : 
-@DESCRIPTION: Initializes the symbol table used to store macro values.
-@GLOBALS    : AllMacros
-@CALLS      : zzs_init(), zzs_scope() (sym.c)
+@DESCRIPTION: Initializes the hash table used to store macro values
+              (for the current thread).  Does nothing if that's already
+              been done.
+@GLOBALS    : Macros
+@CALLS      : 
 @CALLERS    : bt_initialize() (init.c)
+              everything else in this file, via CHECK_MACRO_TABLE()
 @CREATED    : Jan 1997, GPW
+@MODIFIED   : 2026/10/16 (own hash table instead of sym.c)
 -------------------------------------------------------------------------- */
 void
 init_macros (void)
 {
-   zzs_init (NUM_MACROS, STRING_SIZE);
-   zzs_scope (&AllMacros);
+   if (Macros.slots != NULL) return;
+   Macros.slots = (macro_slot *) calloc (INITIAL_SIZE, sizeof (macro_slot));
+   if (Macros.slots == NULL)
+      internal_error ("out of memory allocating macro table");
+   Macros.size = INITIAL_SIZE;
+   Macros.count = 0;
+   Macros.names = NULL;
 }
 
 
@@ -75,60 +106,179 @@ init_macros (void)
 @INPUT      : 
 @OUTPUT     : 
 @RETURNS    : 
-@DESCRIPTION: Frees up all the macro values in the symbol table, and 
-              then frees up the symbol table itself.
-@GLOBALS    : AllMacros
-@CALLS      : zzs_rmscope(), zzs_done()
+@DESCRIPTION: Frees up all the macro values in the hash table, and 
+              then frees up the table itself.
+@GLOBALS    : Macros
+@CALLS      : bt_delete_all_macros()
 @CALLERS    : bt_cleanup() (init.c)
 @CREATED    : Jan 1997, GPW
+@MODIFIED   : 2026/10/16 (own hash table instead of sym.c)
 -------------------------------------------------------------------------- */
 void
 done_macros (void)
 {
+   if (Macros.slots == NULL) return;
    bt_delete_all_macros ();
-   zzs_done ();
+   free (Macros.slots);
+   Macros.slots = NULL;
+   Macros.size = 0;
 }
 
 
-static void
-delete_macro_entry (Sym * sym)
+/* ------------------------------------------------------------------------
+@NAME       : hash_name()
+@INPUT      : name - a macro name
+@OUTPUT     : 
+@RETURNS    : hash value of `name', ignoring case
+@DESCRIPTION: FNV-1a hash of the lowercased name.
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static unsigned int
+hash_name (const char * name)
 {
-   Sym * cur;
-   Sym * prev;
+   unsigned int  hash = 2166136261U;
 
-   /* 
-    * Yechh!  All this mucking about with the scope list really
-    * ought to be handled by the symbol table code.  Must write
-    * my own someday.
-    */
+   while (*name)
+   {
+      hash ^= (unsigned char) tolower ((unsigned char) *name++);
+      hash *= 16777619U;
+   }
+   return hash;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : find_slot()
+@INPUT      : name - macro name to look for
+              hash - hash_name (name)
+@OUTPUT     : 
+@RETURNS    : the slot holding `name' if it's in the table, otherwise
+              the empty slot where it would go
+@GLOBALS    : Macros
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static macro_slot *
+find_slot (const char * name, unsigned int hash)
+{
+   unsigned int  mask = Macros.size - 1;
+   unsigned int  i;
 
-   /* Find this entry in the list of all macro table entries */
-   cur = AllMacros;
-   prev = NULL;
-   while (cur != NULL && cur != sym)
+   for (i = hash & mask; Macros.slots[i].name != NULL; i = (i + 1) & mask)
    {
-      prev = cur;
-      cur = cur->scope;
+      if (Macros.slots[i].hash == hash &&
+          strcasecmp (Macros.slots[i].name, name) == 0)
+         break;
    }
+   return &Macros.slots[i];
+}
 
-   if (cur == NULL)                     /* uh-oh -- wasn't found! */
+
+/* ------------------------------------------------------------------------
+@NAME       : lookup_macro()
+@INPUT      : macro - macro name
+@OUTPUT     : 
+@RETURNS    : the slot holding `macro', or NULL if it's undefined
+@GLOBALS    : Macros, ParseStats
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static macro_slot *
+lookup_macro (const char * macro)
+{
+   macro_slot * slot;
+
+   CHECK_MACRO_TABLE ();
+   slot = find_slot (macro, hash_name (macro));
+   COUNT (macro_lookups);
+   if (slot->name == NULL)
+      return NULL;
+   COUNT (macro_hits);
+   return slot;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : grow_table()
+@INPUT      : 
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Doubles the size of the macro table and rehashes
+              everything in it.  (Names and text stay where they are.)
+@GLOBALS    : Macros
+@CALLERS    : bt_add_macro_text()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static void
+grow_table (void)
+{
+   macro_slot *  old_slots = Macros.slots;
+   unsigned int  old_size = Macros.size;
+   unsigned int  i;
+
+   Macros.slots = (macro_slot *) calloc (old_size * 2, sizeof (macro_slot));
+   if (Macros.slots == NULL)
+      internal_error ("out of memory growing macro table");
+   Macros.size = old_size * 2;
+
+   for (i = 0; i < old_size; i++)
    {
-      internal_error ("macro table entry for \"%s\" not found in scope list",
-                      sym->symbol);
+      if (old_slots[i].name != NULL)
+         *find_slot (old_slots[i].name, old_slots[i].hash) = old_slots[i];
    }
+   free (old_slots);
+}
 
-   /* Now unlink from the "scope" list */
-   if (prev == NULL)                    /* it's the head of the list */
-      AllMacros = cur->scope;
-   else
-      prev->scope = cur->scope;
 
-   /* Remove it from the macro hash table */
-   zzs_del (sym);
+/* ------------------------------------------------------------------------
+@NAME       : delete_macro_entry()
+@INPUT      : slot - the slot holding the macro to delete
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Removes a macro from the table, and frees its text.  Any
+              entries after it in the same run of full slots that would
+              no longer be found (because they're past their home slot)
+              are moved back to fill the gap, so there's no need for
+              "deleted" markers.
+@GLOBALS    : Macros
+@CALLERS    : bt_delete_macro()
+@CREATED    : 2026/10/16 (formerly fiddled with sym.c's scope list)
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static void
+delete_macro_entry (macro_slot * slot)
+{
+   unsigned int  mask = Macros.size - 1;
+   unsigned int  hole,
+                 i,
+                 home;
+
+   if (slot->text) free (slot->text);
+
+   hole = i = slot - Macros.slots;
+   for (;;)
+   {
+      i = (i + 1) & mask;
+      if (Macros.slots[i].name == NULL)
+         break;
+
+      /* 
+       * Leave this entry where it is if its home slot is (cyclically)
+       * after the hole and no later than the entry itself.
+       */
+      home = Macros.slots[i].hash & mask;
+      if (hole <= i ? (hole < home && home <= i) : (hole < home || home <= i))
+         continue;
+
+      Macros.slots[hole] = Macros.slots[i];
+      hole = i;
+   }
 
-   /* And finally, free up the entry's text and the entry itself */
-   if (sym->text) free (sym->text);
-   free (sym);
+   Macros.slots[hole].name = NULL;
+   Macros.slots[hole].text = NULL;
+   Macros.count--;
 } /* delete_macro_entry() */
 
 
@@ -213,17 +363,17 @@ bt_add_macro_value (AST *assignment, ushort options)
 @DESCRIPTION: Sets the text value for a macro.  If the macro is already
               defined, a warning is printed and the old value is overridden.
 @GLOBALS    : 
-@CALLS      : zzs_get(), zzs_newadd()
+@CALLS      : find_slot(), grow_table()
 @CALLERS    : bt_add_macro_value()
               (exported from library)
 @CREATED    : 1997/11/13, GPW (from code in bt_add_macro_value())
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16 (redefining reuses the old slot)
 -------------------------------------------------------------------------- */
 void
 bt_add_macro_text (char * macro, char * text, char * filename, int line)
 {
-   Sym * sym;
-   Sym * new_rec;
+   macro_slot * slot;
+   unsigned int hash;
 
 #if DEBUG == 1
    printf ("adding macro \"%s\" = \"%s\"\n", macro, text);
@@ -233,19 +383,35 @@ bt_add_macro_text (char * macro, char * text, char * filename, int line)
            macro, macro, text, text);
 #endif
 
-   if ((sym = zzs_get (macro)))
+   CHECK_MACRO_TABLE ();
+   text = (text != NULL) ? strdup (text) : NULL;
+   hash = hash_name (macro);
+   slot = find_slot (macro, hash);
+   if (slot->name != NULL)
    {
       macro_warning (filename, line,
                      "overriding existing definition of macro \"%s\"", 
                      macro);
-      delete_macro_entry (sym);
+      if (slot->text) free (slot->text);
+   }
+   else
+   {
+      if ((Macros.count + 1) * 2 > Macros.size)
+      {
+         grow_table ();
+         slot = find_slot (macro, hash);
+      }
+      if (Macros.names == NULL)
+         Macros.names = bt_arena_new (NAME_BLOCK_SIZE);
+      slot->name = bt_arena_strdup (Macros.names, macro);
+      slot->hash = hash;
+      Macros.count++;
    }
 
-   new_rec = zzs_newadd (macro);
-   new_rec->text = (text != NULL) ? strdup (text) : NULL;
+   slot->text = text;
    DBG_ACTION
       (2, printf ("           saved = %p (%s)\n",
-                  new_rec->text, new_rec->text);)
+                  slot->text, slot->text);)
 
 } /* bt_add_macro_text() */
 
@@ -254,7 +420,7 @@ bt_add_macro_text (char * macro, char * text, char * filename, int line)
 @NAME       : bt_delete_macro()
 @INPUT      : macro - name of macro to delete
 @DESCRIPTION: Deletes a macro from the macro table.
-@CALLS      : zzs_get()
+@CALLS      : lookup_macro(), delete_macro_entry()
 @CALLERS    : 
 @CREATED    : 1998/03/01, GPW
 @MODIFIED   : 
@@ -262,48 +428,103 @@ bt_add_macro_text (char * macro, char * text, char * filename, int line)
 void
 bt_delete_macro (char * macro)
 {
-   Sym * sym;
+   macro_slot * slot;
 
-   sym = zzs_get (macro);
-   if (! sym) return;
-   delete_macro_entry (sym);
+   slot = lookup_macro (macro);
+   if (! slot) return;
+   delete_macro_entry (slot);
 }
 
 
 /* ------------------------------------------------------------------------
 @NAME       : bt_delete_all_macros()
-@DESCRIPTION: Deletes all macros from the macro table.
-@CALLS      : zzs_rmscore()
-@CALLERS    : 
+@DESCRIPTION: Deletes all macros from the macro table, and frees the
+              arena holding their names.
+@CALLS      : 
+@CALLERS    : done_macros()
 @CREATED    : 1998/03/01, GPW
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16 (own hash table instead of sym.c)
 -------------------------------------------------------------------------- */
 void
 bt_delete_all_macros (void)
 {
-   Sym  *cur, *next;
+   unsigned int  i;
 
    DBG_ACTION (2, printf ("bt_delete_all_macros():\n");)
 
-   /* 
-    * Use the current `scope' (same one for all macros) to get access to
-    * a linked list of all macros.  Then traverse the list, free()'ing
-    * both the text (which was strdup()'d in add_macro(), below) and 
-    * the records themselves (which are calloc()'d by zzs_new()).
-    */
+   if (Macros.slots == NULL) return;    /* nothing to delete */
 
-   cur = zzs_rmscope (&AllMacros);
-   while (cur != NULL)
+   for (i = 0; i < Macros.size; i++)
    {
+      if (Macros.slots[i].name == NULL) continue;
+
       DBG_ACTION
-         (2, printf ("  freeing macro \"%s\" (%p=\"%s\") at %p\n",
-                     cur->symbol, cur->text, cur->text, cur);)
+         (2, printf ("  freeing macro \"%s\" (%p=\"%s\")\n",
+                     Macros.slots[i].name, Macros.slots[i].text,
+                     Macros.slots[i].text);)
+
+      if (Macros.slots[i].text != NULL) free (Macros.slots[i].text);
+      Macros.slots[i].name = NULL;
+      Macros.slots[i].text = NULL;
+   }
+   Macros.count = 0;
+
+   bt_arena_free (Macros.names);
+   Macros.names = NULL;
+}
 
-      next = cur->scope;
-      if (cur->text != NULL) free (cur->text);
-      free (cur);
-      cur = next;
+
+/* ------------------------------------------------------------------------
+@NAME       : next_macro()
+@INPUT      : pos   - 0 to start with, or what the last call returned
+@OUTPUT     : *name - name of the next macro in the table
+              *text - its expansion text (maybe NULL)
+@RETURNS    : where to carry on from, or 0 if there are no more macros
+@DESCRIPTION: Walks through the current thread's macro table, in no
+              particular order.  The table mustn't change in between.
+@GLOBALS    : Macros
+@CALLERS    : hash_macros() (in cache.c)
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+unsigned int
+next_macro (unsigned int pos, char ** name, char ** text)
+{
+   for ( ; pos < Macros.size; pos++)
+   {
+      if (Macros.slots[pos].name != NULL)
+      {
+         *name = Macros.slots[pos].name;
+         *text = Macros.slots[pos].text;
+         return pos + 1;
+      }
    }
+   return 0;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : macro_defined()
+@INPUT      : macro - the macro name
+@OUTPUT     : *text - its expansion text (maybe NULL), if it's defined
+@RETURNS    : TRUE if the macro is defined
+@DESCRIPTION: Like bt_macro_text(), but quietly: an undefined macro is
+              no cause for a warning here.
+@CALLS      : lookup_macro()
+@CALLERS    : save_forest() (in cache.c)
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+boolean
+macro_defined (char * macro, char ** text)
+{
+   macro_slot * slot;
+
+   slot = lookup_macro (macro);
+   if (slot == NULL)
+      return FALSE;
+   *text = slot->text;
+   return TRUE;
 }
 
 
@@ -314,22 +535,21 @@ bt_delete_all_macros (void)
 @RETURNS    : length of the macro's text, or zero if the macro is undefined
 @DESCRIPTION: Returns length of a macro's text.
 @GLOBALS    : 
-@CALLS      : zzs_get()
-@CALLERS    : bt_postprocess_value()
-              (exported from library)
+@CALLS      : lookup_macro()
+@CALLERS    : (exported from library)
 @CREATED    : Jan 1997, GPW
 -------------------------------------------------------------------------- */
 int
 bt_macro_length (char *macro)
 {
-   Sym   *sym;
+   macro_slot *slot;
 
    DBG_ACTION
       (2, printf ("bt_macro_length: looking up \"%s\"\n", macro);)
 
-   sym = zzs_get (macro);
-   if (sym)
-      return strlen (sym->text);
+   slot = lookup_macro (macro);
+   if (slot && slot->text)
+      return strlen (slot->text);
    else
       return 0;   
 }
@@ -344,24 +564,24 @@ bt_macro_length (char *macro)
 @RETURNS    : The text of the macro, or NULL if it's undefined. 
 @DESCRIPTION: Fetches a macros text; prints warning and returns NULL if 
               macro is undefined.
-@CALLS      : zzs_get()
-@CALLERS    : bt_postprocess_value()
+@CALLS      : lookup_macro()
+@CALLERS    : bt_postprocess_value(), paste_value()
 @CREATED    : Jan 1997, GPW
 -------------------------------------------------------------------------- */
 char *
 bt_macro_text (char * macro, char * filename, int line)
 {
-   Sym *  sym;
+   macro_slot * slot;
 
    DBG_ACTION
       (2, printf ("bt_macro_text: looking up \"%s\"\n", macro);)
 
-   sym = zzs_get (macro);
-   if (!sym)
+   slot = lookup_macro (macro);
+   if (!slot)
    {
       macro_warning (filename, line, "undefined macro \"%s\"", macro);
       return NULL;
    }
 
-   return sym->text;
+   return slot->text;
 }
@@ -20,6 +20,7 @@
 #include <string.h>
 #include "btparse.h"
 #include "error.h"
+#include "prototypes.h"
 #include "my_dmalloc.h"
 
 
@@ -31,17 +32,19 @@
 @RETURNS    : 
 @DESCRIPTION: Replace the text member of an AST node with a new string.
               The passed in string, 'new_text', is duplicated, so the
-              caller may free it without worry.
+              caller may free it without worry.  The node is marked as
+              changed, so that bt_write_entry() won't copy its entry
+              from the original text.
 @GLOBALS    : 
 @CALLS      : 
 @CALLERS    : 
 @CREATED    : 1999/11/25, GPW (from Stphane Genaud)
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16 (sets `changed')
 -------------------------------------------------------------------------- */
 void bt_set_text (AST * node, char * new_text)
 {
-   free(node->text);
-   node->text = strdup (new_text);
+   set_ast_text (node, bt_arena_strdup (node->arena, new_text));
+   node->changed = TRUE;
 }
 
 
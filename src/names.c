@@ -54,7 +54,7 @@ typedef struct
 
 GEN_PRIVATE_ERRFUNC (name_warning,
                      (name_loc * loc, char * fmt, ...),
-                     BTERR_CONTENT, loc->filename, loc->line,
+                     BTERR_CONTENT, loc->filename, loc->line, -1,
                      "name", loc->name_num, fmt)
 
 
@@ -805,6 +805,7 @@ bt_split_name (char *  name,
 
    if (len == 0)                        /* non-existent or empty string? */
    {
+      split_name->tokens = NULL;
       for (i = 0; i < BT_MAX_NAMEPARTS; i++)
       {
          split_name->parts[i] = NULL;
@@ -853,6 +854,7 @@ bt_split_name (char *  name,
    printf ("(first,last) lc tokens = (%d,%d)\n", first_lc, last_lc);
 #endif
 
+   split_name->tokens = tokens;
    if (strlen (name) == 0)              /* name now empty? */
    {
       for (i = 0; i < BT_MAX_NAMEPARTS; i++)
@@ -863,7 +865,6 @@ bt_split_name (char *  name,
    }
    else
    {
-      split_name->tokens = tokens;
       if (num_commas == 0)              /* no commas -- "simple" format */
       {
          split_simple_name (&loc, split_name, 
@@ -0,0 +1,411 @@
+/* ------------------------------------------------------------------------
+@NAME       : parallel.c
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Parsing a single big buffer (or file) on several threads at
+              once.  The buffer is pre-scanned for the boundaries between
+              entries, split into chunks on those boundaries, and the
+              chunks are parsed by a pool of worker threads.  The
+              resulting lists of entries are spliced back together in
+              their original order, and then post-processed one entry at
+              a time in the calling thread -- that's where macros are
+              defined and expanded, so @string entries take effect in
+              exactly the same order as when parsing sequentially.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse library.  This library is
+              free software; you can redistribute it and/or modify it under
+              the terms of the GNU Library General Public License as
+              published by the Free Software Foundation; either version 2
+              of the License, or (at your option) any later version.
+-------------------------------------------------------------------------- */
+
+#include "bt_config.h"
+#include <stdlib.h>
+#include <string.h>
+#if HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#if HAVE_PTHREAD_H && HAVE_LIBPTHREAD
+# include <pthread.h>
+# define USE_THREADS 1
+#else
+# define USE_THREADS 0
+#endif
+#include "btparse.h"
+#include "error.h"
+#include "prototypes.h"
+#include "stats.h"
+#include "my_dmalloc.h"
+
+
+#define MIN_CHUNK_SIZE    65536         /* don't bother splitting finer */
+#define CHUNKS_PER_THREAD 4             /* to even out the load */
+
+
+typedef struct
+{
+   const char * start;                  /* text of this chunk */
+   size_t       len;
+   int          line;                   /* where it is in the whole buffer */
+   size_t       offset;
+   AST *        entries;                /* results of parsing it */
+   boolean      status;
+   bt_arena *   arena;                  /* NULL unless caller has an arena */
+} chunk;
+
+typedef struct
+{
+   chunk *      chunks;
+   int          num_chunks;
+   int          next_chunk;             /* next one to hand out */
+   char *       filename;
+   ushort       options;
+#if USE_THREADS
+   pthread_mutex_t
+                lock;                   /* protects next_chunk */
+#endif
+} parse_job;
+
+typedef struct
+{
+   parse_job *  job;
+   int *        err_counts;             /* worker's errors, once done */
+#if BT_STATS
+   bt_stats     stats;                  /* and its counts */
+#endif
+} worker;
+
+
+/* ------------------------------------------------------------------------
+@NAME       : split_buffer()
+@INPUT      : buf, len   - the text to split
+              max_chunks - how many pieces we'd like
+@OUTPUT     : chunks     - start, len, line, and offset of each piece
+@RETURNS    : number of chunks actually made (at least one)
+@DESCRIPTION: Scans a buffer for the places where one entry ends and
+              the next begins, and picks some of them to split the buffer
+              into chunks of roughly equal size.
+
+              The boundaries come from scan_next_entry(), which only
+              understands well-formed input.  As soon as it sees
+              anything that would make the real lexer or parser complain,
+              we stop looking, and the rest of the buffer goes into the
+              last chunk; thus error recovery happens just as it would
+              for a sequential parse.  Chunks start right after the end
+              of an entry, so any junk between entries goes with the
+              following entry (and is reported there), as usual.
+@GLOBALS    :
+@CALLS      : scan_next_entry()
+@CALLERS    : bt_parse_buffer_parallel()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static int
+split_buffer (const char * buf, size_t len, int max_chunks, chunk * chunks)
+{
+   bt_entry_span span;
+   int         line;
+   int         num_chunks;
+   size_t      target;                  /* want next chunk to start here */
+   size_t      pos;
+
+   chunks[0].start = buf;
+   chunks[0].line = 1;
+   chunks[0].offset = 0;
+   num_chunks = 1;
+   target = len / max_chunks;
+
+   pos = 0;
+   line = 1;
+   while (num_chunks < max_chunks
+          && scan_next_entry (buf, len, &pos, &line, &span) > 0)
+   {
+      if (pos >= target && pos < len)
+      {
+         chunks[num_chunks].start = buf + pos;
+         chunks[num_chunks].line = line;
+         chunks[num_chunks].offset = pos;
+         num_chunks++;
+         target = (len / max_chunks) * num_chunks;
+      }
+   }
+
+   return num_chunks;
+
+} /* split_buffer() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : parse_chunks()
+@INPUT      : arg - a worker, pointing to the parse_job
+@OUTPUT     :
+@RETURNS    : NULL
+@DESCRIPTION: Worker thread body: keeps taking the next chunk off the job
+              and parsing it (without post-processing) until there are
+              none left.  If the chunk has an arena, the ASTs are built in
+              it.  Finally, saves the thread's error counts (and stats, if
+              kept) so the caller can add them to its own.
+@GLOBALS    :
+@CALLS      : parse_chunk()
+@CALLERS    : bt_parse_buffer_parallel()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void *
+parse_chunks (void * arg)
+{
+   worker *    self = (worker *) arg;
+   parse_job * job = self->job;
+   chunk *     cur;
+   bt_arena *  prev_arena;
+   int         num;
+
+   for (;;)
+   {
+#if USE_THREADS
+      pthread_mutex_lock (&job->lock);
+#endif
+      num = job->next_chunk++;
+#if USE_THREADS
+      pthread_mutex_unlock (&job->lock);
+#endif
+      if (num >= job->num_chunks)
+         break;
+
+      cur = &job->chunks[num];
+      prev_arena = bt_set_arena (cur->arena);
+      cur->entries = parse_chunk (cur->start, cur->len, job->filename,
+                                  cur->line, cur->offset, job->options,
+                                  &cur->status);
+      bt_set_arena (prev_arena);
+   }
+
+   self->err_counts = bt_get_error_counts (NULL);
+#if BT_STATS
+   bt_get_stats (&self->stats);
+#endif
+   return NULL;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : default_num_threads()
+@INPUT      :
+@OUTPUT     :
+@RETURNS    : number of processors online, if we can find out; else 1
+@CALLERS    : bt_parse_buffer_parallel(), bt_find_duplicates()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+int
+default_num_threads (void)
+{
+#if HAVE_SYSCONF && defined(_SC_NPROCESSORS_ONLN)
+   long   num = sysconf (_SC_NPROCESSORS_ONLN);
+
+   if (num > 0)
+      return (int) num;
+#endif
+   return 1;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parse_buffer_parallel()
+@INPUT      : buf         - text to parse (need not be null-terminated)
+              len         - number of characters in `buf'
+              filename    - for error messages and the ASTs (may be NULL)
+              options     - standard btparse options bitmap
+              num_threads - how many threads to use (0 means one per
+                            processor)
+@OUTPUT     : *status     - FALSE if any entries had serious errors
+@RETURNS    : linked list of ASTs, as for bt_parse_buffer()
+@DESCRIPTION: Same as bt_parse_buffer(), but splits the buffer between
+              several threads.  See the top of this file.  The calling
+              thread takes part in parsing, so num_threads of 1 (or a
+              system without threads) just parses in the caller.
+@GLOBALS    :
+@CALLS      : split_buffer(), parse_chunks(), default_postprocess()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+AST * bt_parse_buffer_parallel (const char * buf,
+                                size_t       len,
+                                char *       filename,
+                                ushort       options,
+                                boolean *    status,
+                                int          num_threads)
+{
+   parse_job   job;
+   worker *    workers;
+   int         max_chunks;
+   int         num_workers;
+   bt_arena *  arena;
+   AST *       entries,
+       *       last;
+   boolean     overall_status;
+   int         i;
+#if USE_THREADS
+   pthread_t * threads;
+#endif
+
+   if (options & BTO_STRINGMASK)        /* any string options set? */
+   {
+      usage_error ("bt_parse_buffer_parallel: illegal options "
+                   "(string options not allowed");
+   }
+   if (buf == NULL && len > 0)
+      usage_error ("bt_parse_buffer_parallel: no buffer supplied");
+   if (buf == NULL)
+      buf = "";
+
+   if (num_threads <= 0)
+      num_threads = default_num_threads ();
+#if !USE_THREADS
+   num_threads = 1;
+#endif
+
+   max_chunks = num_threads * CHUNKS_PER_THREAD;
+   if ((size_t) max_chunks > len / MIN_CHUNK_SIZE)
+      max_chunks = (int) (len / MIN_CHUNK_SIZE);
+   if (max_chunks < 1 || num_threads == 1)
+      max_chunks = 1;
+
+   job.chunks = (chunk *) calloc (max_chunks, sizeof (chunk));
+   job.num_chunks = split_buffer (buf, len, max_chunks, job.chunks);
+   job.next_chunk = 0;
+   job.filename = filename;
+   job.options = options;
+   for (i = 0; i < job.num_chunks; i++)
+   {
+      chunk * cur = &job.chunks[i];
+      const char * end = (i+1 < job.num_chunks) ? job.chunks[i+1].start
+                                                 : buf + len;
+      cur->len = end - cur->start;
+   }
+
+   /*
+    * Arenas can't be shared between threads, so if the caller is using
+    * one, each chunk gets its own, to be adopted by the caller's.
+    */
+   arena = bt_get_arena ();
+   if (arena != NULL)
+   {
+      for (i = 0; i < job.num_chunks; i++)
+         job.chunks[i].arena = bt_arena_new (0);
+   }
+
+   num_workers = (num_threads < job.num_chunks) ? num_threads : job.num_chunks;
+   if (num_workers < 1)
+      num_workers = 1;
+   workers = (worker *) calloc (num_workers, sizeof (worker));
+   for (i = 0; i < num_workers; i++)
+      workers[i].job = &job;
+
+#if USE_THREADS
+   pthread_mutex_init (&job.lock, NULL);
+   threads = (pthread_t *) calloc (num_workers, sizeof (pthread_t));
+   for (i = 1; i < num_workers; i++)
+   {
+      if (pthread_create (&threads[i], NULL, parse_chunks, &workers[i]) != 0)
+         internal_error ("couldn't create parser thread");
+   }
+#endif
+
+   parse_chunks (&workers[0]);          /* do our share of the work */
+
+#if USE_THREADS
+   for (i = 1; i < num_workers; i++)
+   {
+      pthread_join (threads[i], NULL);
+      add_error_counts (workers[i].err_counts);
+#if BT_STATS
+      add_stats (&workers[i].stats);
+#endif
+   }
+   free (threads);
+   pthread_mutex_destroy (&job.lock);
+#endif
+
+   /* Splice the chunks' entries together, in order. */
+   entries = last = NULL;
+   overall_status = TRUE;
+   for (i = 0; i < job.num_chunks; i++)
+   {
+      chunk * cur = &job.chunks[i];
+
+      overall_status &= cur->status;
+      if (cur->arena != NULL)
+         arena_adopt (arena, cur->arena);
+      if (cur->entries == NULL)
+         continue;
+      if (last == NULL)
+         entries = cur->entries;
+      else
+         last->right = cur->entries;
+      for (last = cur->entries; last->right != NULL; last = last->right)
+         ;
+   }
+
+   /*
+    * And post-process them in order, in this thread -- so each @string
+    * only affects the entries that follow it.
+    */
+   for (last = entries; last != NULL; last = last->right)
+      default_postprocess (last, options);
+
+   for (i = 0; i < num_workers; i++)
+      free (workers[i].err_counts);
+   free (workers);
+   free (job.chunks);
+
+   if (status) *status = overall_status;
+   return entries;
+
+} /* bt_parse_buffer_parallel() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_parse_file_parallel()
+@INPUT      : filename    - file to parse; NULL or "-" means stdin
+              options
+              num_threads - as for bt_parse_buffer_parallel()
+@OUTPUT     : *status
+@RETURNS    : linked list of ASTs, as for bt_parse_file()
+@DESCRIPTION: Loads a whole file with map_file() and parses it with
+              bt_parse_buffer_parallel().  (Stdin just gets a plain
+              bt_parse_file().)
+@GLOBALS    :
+@CALLS      : map_file(), bt_parse_buffer_parallel(), unmap_file()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+AST * bt_parse_file_parallel (char *    filename,
+                              ushort    options,
+                              boolean * status,
+                              int       num_threads)
+{
+   AST *       entries;
+   char *      buf;
+   size_t      len;
+
+   if (options & BTO_STRINGMASK)        /* any string options set? */
+   {
+      usage_error ("bt_parse_file_parallel: illegal options "
+                   "(string options not allowed");
+   }
+
+   if (filename == NULL || strcmp (filename, "-") == 0)
+      return bt_parse_file (filename, options, status);
+
+   if (! map_file (filename, &buf, &len))
+      return NULL;
+   entries = bt_parse_buffer_parallel (buf, len, filename, options, status,
+                                       num_threads);
+   unmap_file (buf, len);
+   return entries;
+}
@@ -27,12 +27,32 @@
 #include "error.h"
 #include "lex_auxiliary.h"
 #include "parse_auxiliary.h"
+#include "prototypes.h"
 #include "my_dmalloc.h"
 
-extern char * InputFilename;            /* from input.c */
+extern BT_THREAD_LOCAL char * InputFilename; /* from input.c */
+
+/* 
+ * TRUE while parsing a field that's going to be thrown away (see
+ * bt_select_fields()); tells new_value_node() not to build any nodes.
+ */
+BT_THREAD_LOCAL boolean SkippingField = FALSE;
+
+/*
+ * Set whenever a field is thrown away, so that parse_next_entry() can
+ * mark the entry as no longer matching its source text.
+ */
+BT_THREAD_LOCAL boolean DroppedField = FALSE;
+
+/*
+ * TRUE just before the parser matches a field name or entry type; tells
+ * zzcr_ast to intern the token (see bt_intern()) instead of copying it.
+ */
+BT_THREAD_LOCAL boolean InterningName = FALSE;
 
 GEN_PRIVATE_ERRFUNC (syntax_error, (char * fmt, ...),
-                     BTERR_SYNTAX, InputFilename, zzline, NULL, -1, fmt)
+                     BTERR_SYNTAX, InputFilename, zzline, zzbegcol,
+                     NULL, -1, fmt)
 
 
 /* this is stolen from PCCTS' err.h */
@@ -142,7 +162,7 @@ zzsyn(char *        text,
       int           k,
       char *        bad_text)
 {
-   static char    msg [MAX_ERROR];
+   static BT_THREAD_LOCAL char msg [MAX_ERROR];
    int            len;
 
 #ifndef ALLOW_WARNINGS
@@ -227,6 +247,40 @@ check_field_name (AST * field)
    if (strchr ("0123456789", name[0]))
       syntax_error ("invalid field name \"%s\": cannot start with digit",
                     name);
+
+   SkippingField = (entry_metatype () == BTE_REGULAR
+                    && ! field_selected (field->atom));
+   if (SkippingField)
+      DroppedField = TRUE;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : new_value_node()
+@INPUT      : attr     - attribute of the token just matched
+              tok      - its token type
+              nodetype - what sort of simple value it is
+@OUTPUT     : 
+@RETURNS    : a new AST node for the token, or NULL if the field it's in
+              is going to be thrown away (see check_field_name())
+@DESCRIPTION: Does for a simple value what PCCTS would do for any token
+              (see zzsubchild()), except that a field that isn't wanted
+              doesn't get any value nodes built at all.
+@CALLERS    : simple_value (bibtex.g)
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+AST *
+new_value_node (Attrib * attr, int tok, bt_nodetype nodetype)
+{
+   AST * node;
+
+   if (SkippingField)
+      return NULL;
+   node = zzastnew ();
+   zzcr_ast (node, attr, tok, attr->text);
+   node->nodetype = nodetype;
+   return node;
 }
 
 
@@ -240,7 +294,7 @@ show_ast_stack_elem (int num)
    bt_metatype    metatype; */
    AST   *elem;
 
-   elem = zzastStack[num];
+   elem = zzastAt (num);
    printf ("zzastStack[%3d] = ", num);
    if (elem)
    {
@@ -284,7 +338,7 @@ dump_ast_stack (char *label)
    else
       printf ("complete ast stack:\n");
 
-   for (i = zzast_sp; i < ZZAST_STACKSIZE; i++)
+   for (i = zzast_sp; i < zzastTOP; i++)
    {
       printf ("  ");
       show_ast_stack_elem (i);
@@ -297,7 +351,7 @@ show_attrib_stack_elem (int num)
 {
    Attrib   elem;
 
-   elem = zzaStack[num];
+   elem = zzaAt (num);
    printf ("zzaStack[%3d] = ", num);
    printf ("{ \"%s\" (token %d (%s), line %d, char %d) }\n",
            elem.text, elem.token, zztokens[elem.token],
@@ -326,7 +380,7 @@ dump_attrib_stack (char *label)
    else
       printf ("complete attrib stack:\n");
 
-   for (i = zzasp; i < ZZA_STACKSIZE; i++)
+   for (i = zzasp; i < zzaTOP; i++)
    {
       printf ("  ");
       show_attrib_stack_elem (i);
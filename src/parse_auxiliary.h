@@ -28,5 +28,6 @@ void zzsyn (char *text, int tok,
             char *egroup, SetWordType *eset, int etok,
             int k, char *bad_text);
 void  check_field_name (AST * field);
+AST * new_value_node (Attrib * attr, int tok, bt_nodetype nodetype);
 
 #endif /* PARSE_AUXILIARY_H */
@@ -18,11 +18,11 @@
 #include "bt_config.h"
 #include <stdlib.h>
 #include <string.h>
-#include <assert.h>
 #include "btparse.h"
 #include "error.h"
 #include "parse_auxiliary.h"
 #include "prototypes.h"
+#include "stats.h"
 #include "my_dmalloc.h"
 
 #define DEBUG 1
@@ -122,6 +122,117 @@ bt_postprocess_string (char * s, ushort options)
 } /* bt_postprocess_string */
 
 
+/* ------------------------------------------------------------------------
+@NAME       : paste_value()
+@INPUT      : value   - head of a list of two or more simple values
+              options - string-processing options
+              replace - whether to replace the list in the AST with the
+                        concatenation
+@OUTPUT     : 
+@RETURNS    : the concatenation of all the simple values (the text of
+              `value' if `replace' is true, otherwise a newly-allocated
+              string)
+@DESCRIPTION: Does the pasting for bt_postprocess_value().  The strings,
+              numbers, and (if expanding) macro texts are appended to a
+              buffer one after the other, in a single pass; the buffer
+              doubles in size whenever it fills, so this is linear in the
+              total length however many pieces there are.  Each macro is
+              looked up just once.  Whitespace is not collapsed in the
+              individual pieces (so that's done to the whole thing,
+              according to `options', once it's all pasted together).
+              If we're replacing and the AST has an arena, the result is
+              then copied into the arena, once.
+@GLOBALS    : 
+@CALLS      : bt_macro_text(), bt_postprocess_string(), bt_arena_strdup()
+@CALLERS    : bt_postprocess_value()
+@CREATED    : 2026/10/16 (from code in bt_postprocess_value())
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+static char *
+paste_value (AST * value, ushort options, boolean replace)
+{
+   AST *   simple_value;
+   char *  new_string;
+   char *  piece;
+   char *  copy;
+   size_t  len,                         /* length of new_string so far */
+           alloc,                       /* space allocated for it */
+           piece_len;
+
+   alloc = 64;
+   len = 0;
+   new_string = (char *) malloc (alloc);
+   if (new_string == NULL)
+      internal_error ("out of memory pasting strings");
+
+   for (simple_value = value; simple_value; simple_value = simple_value->right)
+   {
+      switch (simple_value->nodetype)
+      {
+         case BTAST_MACRO:
+            piece = NULL;
+            if (options & BTO_EXPAND)
+               piece = bt_macro_text (simple_value->text,
+                                      simple_value->filename,
+                                      simple_value->line);
+            break;
+         case BTAST_STRING:
+         case BTAST_NUMBER:
+            piece = simple_value->text;
+            break;
+         default:
+            internal_error ("simple value has bad nodetype (%d)",
+                            (int) simple_value->nodetype);
+            piece = NULL;               /* not reached */
+      }
+      if (piece == NULL)
+         continue;
+
+      piece_len = strlen (piece);
+      if (len + piece_len >= alloc)
+      {
+         while (len + piece_len >= alloc)
+            alloc *= 2;
+         new_string = (char *) realloc (new_string, alloc);
+         if (new_string == NULL)
+            internal_error ("out of memory pasting strings");
+      }
+      memcpy (new_string + len, piece, piece_len);
+      len += piece_len;
+   }
+   new_string[len] = (char) 0;
+   COUNT (strings_pasted);
+
+   bt_postprocess_string (new_string, options);
+
+   /* 
+    * If replacing data in the AST, delete all but first child of
+    * `field', and replace text for first child with new_string.
+    */
+
+   if (replace)
+   {
+      if (value->arena != NULL)         /* set_ast_text() wants it there */
+      {
+         copy = bt_arena_strdup (value->arena, new_string);
+         free (new_string);
+         new_string = copy;
+      }
+      if ((value->nodetype == BTAST_MACRO && (options & BTO_EXPAND)) ||
+          (value->nodetype == BTAST_NUMBER && (options & BTO_CONVERT)))
+         value->nodetype = BTAST_STRING;
+
+      zzfree_ast (value->right);        /* free from second simple value on */
+      value->right = NULL;              /* remind ourselves they're gone */
+      new_string = set_ast_text         /* replace text of first simple */
+         (value, new_string);           /* value with concatenation */
+   }
+
+   return new_string;
+
+} /* paste_value() */
+
+
 /* ------------------------------------------------------------------------
 @NAME       : bt_postprocess_value()
 @INPUT      : 
@@ -164,22 +275,19 @@ bt_postprocess_string (char * s, ushort options)
               the returned string is allocated here, and you must free() it
               later.
 @GLOBALS    : 
-@CALLS      : 
+@CALLS      : paste_value()
 @CREATED    : 1997/01/10, GPW
 @MODIFIED   : 1997/08/25, GPW: renamed from bt_postprocess_field(), and changed
                                to take the head of a list of simple values,
                                rather than the parent of that list
+              2026/10/16: moved pasting to paste_value(), single pass
 -------------------------------------------------------------------------- */
 char *
 bt_postprocess_value (AST * value, ushort options, boolean replace)
 {
    AST *   simple_value;                /* current simple value */
-   boolean pasting;
-   ushort  string_opts;                 /* what to do to individual strings */
-   int     tot_len;                     /* total length of pasted string */
-   char *  new_string;                  /* in case of string pasting */
+   char *  new_string;
    char *  tmp_string;
-   boolean free_tmp;                    /* should we free() tmp_string? */
 
    if (value == NULL) return NULL;
    if (value->nodetype != BTAST_STRING &&
@@ -195,98 +303,42 @@ bt_postprocess_value (AST * value, ushort options, boolean replace)
     * two simple values in the list headed by 'value'.
     */
 
-   pasting = (options & BTO_PASTE) && (value->right);
-
-   /* 
-    * If we're to concatenate (paste) sub-strings, we need to know the
-    * total length of them.  So make a pass over all the sub-strings
-    * (simple values), adding up their lengths.
-    */
-
-   tot_len = 0;                         /* these are out here to keep */
-   new_string = NULL;                   /* gcc -Wall happy */
-   tmp_string = NULL;
-
-   if (pasting)
+   if ((options & BTO_PASTE) && (value->right))
    {
-      simple_value = value;
-      while (simple_value)
+      /*
+       * Sanity check: if we continue blindly on, we might stupidly
+       * concatenate a macro name and a literal string.  So check for that.
+       * Converting numbers is superficial, but requiring that it be done
+       * keeps people honest.
+       */
+
+      if (! (options & (BTO_CONVERT|BTO_EXPAND)))
       {
-         switch (simple_value->nodetype)
-         {
-            case BTAST_MACRO:
-               tot_len += bt_macro_length (simple_value->text);
-               break;
-            case BTAST_STRING:
-               tot_len += (simple_value->text) 
-                  ? (strlen (simple_value->text)) : 0;
-               break;
-            case BTAST_NUMBER:
-               tot_len += (simple_value->text)
-                  ? (strlen (simple_value->text)) : 0;
-               break;
-            default:
-               internal_error ("simple value has bad nodetype (%d)",
-                               (int) simple_value->nodetype);
-         }
-         simple_value = simple_value->right;
+         usage_error ("bt_postprocess_value(): "
+                      "must convert numbers and expand macros " 
+                      "when pasting substrings");
       }
 
-      /* Now allocate the buffer in which we'll accumulate the whole string */
-
-      new_string = (char *) calloc (tot_len+1, sizeof (char));
-   }
-
-
-   /* 
-    * Before entering the main loop, figure out just what
-    * bt_postprocess_string() is supposed to do -- eg. if pasting strings,
-    * we should not (yet) collapse whitespace.  (That'll be done on the
-    * final, concatenated string -- assuming the caller put BTO_COLLAPSE in
-    * the options bitmap.)
-    */
-
-   if (pasting)
-   {
-      string_opts = options & ~BTO_COLLAPSE;     /* turn off collapsing */
-   }
-   else
-   {
-      string_opts = options;            /* leave it alone */
-   }
-
-   /*
-    * Sanity check: if we continue blindly on, we might stupidly
-    * concatenate a macro name and a literal string.  So check for that.
-    * Converting numbers is superficial, but requiring that it be done
-    * keeps people honest.
-    */
-
-   if (pasting && ! (options & (BTO_CONVERT|BTO_EXPAND)))
-   {
-      usage_error ("bt_postprocess_value(): "
-                   "must convert numbers and expand macros " 
-                   "when pasting substrings");
+      return paste_value (value, options, replace);
    }
 
    /*
-    * Now the main loop to process each string, and possibly tack it onto
-    * new_string.
+    * Not pasting, so process each string independently (according to
+    * the caller's options); the last one is returned.
     */
 
+   new_string = NULL;                   /* to keep gcc -Wall happy */
    simple_value = value;
    while (simple_value)
    {
       tmp_string = NULL;
-      free_tmp = FALSE;
 
       /* 
        * If this simple value is a macro and we're supposed to expand
        * macros, then do so.  We also have to post-process the string
        * returned from the macro table, because they're stored there
        * without whitespace collapsed; if we're supposed to be doing that
-       * to the current value (and we're not pasting), this is where it
-       * will get done.
+       * to the current value, this is where it will get done.
        */
       if (simple_value->nodetype == BTAST_MACRO && (options & BTO_EXPAND))
       {
@@ -295,18 +347,15 @@ bt_postprocess_value (AST * value, ushort options, boolean replace)
                                      simple_value->line);
          if (tmp_string != NULL)
          {
-            tmp_string = strdup (tmp_string);
-            free_tmp = TRUE;
-            bt_postprocess_string (tmp_string, string_opts);
+            tmp_string = bt_arena_strdup (replace ? simple_value->arena
+                                                  : NULL, tmp_string);
+            bt_postprocess_string (tmp_string, options);
          }
 
          if (replace)
          {
             simple_value->nodetype = BTAST_STRING;
-            if (simple_value->text)
-               free (simple_value->text);
-            simple_value->text = tmp_string;
-            free_tmp = FALSE;           /* mustn't free, it's now in the AST */
+            tmp_string = set_ast_text (simple_value, tmp_string);
          }
       }
 
@@ -318,16 +367,11 @@ bt_postprocess_value (AST * value, ushort options, boolean replace)
       else if (simple_value->nodetype == BTAST_STRING && simple_value->text)
       {
          if (replace)
-         {
             tmp_string = simple_value->text;
-         }
          else
-         {
             tmp_string = strdup (simple_value->text);
-            free_tmp = TRUE;
-         }
 
-         bt_postprocess_string (tmp_string, string_opts);
+         bt_postprocess_string (tmp_string, options);
       }
 
       /*
@@ -348,62 +392,24 @@ bt_postprocess_value (AST * value, ushort options, boolean replace)
             if (replace)
                tmp_string = simple_value->text;
             else
-            {
                tmp_string = strdup (simple_value->text);
-               free_tmp = TRUE;
-            }
          }
       }
 
-      if (pasting)
-      {
-         if (tmp_string)
-            strcat (new_string, tmp_string);
-         if (free_tmp)
-            free (tmp_string);
-      }
-      else
-      {
-         /* 
-          * N.B. if tmp_string is NULL (eg. from a single undefined macro)
-          * we make a strdup() of the empty string -- this is so we can
-          * safely free() the string returned from this function
-          * at some future point.
-          *
-          * This strdup() seems to cause a 1-byte memory leak in some
-          * circumstances.  I s'pose I should look into that some rainy
-          * afternoon...
-          */
-
-         new_string = (tmp_string != NULL) ? tmp_string : strdup ("");
-      }
-
-      simple_value = simple_value->right;
-   }
-
-   if (pasting)
-   {
-      int    len;
-
-      len = strlen (new_string);
-      assert (len <= tot_len);          /* hope we alloc'd enough! */
-
-      bt_postprocess_string (new_string, options);
-
       /* 
-       * If replacing data in the AST, delete all but first child of
-       * `field', and replace text for first child with new_string.
+       * N.B. if tmp_string is NULL (eg. from a single undefined macro)
+       * we make a strdup() of the empty string -- this is so we can
+       * safely free() the string returned from this function
+       * at some future point.
+       *
+       * This strdup() seems to cause a 1-byte memory leak in some
+       * circumstances.  I s'pose I should look into that some rainy
+       * afternoon...
        */
 
-      if (replace)
-      {
-         assert (value->right != NULL); /* there has to be > 1 simple value! */
-         zzfree_ast (value->right);     /* free from second simple value on */
-         value->right = NULL;           /* remind ourselves they're gone */
-         if (value->text)               /* free text of first simple value */
-            free (value->text);
-         value->text = new_string;      /* and replace it with concatenation */
-      }
+      new_string = (tmp_string != NULL) ? tmp_string : strdup ("");
+
+      simple_value = simple_value->right;
    }
 
    return new_string;
@@ -422,7 +428,7 @@ bt_postprocess_value (AST * value, ushort options, boolean replace)
               of simple values), downcases the field name, and calls
               bt_postprocess_value() on the value.
 @GLOBALS    : 
-@CALLS      : 
+@CALLS      : apply_pending(), bt_postprocess_value()
 @CALLERS    : 
 @CREATED    : 1997/08/25, GPW
 @MODIFIED   : 
@@ -434,7 +440,9 @@ bt_postprocess_field (AST * field, ushort options, boolean replace)
    if (field->nodetype != BTAST_FIELD)
       usage_error ("bt_postprocess_field: invalid AST node (not a field)");
 
-   strlwr (field->text);                /* downcase field name */
+   apply_pending (field);               /* finish lazy processing first */
+   if (field->atom == 0)
+      strlwr (field->text);             /* downcase field name */
    return bt_postprocess_value (field->down, options, replace);
 
 } /* bt_postprocess_field() */
@@ -448,21 +456,33 @@ bt_postprocess_field (AST * field, ushort options, boolean replace)
 @RETURNS    : 
 @DESCRIPTION: Postprocesses all the strings in an entry: collapse whitespace,
               concatenate substrings, expands macros, and whatnot.
+
+              If `options' includes BTO_LAZY, the values of regular,
+              comment, and preamble entries are left alone for now: each
+              field (or the entry itself, for comments and preambles) just
+              records the options in its `pending' member, and
+              apply_pending() does the work when the value is first
+              asked for.  Field names are still downcased right away
+              (unless they're atoms, which are lowercase already),
+              and @string entries are always processed (and their macros
+              defined) immediately.
 @GLOBALS    : 
 @CALLS      : 
 @CREATED    : 1997/01/10, GPW
-@MODIFIED   : 
+@MODIFIED   : 2026/10/16: added BTO_LAZY
 -------------------------------------------------------------------------- */
 void
 bt_postprocess_entry (AST * top, ushort options)
 {
    AST   *cur;
+   ushort pending;
    
    if (top == NULL) return;     /* not even an entry at all! */
    if (top->nodetype != BTAST_ENTRY)
       usage_error ("bt_postprocess_entry: "
                    "invalid node type (not entry root)");
-   strlwr (top->text);          /* downcase entry type */
+   if (top->atom == 0)          /* atoms are already lowercase */
+      strlwr (top->text);       /* downcase entry type */
 
    if (top->down == NULL) return; /* no children at all */
    
@@ -470,6 +490,25 @@ bt_postprocess_entry (AST * top, ushort options)
    if (cur->nodetype == BTAST_KEY)
       cur = cur->right;
 
+   if ((options & BTO_LAZY) && top->metatype != BTE_MACRODEF)
+   {
+      pending = (options & BTO_STRINGMASK) | BTO_LAZY;
+      if (top->metatype == BTE_REGULAR)
+      {
+         for ( ; cur; cur = cur->right)
+         {
+            if (cur->atom == 0)
+               strlwr (cur->text);      /* downcase field name */
+            cur->pending = pending;
+         }
+      }
+      else
+      {
+         top->pending = pending;
+      }
+      return;
+   }
+
    switch (top->metatype)
    {
       case BTE_REGULAR:
@@ -488,6 +527,7 @@ bt_postprocess_entry (AST * top, ushort options)
 
       case BTE_COMMENT:
       case BTE_PREAMBLE:
+         apply_pending (top);
          bt_postprocess_value (cur, options, TRUE);
          break;
       default:
@@ -496,3 +536,38 @@ bt_postprocess_entry (AST * top, ushort options)
    }
 
 } /* bt_postprocess_entry() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : apply_pending()
+@INPUT      : node - a field, or a comment or preamble entry
+@OUTPUT     : 
+@RETURNS    : 
+@DESCRIPTION: Does any postprocessing that was put off by BTO_LAZY (see
+              bt_postprocess_entry()) on the value of `node', replacing
+              the value in the AST.  Since the result replaces the raw
+              value, this only happens once; after that, this does
+              nothing.  Note that any macros in the value are expanded
+              now, so they get their current definition (which is not
+              necessarily the one in effect when the entry was parsed).
+@GLOBALS    : 
+@CALLS      : bt_postprocess_field(), bt_postprocess_value()
+@CALLERS    : bt_postprocess_field(), bt_postprocess_entry()
+              bt_next_value(), bt_get_text(), bt_get_value() (traversal.c)
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+void
+apply_pending (AST * node)
+{
+   ushort options;
+
+   if (node == NULL || ! (node->pending & BTO_LAZY)) return;
+
+   options = node->pending & BTO_STRINGMASK;
+   node->pending = 0;                   /* before recursing! */
+   if (node->nodetype == BTAST_FIELD)
+      bt_postprocess_field (node, options, TRUE);
+   else if (node->nodetype == BTAST_ENTRY)
+      bt_postprocess_value (node->down, options, TRUE);
+}
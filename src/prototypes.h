@@ -37,9 +37,40 @@ char *strlwr (char *s);
 char *strupr (char *s);
 #endif
 
+/* input.c */
+extern ushort StringOptions[NUM_METATYPES];
+boolean field_selected (int atom);
+const int * selected_fields (void);
+void  default_postprocess (AST * entry, ushort options);
+AST * parse_chunk (const char * buf, size_t len, char * filename,
+                   int line, size_t offset, ushort options, boolean * status);
+boolean map_file (char * filename, char ** buf, size_t * len);
+boolean map_file_private (char * filename, char ** buf, size_t * len);
+void  unmap_file (char * buf, size_t len);
+
+/* scan_entries.c */
+int   scan_next_entry (const char * buf, size_t len, size_t * pos,
+                       int * line, bt_entry_span * span);
+
 /* macros.c */
 void  init_macros (void);
 void  done_macros (void);
+unsigned int next_macro (unsigned int pos, char ** name, char ** text);
+boolean macro_defined (char * macro, char ** text);
+
+/* parallel.c */
+int   default_num_threads (void);
+
+/* postprocess.c */
+void  apply_pending (AST * node);
+
+/* traversal.c */
+char * fetch_value (AST * node, boolean * copied);
+
+/* arena.c */
+char * set_ast_text (AST * node, char * text);
+void   arena_adopt (bt_arena * parent, bt_arena * child);
+void   arena_own_map (bt_arena * arena, char * map, size_t len);
 
 /* bibtex_ast.c */
 void dump_ast (char *msg, AST *root);
@@ -0,0 +1,439 @@
+/* ------------------------------------------------------------------------
+@NAME       : scan_entries.c
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: A quick scan of BibTeX text that finds where each entry
+              starts and ends, along with its type and key, without
+              running the real lexer and parser or building any ASTs.
+              It follows the same rules as the lexer (START, LEX_ENTRY
+              and LEX_STRING modes in bibtex.g, and the entry state and
+              brace/quote balancing in lex_auxiliary.c) -- but only as far
+              as they go for well-formed input; it doesn't try to mimic
+              the parser's error recovery.  This is what you want for
+              indexing a large file: a full parse costs a great deal
+              more than looking at each character once.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16 (from split_buffer() in parallel.c)
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse library.  This library is
+              free software; you can redistribute it and/or modify it under
+              the terms of the GNU Library General Public License as
+              published by the Free Software Foundation; either version 2
+              of the License, or (at your option) any later version.
+-------------------------------------------------------------------------- */
+
+#include "bt_config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "btparse.h"
+#include "error.h"
+#include "prototypes.h"
+#include "my_dmalloc.h"
+
+
+/*
+ * States for scan_next_entry()'s imitation of the lexer: the first five
+ * match lex_auxiliary.c's entry_state, and the last is LEX_STRING mode.
+ */
+typedef enum
+{
+   scan_toplevel, scan_after_at, scan_after_type, scan_in_comment,
+   scan_in_entry, scan_in_string
+} scan_state;
+
+
+/*
+ * Characters that can make up a NUMBER or NAME token in LEX_ENTRY mode
+ * (see bibtex.g).  (strchr() would find a NUL, as the terminator.)
+ */
+#define IS_NAME_CHAR(c) \
+   (isascii (c) && (isalnum (c) ||                                      \
+                    ((c) != '\0' && strchr ("!$&*+-./:;<>?[]^_`|", (c)))))
+
+
+/* ------------------------------------------------------------------------
+@NAME       : type_metatype()
+@INPUT      : type - entry type (not null-terminated)
+              len  - its length
+@OUTPUT     :
+@RETURNS    : the metatype the lexer would give an entry of this type
+@DESCRIPTION: Does the same job as the entry-type part of name() in
+              lex_auxiliary.c.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static bt_metatype
+type_metatype (const char * type, size_t len)
+{
+#define TYPE_IS(name) \
+   (len == sizeof (name) - 1 && strncasecmp (type, name, len) == 0)
+
+   if (TYPE_IS ("comment"))
+      return BTE_COMMENT;
+   else if (TYPE_IS ("preamble"))
+      return BTE_PREAMBLE;
+   else if (TYPE_IS ("string"))
+      return BTE_MACRODEF;
+   else
+      return BTE_REGULAR;
+
+#undef TYPE_IS
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : scan_next_entry()
+@INPUT      : buf, len - the text being scanned
+              *pos     - where to start looking (must be at top-level, ie.
+                         not inside an entry)
+              *line    - line number of buf[*pos]
+@OUTPUT     : *pos     - just past the end of the entry found; or where
+                         the scan went wrong
+              *line    - line number of buf[*pos]
+              *span    - where the entry is, and its type and key
+@RETURNS    : 1 if an entry was found; 0 if there are no more entries;
+              -1 if something that would make the lexer or parser
+              complain turned up (at *pos) before the end of an entry
+@DESCRIPTION: Finds the next entry in a buffer.  Anything between
+              entries is skipped, just as the lexer skips it.  Only the
+              tokens that matter for finding the end of the entry are
+              looked at closely: the entry type (which determines how the
+              body is lexed), braces and quotes, and the first token of
+              the body (which is the key of a regular entry).  Note that
+              `span->type' and `span->key' point into `buf'.
+@GLOBALS    :
+@CALLS      :
+@CALLERS    : bt_scan_buffer(), split_buffer() (parallel.c)
+@CREATED    : 2026/10/16 (from split_buffer() in parallel.c)
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+int scan_next_entry (const char *    buf,
+                     size_t          len,
+                     size_t *        pos,
+                     int *           line,
+                     bt_entry_span * span)
+{
+   scan_state  state;
+   boolean     in_junk;                 /* in a run of toplevel junk */
+   boolean     first_token;             /* next token is first in body */
+   char        entry_opener;
+   char        string_opener;
+   int         brace_depth;
+   int         paren_depth;
+   int         lineno;
+   size_t      i, j;
+   int         c;
+   const char *eol;
+
+   state = scan_toplevel;
+   in_junk = FALSE;
+   first_token = FALSE;
+   entry_opener = string_opener = (char) 0;
+   brace_depth = paren_depth = 0;
+   lineno = *line;
+   memset (span, 0, sizeof (*span));
+
+   for (i = *pos; i < len; i++)
+   {
+      c = (unsigned char) buf[i];
+
+      if (state == scan_in_string)
+      {
+         /* Skip quickly over the characters that don't matter here. */
+         while (c != '{' && c != '}' && c != '(' && c != ')' &&
+                c != '"' && c != '\n' && ++i < len)
+            c = (unsigned char) buf[i];
+         if (i == len)
+            break;
+
+         switch (c)
+         {
+            case '\n':
+               lineno++;
+               continue;
+            case '{':
+               brace_depth++;
+               continue;
+            case '}':
+               if (--brace_depth < 0)   /* "too many }'s" error */
+                  goto error;
+               if (string_opener != '{' || brace_depth > 0)
+                  continue;
+               break;
+            case '(':
+               paren_depth++;
+               continue;
+            case ')':
+               if (--paren_depth > 0 || string_opener != '(')
+                  continue;
+               break;
+            case '"':
+               if (string_opener != '"' || brace_depth > 0)
+                  continue;
+               break;
+            default:
+               continue;
+         }
+
+         /* Reached the end of the string. */
+         if (brace_depth > 0)           /* "too many {'s" error */
+            goto error;
+         if (span->metatype == BTE_COMMENT)
+            goto end_of_entry;
+         state = scan_in_entry;
+         continue;
+      }
+
+      if (c == '\n')
+         lineno++;
+
+      if (state == scan_toplevel)
+      {
+         if (c == ' ' || c == '\r' || c == '\t' || c == '\n')
+            in_junk = FALSE;
+         else if (c == '@')
+         {
+            span->offset = i;
+            span->line = lineno;
+            state = scan_after_at;
+         }
+         else if (c == '%' && !in_junk
+                  && (eol = memchr (buf + i, '\n', len - i)) != NULL)
+         {
+            i = eol - buf;              /* skip comment, count newline */
+            lineno++;
+         }
+         else
+            in_junk = TRUE;
+         continue;
+      }
+
+      /*
+       * Now we're in one of the LEX_ENTRY states: scan_after_at,
+       * scan_after_type, scan_in_comment, or scan_in_entry.
+       */
+      if (c == ' ' || c == '\r' || c == '\t' || c == '\n')
+         continue;
+
+      if (c == '%')
+      {
+         eol = memchr (buf + i, '\n', len - i);
+         if (eol == NULL)               /* not a comment: lexical error */
+            goto error;
+         i = eol - buf;
+         lineno++;
+         continue;
+      }
+
+      if (IS_NAME_CHAR (c))
+      {
+         boolean  all_digits = TRUE;
+
+         for (j = i; j < len && IS_NAME_CHAR ((unsigned char) buf[j]); j++)
+         {
+            if (!isdigit ((unsigned char) buf[j]))
+               all_digits = FALSE;
+         }
+
+         if (state == scan_after_at && !all_digits)
+         {
+            span->type = buf + i;
+            span->type_len = j - i;
+            span->metatype = type_metatype (buf + i, j - i);
+            state = (span->metatype == BTE_COMMENT)
+               ? scan_in_comment : scan_after_type;
+         }
+         else if (state == scan_in_entry)
+         {
+            if (first_token && span->metatype == BTE_REGULAR)
+            {
+               span->key = buf + i;
+               span->key_len = j - i;
+            }
+            first_token = FALSE;
+         }
+         else
+            goto error;                 /* parser will complain */
+
+         i = j - 1;
+         continue;
+      }
+
+      first_token = FALSE;
+      switch (c)
+      {
+         case '{':
+         case '(':
+            if (state == scan_after_type)
+            {
+               state = scan_in_entry;
+               entry_opener = c;
+               first_token = TRUE;
+               continue;
+            }
+            if (state == scan_in_comment || (state == scan_in_entry && c == '{'))
+            {
+               state = scan_in_string;
+               string_opener = c;
+               brace_depth = (c == '{');
+               paren_depth = (c == '(');
+               continue;
+            }
+            goto error;
+
+         case '"':
+            if (state != scan_in_entry)
+               goto error;
+            state = scan_in_string;
+            string_opener = c;
+            brace_depth = paren_depth = 0;
+            continue;
+
+         case '}':
+         case ')':
+            if (state != scan_in_entry || c != (entry_opener == '{' ? '}' : ')'))
+               goto error;
+            goto end_of_entry;
+
+         case '=':
+         case '#':
+         case ',':
+            if (state != scan_in_entry)
+               goto error;
+            continue;
+
+         default:                       /* '@' or an invalid character */
+            goto error;
+      }
+   }
+
+   /* Ran out of text: fine if we weren't in the middle of an entry. */
+   *pos = len;
+   *line = lineno;
+   return (state == scan_toplevel) ? 0 : -1;
+
+end_of_entry:
+   span->length = i + 1 - span->offset;
+   *pos = i + 1;
+   *line = lineno;
+   return 1;
+
+error:
+   *pos = i;
+   *line = lineno;
+   return -1;
+
+} /* scan_next_entry() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_scan_buffer()
+@INPUT      : buf      - text to scan (need not be null-terminated)
+              len      - number of characters in `buf'
+              callback - function to call for each entry (may be NULL)
+              data     - passed on to `callback'
+@OUTPUT     : *status  - FALSE if any part of the text couldn't be scanned
+                         (ie. the parser would have found errors there)
+@RETURNS    : number of entries found
+@DESCRIPTION: Finds the entries in a buffer, reporting each one's type,
+              key, position and line number to `callback'.  If the
+              callback returns BTCB_STOP, scanning stops there.
+
+              No error messages are printed.  When the scan runs into
+              something it can't make sense of, it just skips ahead to
+              the next `@' and carries on from there, without reporting
+              the broken entry.
+@GLOBALS    :
+@CALLS      : scan_next_entry()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+int bt_scan_buffer (const char *     buf,
+                    size_t           len,
+                    bt_span_callback callback,
+                    void *           data,
+                    boolean *        status)
+{
+   bt_entry_span span;
+   size_t        pos;
+   int           line;
+   int           num_entries;
+   boolean       ok;
+   int           result;
+   const char *  next;
+
+   if (buf == NULL && len > 0)
+      usage_error ("bt_scan_buffer: no buffer supplied");
+
+   pos = 0;
+   line = 1;
+   num_entries = 0;
+   ok = TRUE;
+   while ((result = scan_next_entry (buf, len, &pos, &line, &span)) != 0)
+   {
+      if (result < 0)
+      {
+         ok = FALSE;
+         next = memchr (buf + pos, '@', len - pos);
+         if (next == NULL)
+            next = buf + len;
+         for (; pos < (size_t) (next - buf); pos++)
+         {
+            if (buf[pos] == '\n')
+               line++;
+         }
+         continue;
+      }
+
+      num_entries++;
+      if (callback != NULL && ((*callback) (&span, data) & BTCB_STOP))
+         break;
+   }
+
+   if (status) *status = ok;
+   return num_entries;
+
+} /* bt_scan_buffer() */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_scan_file()
+@INPUT      : filename - file to scan (stdin can't be scanned)
+              callback
+              data
+@OUTPUT     : *status
+@RETURNS    : number of entries found, or -1 if the file couldn't be read
+@DESCRIPTION: Loads a whole file with map_file() and scans it with
+              bt_scan_buffer().  The `type' and `key' pointers passed to
+              the callback point into the loaded file, so are only good
+              until the callback returns; `offset' and `length' are what
+              you need to find the entry again later.
+@GLOBALS    :
+@CALLS      : map_file(), bt_scan_buffer(), unmap_file()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+int bt_scan_file (char *           filename,
+                  bt_span_callback callback,
+                  void *           data,
+                  boolean *        status)
+{
+   char *      buf;
+   size_t      len;
+   int         num_entries;
+
+   if (filename == NULL || strcmp (filename, "-") == 0)
+      usage_error ("bt_scan_file: can't scan standard input");
+
+   if (! map_file (filename, &buf, &len))
+   {
+      if (status) *status = FALSE;
+      return -1;
+   }
+   num_entries = bt_scan_buffer (buf, len, callback, data, status);
+   unmap_file (buf, len);
+   return num_entries;
+}
@@ -0,0 +1,135 @@
+/* ------------------------------------------------------------------------
+@NAME       : stats.c
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Counters and timings for each stage of parsing (see
+              bt_get_stats()), kept only if btparse was configured with
+              --enable-stats.  Like the error counts, they're per thread,
+              so counting is just an increment; bt_parse_buffer_parallel()
+              adds its worker threads' counts to the caller's.
+@GLOBALS    : ParseStats
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse library.  This library is
+              free software; you can redistribute it and/or modify it under
+              the terms of the GNU Library General Public License as
+              published by the Free Software Foundation; either version 2
+              of the License, or (at your option) any later version.
+-------------------------------------------------------------------------- */
+
+#include "bt_config.h"
+#include <string.h>
+#include <time.h>
+#include "btparse.h"
+#include "stats.h"
+#include "my_dmalloc.h"
+
+
+#if BT_STATS
+
+BT_THREAD_LOCAL bt_stats ParseStats;
+
+
+/* ------------------------------------------------------------------------
+@NAME       : stats_clock()
+@INPUT      :
+@OUTPUT     :
+@RETURNS    : the time, in seconds since some arbitrary point
+@DESCRIPTION: The clock that the stage timings are kept with: a monotonic
+              one if the system has it, otherwise CPU time.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+double stats_clock (void)
+{
+#ifdef CLOCK_MONOTONIC
+   struct timespec now;
+
+   clock_gettime (CLOCK_MONOTONIC, &now);
+   return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+#else
+   return (double) clock () / CLOCKS_PER_SEC;
+#endif
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : add_stats()
+@INPUT      : stats - counts from another thread
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Adds `stats' to the current thread's counts.
+@GLOBALS    : ParseStats
+@CALLERS    : bt_parse_buffer_parallel()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void add_stats (bt_stats * stats)
+{
+   int   i;
+
+   ParseStats.bytes_lexed += stats->bytes_lexed;
+   ParseStats.tokens += stats->tokens;
+   for (i = 0; i < NUM_METATYPES; i++)
+      ParseStats.entries[i] += stats->entries[i];
+   ParseStats.macro_lookups += stats->macro_lookups;
+   ParseStats.macro_hits += stats->macro_hits;
+   ParseStats.strings_pasted += stats->strings_pasted;
+   ParseStats.lex_reallocs += stats->lex_reallocs;
+   ParseStats.ast_nodes += stats->ast_nodes;
+   ParseStats.parse_time += stats->parse_time;
+   ParseStats.postprocess_time += stats->postprocess_time;
+}
+
+#endif /* BT_STATS */
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_get_stats()
+@INPUT      :
+@OUTPUT     : *stats - what the parser has done in this thread since the
+                       last bt_reset_stats() (all zero if counting isn't
+                       compiled in)
+@RETURNS    : TRUE if btparse was configured with --enable-stats,
+              FALSE otherwise
+@DESCRIPTION: Reports how much work each stage of parsing has done: how
+              much input was lexed, how many tokens, entries and AST nodes
+              resulted, how the macro table and the lexical buffer were
+              used, and the time spent lexing, parsing and
+              post-processing.  This is to find out *why* some input is
+              slow to parse -- whether it's the sheer bulk, heavy use of
+              macros, huge strings, or error recovery.
+@GLOBALS    : ParseStats
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+boolean bt_get_stats (bt_stats * stats)
+{
+#if BT_STATS
+   *stats = ParseStats;
+   return TRUE;
+#else
+   memset (stats, 0, sizeof (bt_stats));
+   return FALSE;
+#endif
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_reset_stats()
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Zeroes the current thread's counters and timings.
+@GLOBALS    : ParseStats
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void bt_reset_stats (void)
+{
+#if BT_STATS
+   memset (&ParseStats, 0, sizeof (bt_stats));
+#endif
+}
@@ -0,0 +1,37 @@
+/* ------------------------------------------------------------------------
+@NAME       : stats.h
+@DESCRIPTION: Macros for keeping the counters and timings reported by
+              bt_get_stats().  Unless btparse was configured with
+              --enable-stats (which defines BT_STATS), they compile to
+              nothing, and there's no cost at all.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse library.  This library is
+              free software; you can redistribute it and/or modify it under
+              the terms of the GNU Library General Public License as
+              published by the Free Software Foundation; either version 2
+              of the License, or (at your option) any later version.
+-------------------------------------------------------------------------- */
+#ifndef STATS_H
+#define STATS_H
+
+#include "btparse.h"
+
+#if BT_STATS
+
+extern BT_THREAD_LOCAL bt_stats ParseStats;
+
+double stats_clock (void);
+void   add_stats (bt_stats * stats);
+
+# define COUNT(counter)          (ParseStats.counter++)
+# define COUNT_N(counter,n)      (ParseStats.counter += (n))
+
+#else
+
+# define COUNT(counter)          ((void) 0)
+# define COUNT_N(counter,n)      ((void) 0)
+
+#endif /* BT_STATS */
+
+#endif /* STATS_H */
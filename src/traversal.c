@@ -127,6 +127,7 @@ AST *bt_next_value (AST *top, AST *prev, bt_nodetype *nodetype, char **text)
    {
       if (prev == NULL)                 /* no previous value -- give 'em */
       {                                 /* the first one */
+         apply_pending (top);           /* (postprocessed, if lazy) */
          value = top->down;
          if (!value) return NULL;
          if (nodetype) *nodetype = value->nodetype;
@@ -178,6 +179,7 @@ char *bt_get_text (AST *node)
    }
    else if (nt == BTAST_ENTRY && (mt == BTE_COMMENT || mt == BTE_PREAMBLE))
    {
+      apply_pending (node);
       return bt_postprocess_value (node->down, pp_options, FALSE);
    }
    else
@@ -185,3 +187,69 @@ char *bt_get_text (AST *node)
       return NULL;
    }
 }
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_get_value()
+@INPUT      : node - a field, or a comment or preamble entry
+@OUTPUT     : 
+@RETURNS    : the (postprocessed) text of the node's value, or NULL if
+              it's not a single string or number (eg. if it's several
+              simple values, or a macro that wasn't expanded)
+@DESCRIPTION: Like bt_get_text(), but returns the text stored in the AST
+              rather than making a fresh copy, so it's cheap to call
+              again and again -- but you mustn't free() the result.  If
+              the entry was parsed with BTO_LAZY, the value is
+              postprocessed (once only) according to the string options
+              in effect at the time.  If those options didn't include
+              BTO_PASTE, the value can still consist of several simple
+              values, in which case there's no one string to return; use
+              bt_next_value() instead.
+@CALLS      : apply_pending()
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+char *bt_get_value (AST *node)
+{
+   bt_nodetype nt;
+   bt_metatype mt;
+
+   if (!node) return NULL;
+   nt = node->nodetype;
+   mt = node->metatype;
+   if (nt != BTAST_FIELD &&
+       !(nt == BTAST_ENTRY && (mt == BTE_COMMENT || mt == BTE_PREAMBLE)))
+      return NULL;
+
+   apply_pending (node);
+   if (node->down == NULL || node->down->right != NULL ||
+       node->down->nodetype == BTAST_MACRO)
+      return NULL;
+   return node->down->text;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : fetch_value()
+@INPUT      : node - a field, or a comment or preamble entry
+@OUTPUT     : *copied - TRUE if the value had to be copied (so must be
+                        freed)
+@RETURNS    : the node's value as a single string
+@DESCRIPTION: Uses the post-processed text in the AST if there's just one
+              string or number, otherwise pastes the values (expanding
+              any macros) with bt_get_text().
+@CALLS      : bt_get_value(), bt_get_text()
+@CALLERS    : bt_entry_compact() (compact.c), fetch_values() (dedup.c)
+@CREATED    : 2026/10/16
+@MODIFIED   : 
+-------------------------------------------------------------------------- */
+char *fetch_value (AST *node, boolean *copied)
+{
+   char *  value;
+
+   value = bt_get_value (node);
+   *copied = (value == NULL);
+   if (value == NULL)
+      value = bt_get_text (node);
+   return value;
+}
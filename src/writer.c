@@ -0,0 +1,697 @@
+/* ------------------------------------------------------------------------
+@NAME       : writer.c
+@INPUT      :
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Writing entries back out as BibTeX.  A bt_writer collects
+              its output in a large buffer, which is written to the
+              writer's stream only when it fills up (or, for a writer
+              with no stream, just grows), so writing an entry is a
+              matter of copying strings around rather than a stdio call
+              per token.  The writer also holds the layout options:
+              how to delimit strings, how far to indent fields, and
+              which fields to put first.
+
+              If the writer is told what text the entries were parsed
+              from (with bt_writer_set_source()), entries that haven't
+              been changed since (see bt_set_text()) are copied straight
+              from that text, exactly as they were written.  (Entries
+              that had fields dropped or errors patched over when they
+              were parsed count as changed.)
+@GLOBALS    :
+@CALLS      :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+@COPYRIGHT  : This file is part of the btparse library.  This library is
+              free software; you can redistribute it and/or modify it under
+              the terms of the GNU Library General Public License as
+              published by the Free Software Foundation; either version 2
+              of the License, or (at your option) any later version.
+-------------------------------------------------------------------------- */
+
+#include "bt_config.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "btparse.h"
+#include "error.h"
+#include "prototypes.h"
+#include "my_dmalloc.h"
+
+
+#define WRITER_BUF_SIZE  (256 * 1024)
+
+struct bt_writer_s
+{
+   FILE *       stream;                 /* NULL to keep it all in memory */
+   char *       buf;
+   size_t       used;
+   size_t       size;
+   boolean      failed;                 /* a write to `stream' failed */
+
+   char         quote;                  /* `{' or `"' around strings */
+   int          indent;                 /* spaces before each field */
+   char **      order;                  /* (interned) fields to put first */
+   int          num_order;
+
+   const char * source;                 /* text the entries came from */
+   size_t       source_len;
+
+   AST **       fields;                 /* scratch, for reordering */
+   int          fields_alloc;
+   long         num_entries;            /* written so far */
+};
+
+
+/* ------------------------------------------------------------------------
+@NAME       : flush_buffer()
+@INPUT      : writer
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Writes out whatever is in the buffer, if the writer has a
+              stream to write it to.  After a failed write, output is
+              thrown away (bt_writer_flush() reports the failure).
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+flush_buffer (bt_writer * writer)
+{
+   if (writer->stream == NULL || writer->used == 0)
+      return;
+   if (!writer->failed &&
+       fwrite (writer->buf, 1, writer->used, writer->stream) != writer->used)
+      writer->failed = TRUE;
+   writer->used = 0;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : put_text()
+@INPUT      : writer
+              s, n - text to add to the output
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Adds text to the writer's buffer, first making room by
+              flushing the buffer (or by growing it, for a writer with
+              no stream).  Text too big for the buffer goes straight to
+              the stream.  Space for a trailing NUL is always kept, for
+              bt_writer_text().
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+put_text (bt_writer * writer, const char * s, size_t n)
+{
+   if (writer->used + n >= writer->size)
+   {
+      if (writer->stream == NULL)
+      {
+         while (writer->used + n >= writer->size)
+            writer->size *= 2;
+         writer->buf = (char *) realloc (writer->buf, writer->size);
+         if (writer->buf == NULL)
+            internal_error ("out of memory writing entries");
+      }
+      else
+      {
+         flush_buffer (writer);
+         if (n >= writer->size)
+         {
+            if (!writer->failed && fwrite (s, 1, n, writer->stream) != n)
+               writer->failed = TRUE;
+            return;
+         }
+      }
+   }
+   memcpy (writer->buf + writer->used, s, n);
+   writer->used += n;
+}
+
+#define put_string(writer,s) put_text (writer, s, strlen (s))
+
+#define put_char(writer,c)                              \
+   do                                                   \
+   {                                                    \
+      if ((writer)->used + 1 < (writer)->size)          \
+         (writer)->buf[(writer)->used++] = (c);         \
+      else                                              \
+      {                                                 \
+         char ch = (c);                                 \
+         put_text (writer, &ch, 1);                     \
+      }                                                 \
+   } while (0)
+
+
+/* ------------------------------------------------------------------------
+@NAME       : put_value()
+@INPUT      : writer
+              top - a field, or a comment or preamble entry
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Writes the value of `top': its simple values, joined by
+              `#'.  Strings are delimited as the writer says, except
+              that a string with a double quote outside braces can't go
+              in quotes, so it gets braces instead.  (This walks the
+              values itself, as bt_next_value() won't allow a preamble
+              with macros in it.)
+@CALLS      : apply_pending()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+put_value (bt_writer * writer, AST * top)
+{
+   AST *        value;
+   bt_nodetype  nodetype;
+   char *       text;
+   const char * p;
+   int          depth;
+   boolean      braces;
+
+   apply_pending (top);                 /* (postprocessed, if lazy) */
+   for (value = top->down; value != NULL; value = value->right)
+   {
+      nodetype = value->nodetype;
+      text = value->text;
+      if (value != top->down)
+         put_text (writer, " # ", 3);
+      if (nodetype != BTAST_STRING)
+      {
+         if (text) put_string (writer, text);
+         continue;
+      }
+
+      braces = (writer->quote == '{');
+      if (!braces && text)
+      {
+         for (p = text, depth = 0; *p; p++)
+         {
+            if (*p == '{') depth++;
+            else if (*p == '}') depth--;
+            else if (*p == '"' && depth == 0) break;
+         }
+         braces = (*p != (char) 0);
+      }
+      put_char (writer, braces ? '{' : '"');
+      if (text) put_string (writer, text);
+      put_char (writer, braces ? '}' : '"');
+   }
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : put_field()
+@INPUT      : writer
+              field
+              sep   - what ends the previous line (the key or field)
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Writes one field of a regular entry, on a line of its own.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+put_field (bt_writer * writer, AST * field, const char * sep)
+{
+   int   i;
+
+   put_string (writer, sep);
+   for (i = 0; i < writer->indent; i++)
+      put_char (writer, ' ');
+   put_string (writer, field->text);
+   put_text (writer, " = ", 3);
+   put_value (writer, field);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : same_name()
+@INPUT      : field
+              name - an interned field name
+@RETURNS    : TRUE if `field' is called `name' (ignoring case)
+@DESCRIPTION: Field names are atoms, so normally comparing pointers is
+              enough; a name changed with bt_set_text() isn't, though.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static boolean
+same_name (AST * field, char * name)
+{
+   if (field->atom != 0)
+      return field->text == name;
+   return field->text != NULL && bt_intern (field->text, NULL) == name;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : write_regular()
+@INPUT      : writer
+              entry - a regular entry
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Writes a regular entry, one field per line, with the
+              fields named by bt_writer_set_order() first (in that
+              order), then the rest as they were.
+@CALLS      : bt_next_field()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+write_regular (bt_writer * writer, AST * entry)
+{
+   AST *   field;
+   char *  name;
+   char *  key;
+   char *  sep;                         /* before the next field */
+   int     num_fields;
+   int     i, j;
+
+   put_char (writer, '@');
+   put_string (writer, bt_entry_type (entry));
+   put_char (writer, '{');
+   key = bt_entry_key (entry);
+   if (key) put_string (writer, key);
+
+   sep = key ? ",\n" : "\n";
+   if (writer->num_order == 0)
+   {
+      field = NULL;
+      while ((field = bt_next_field (entry, field, &name)))
+      {
+         put_field (writer, field, sep);
+         sep = ",\n";
+      }
+   }
+   else
+   {
+      num_fields = 0;
+      field = NULL;
+      while ((field = bt_next_field (entry, field, &name)))
+      {
+         if (num_fields == writer->fields_alloc)
+         {
+            writer->fields_alloc = writer->fields_alloc
+                                   ? writer->fields_alloc * 2 : 64;
+            writer->fields = (AST **)
+               realloc (writer->fields, writer->fields_alloc * sizeof (AST *));
+            if (writer->fields == NULL)
+               internal_error ("out of memory writing entries");
+         }
+         writer->fields[num_fields++] = field;
+      }
+
+      for (i = 0; i < writer->num_order; i++)
+      {
+         for (j = 0; j < num_fields; j++)
+         {
+            if (writer->fields[j] && same_name (writer->fields[j],
+                                                writer->order[i]))
+            {
+               put_field (writer, writer->fields[j], sep);
+               writer->fields[j] = NULL;
+               sep = ",\n";
+            }
+         }
+      }
+      for (j = 0; j < num_fields; j++)
+      {
+         if (writer->fields[j])
+         {
+            put_field (writer, writer->fields[j], sep);
+            sep = ",\n";
+         }
+      }
+   }
+
+   if (sep[0] == ',')                   /* wrote some fields */
+      put_text (writer, "\n}\n", 3);
+   else
+      put_text (writer, "}\n", 2);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : write_other()
+@INPUT      : writer
+              entry - a macro definition, comment, or preamble entry
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Writes a non-regular entry on one line: a macro
+              definition's macros separated by commas, or the value of a
+              comment or preamble.  A comment's text goes in braces
+              whatever the writer's quote, as there's no other way for
+              BibTeX to read it back.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static void
+write_other (bt_writer * writer, AST * entry)
+{
+   AST *   field;
+   char *  name;
+   char *  text;
+
+   put_char (writer, '@');
+   put_string (writer, bt_entry_type (entry));
+   put_char (writer, '{');
+
+   switch (entry->metatype)
+   {
+      case BTE_MACRODEF:
+         field = NULL;
+         while ((field = bt_next_field (entry, field, &name)))
+         {
+            if (field != entry->down)
+               put_text (writer, ", ", 2);
+            put_string (writer, field->text);
+            put_text (writer, " = ", 3);
+            put_value (writer, field);
+         }
+         break;
+      case BTE_COMMENT:
+         bt_next_value (entry, NULL, NULL, &text);
+         if (text) put_string (writer, text);
+         break;
+      default:
+         put_value (writer, entry);
+         break;
+   }
+
+   put_text (writer, "}\n", 2);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : any_changed()
+@INPUT      : node - first of a list of siblings
+@RETURNS    : TRUE if any node in the list, or below, has been changed
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static boolean
+any_changed (AST * node)
+{
+   for ( ; node != NULL; node = node->right)
+   {
+      if (node->changed || any_changed (node->down))
+         return TRUE;
+   }
+   return FALSE;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : copy_source()
+@INPUT      : writer
+              entry
+@OUTPUT     :
+@RETURNS    : TRUE if the entry was copied from the writer's source text
+@DESCRIPTION: The fast path for entries that haven't been changed: finds
+              the entry in the source text by its offset (that of its
+              type, counting from 1, just past the `@'), finds its end,
+              and copies it as it was.  If the entry doesn't seem to be
+              there, or was changed, returns FALSE, and it's written in
+              the usual way.
+
+              The end of the entry is found by the scanner rather than
+              by matching braces, since a `%' comment inside the entry
+              may have an unbalanced brace in it.
+@CALLS      : scan_next_entry()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+static boolean
+copy_source (bt_writer * writer, AST * entry)
+{
+   const char *  source = writer->source;
+   size_t        len = writer->source_len;
+   const char *  type;
+   bt_entry_span span;
+   size_t        start, pos;
+   int           line;
+
+   if (entry->offset < 1 || (size_t) entry->offset > len ||
+       entry->changed || any_changed (entry->down))
+      return FALSE;
+
+   start = entry->offset - 1;           /* back from the type to the `@' */
+   while (start > 0 && isspace ((unsigned char) source[start-1]))
+      start--;
+   if (start == 0 || source[start-1] != '@')
+      return FALSE;
+   start--;
+
+   pos = entry->offset - 1;             /* make sure the type's there */
+   for (type = bt_entry_type (entry); *type; type++, pos++)
+   {
+      if (pos == len || tolower ((unsigned char) source[pos]) != *type)
+         return FALSE;
+   }
+
+   pos = start;
+   line = entry->line;
+   if (scan_next_entry (source, len, &pos, &line, &span) != 1 ||
+       span.offset != start)
+      return FALSE;
+   put_text (writer, source + span.offset, span.length);
+   put_char (writer, '\n');
+   return TRUE;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_writer_new()
+@INPUT      : stream - where to write entries, or NULL to keep them in
+                       memory (see bt_writer_text())
+@OUTPUT     :
+@RETURNS    : a new writer, which writes strings in braces and indents
+              fields by two spaces
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+bt_writer * bt_writer_new (FILE * stream)
+{
+   bt_writer *  writer;
+
+   writer = (bt_writer *) calloc (1, sizeof (bt_writer));
+   if (writer == NULL)
+      internal_error ("out of memory creating writer");
+   writer->stream = stream;
+   writer->size = WRITER_BUF_SIZE;
+   writer->buf = (char *) malloc (writer->size);
+   if (writer->buf == NULL)
+      internal_error ("out of memory creating writer");
+   writer->quote = '{';
+   writer->indent = 2;
+   return writer;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_writer_set_quote()
+@INPUT      : writer
+              quote  - `{' to put strings in braces, or `"' for quotes
+@OUTPUT     :
+@RETURNS    :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void bt_writer_set_quote (bt_writer * writer, char quote)
+{
+   if (quote != '{' && quote != '"')
+      usage_error ("bt_writer_set_quote: quote must be '{' or '\"'");
+   writer->quote = quote;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_writer_set_indent()
+@INPUT      : writer
+              indent - number of spaces to put before each field
+@OUTPUT     :
+@RETURNS    :
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void bt_writer_set_indent (bt_writer * writer, int indent)
+{
+   if (indent < 0)
+      usage_error ("bt_writer_set_indent: indent can't be negative");
+   writer->indent = indent;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_writer_set_order()
+@INPUT      : writer
+              fields - NULL-terminated list of field names (or NULL)
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Sets the fields to write first in each regular entry, in
+              the order given; fields not in the list follow, in their
+              original order.  With NULL (or an empty list), every field
+              stays where it was.
+@CALLS      : bt_intern()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void bt_writer_set_order (bt_writer * writer, char ** fields)
+{
+   int   n;
+
+   free (writer->order);
+   writer->order = NULL;
+   writer->num_order = 0;
+   if (fields == NULL)
+      return;
+
+   for (n = 0; fields[n] != NULL; n++)
+      ;
+   writer->order = (char **) malloc ((n + 1) * sizeof (char *));
+   if (writer->order == NULL)
+      internal_error ("out of memory setting field order");
+   for (n = 0; fields[n] != NULL; n++)
+      writer->order[n] = bt_intern (fields[n], NULL);
+   writer->num_order = n;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_writer_set_source()
+@INPUT      : writer
+              buf, len - the text the entries to be written were parsed
+                         from (or NULL), eg. as passed to bt_parse_buffer()
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Lets the writer copy unchanged entries straight from the
+              text they were parsed from.  `buf' must stay put for as
+              long as the writer is using it.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void bt_writer_set_source (bt_writer * writer, const char * buf, size_t len)
+{
+   writer->source = buf;
+   writer->source_len = buf ? len : 0;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_write_entry()
+@INPUT      : entry
+              writer
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Writes one entry as BibTeX, on lines of its own, with a
+              blank line between it and the writer's previous entry.
+@CALLS      : copy_source(), write_regular(), write_other()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void bt_write_entry (AST * entry, bt_writer * writer)
+{
+   if (entry == NULL || entry->nodetype != BTAST_ENTRY)
+      usage_error ("bt_write_entry: not an entry");
+   if (writer->num_entries++ > 0)
+      put_char (writer, '\n');
+   if (writer->source != NULL && copy_source (writer, entry))
+      return;
+
+   switch (entry->metatype)
+   {
+      case BTE_REGULAR:
+         write_regular (writer, entry);
+         break;
+      case BTE_MACRODEF:
+      case BTE_COMMENT:
+      case BTE_PREAMBLE:
+         write_other (writer, entry);
+         break;
+      default:
+         usage_error ("bt_write_entry: entry has unknown metatype");
+   }
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_write_forest()
+@INPUT      : entries - list of entries (eg. from bt_parse_file())
+              writer
+@OUTPUT     :
+@RETURNS    :
+@DESCRIPTION: Writes a list of entries, one after another.
+@CALLS      : bt_write_entry()
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+void bt_write_forest (AST * entries, bt_writer * writer)
+{
+   AST *   entry;
+
+   for (entry = entries; entry != NULL; entry = entry->right)
+      bt_write_entry (entry, writer);
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_writer_flush()
+@INPUT      : writer
+@OUTPUT     :
+@RETURNS    : FALSE if any write to the writer's stream has failed
+@DESCRIPTION: Writes out everything buffered so far, and flushes the
+              stream as well.
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+boolean bt_writer_flush (bt_writer * writer)
+{
+   flush_buffer (writer);
+   if (writer->stream != NULL && fflush (writer->stream) != 0)
+      writer->failed = TRUE;
+   return !writer->failed;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_writer_text()
+@INPUT      : writer - a writer with no stream
+@OUTPUT     : *len   - (if not NULL) length of the text
+@RETURNS    : everything written so far, null-terminated; it belongs to
+              the writer, and moves when more is written
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+char * bt_writer_text (bt_writer * writer, size_t * len)
+{
+   if (writer->stream != NULL)
+      usage_error ("bt_writer_text: writer has a stream");
+   writer->buf[writer->used] = (char) 0;
+   if (len) *len = writer->used;
+   return writer->buf;
+}
+
+
+/* ------------------------------------------------------------------------
+@NAME       : bt_writer_free()
+@INPUT      : writer
+@OUTPUT     :
+@RETURNS    : as for bt_writer_flush()
+@DESCRIPTION: Flushes a writer and frees it (but doesn't close its
+              stream).
+@CREATED    : 2026/10/16
+@MODIFIED   :
+-------------------------------------------------------------------------- */
+boolean bt_writer_free (bt_writer * writer)
+{
+   boolean  ok;
+
+   if (writer == NULL) return TRUE;
+   ok = bt_writer_flush (writer);
+   free (writer->buf);
+   free (writer->order);
+   free (writer->fields);
+   free (writer);
+   return ok;
+}
@@ -0,0 +1,1615 @@
+/*
+ * parser_test.c
+ *
+ * checks the bt_parser objects, and everything built on them: parsing
+ * whole files, buffers, batches and streams, in parallel or in several
+ * threads at once; lazy post-processing, field selection and compact
+ * entries; skip-scanning, indexes, key maps and caches; the writer; and
+ * duplicate detection.  Each test_*() function checks one feature, and
+ * says what it checks.
+ */
+
+#include "bt_config.h"               /* for dmalloc() stuff */
+#include <stdlib.h>
+#include <string.h>
+#if HAVE_PTHREAD_H && HAVE_LIBPTHREAD
+# include <pthread.h>
+#endif
+
+#include "testlib.h"
+#include "my_dmalloc.h"
+
+#define SIG_SIZE 2048
+#define NUM_THREADS 4
+#define NUM_LONG 200000                 /* entries in a really long list */
+#define NUM_PARALLEL 20000              /* entries to parse in parallel */
+#define NUM_HUGE 4000000                /* characters in a really big value */
+#define NUM_FIELDS 2000                 /* fields in a really big entry */
+#define NUM_RUNS 70                     /* runs of plain text in a string */
+#define NUM_WARN 50                     /* entries with warnings */
+
+
+/*
+ * Appends a one-line description of `entry' (metatype, type, key, and
+ * all field names and values) to `sig'.
+ */
+static void
+add_signature (char *sig, AST *entry)
+{
+   AST *  field;
+   char * name;
+   char * key;
+   char * text;
+   char   buf[256];
+
+   key = bt_entry_key (entry);
+   sprintf (buf, "%d %s %s:",
+            bt_entry_metatype (entry), bt_entry_type (entry),
+            key ? key : "(none)");
+   strcat (sig, buf);
+
+   field = NULL;
+   while ((field = bt_next_field (entry, field, &name)))
+   {
+      text = bt_get_text (field);
+      sprintf (buf, " %s=%s", name ? name : "", text);
+      strcat (sig, buf);
+      free (text);
+   }
+   strcat (sig, "\n");
+}
+
+
+/*
+ * Puts the signature of a whole list of entries in `sig', and frees
+ * the list.
+ */
+static void
+forest_signature (AST *entries, char *sig)
+{
+   AST *   entry;
+
+   sig[0] = (char) 0;
+   entry = NULL;
+   while ((entry = bt_next_entry (entries, entry)))
+      add_signature (sig, entry);
+   bt_free_ast (entries);
+}
+
+
+/*
+ * Parses a whole file with bt_parse_file() and returns its signature
+ * in `sig'.
+ */
+static boolean
+file_signature (char *filename, char *sig)
+{
+   boolean status;
+
+   forest_signature (bt_parse_file (filename, 0, &status), sig);
+   return status;
+}
+
+
+/*
+ * Callbacks for bt_process_file(): one just adds each entry to a
+ * signature, the other keeps the second entry it sees and stops after
+ * the third.
+ */
+static int
+sign_entry (AST *entry, boolean status, void *data)
+{
+   if (status)
+      add_signature ((char *) data, entry);
+   return BTCB_FREE;
+}
+
+static int NumSeen = 0;
+
+static int
+keep_second (AST *entry, boolean status, void *data)
+{
+   switch (++NumSeen)
+   {
+      case 2:
+         *(AST **) data = entry;
+         return BTCB_KEEP;
+      case 3:
+         return BTCB_STOP;
+      default:
+         return BTCB_FREE;
+   }
+}
+
+
+/*
+ * Callback for bt_scan_buffer(): checks that each span matches the next
+ * of a list of parsed entries.  (An entry's offset is that of its type,
+ * just past the `@', counting from 1.)
+ */
+typedef struct
+{
+   const char * buf;
+   AST *        entries;
+   AST *        entry;                  /* last one matched */
+   boolean      same;
+} scan_check;
+
+static int
+check_span (bt_entry_span *span, void *data)
+{
+   scan_check * check = (scan_check *) data;
+   AST *        entry;
+   char *       key;
+
+   entry = check->entry = bt_next_entry (check->entries, check->entry);
+   if (entry == NULL)
+   {
+      check->same = FALSE;
+      return BTCB_STOP;
+   }
+   key = bt_entry_key (entry);
+   check->same &= (span->metatype == bt_entry_metatype (entry) &&
+                   span->type == check->buf + entry->offset - 1 &&
+                   span->type_len == strlen (bt_entry_type (entry)) &&
+                   span->line == entry->line &&
+                   (key ? (span->key_len == strlen (key) &&
+                           strncmp (span->key, key, span->key_len) == 0)
+                        : span->key == NULL) &&
+                   check->buf[span->offset] == '@' &&
+                   strchr ("})", check->buf[span->offset + span->length - 1]));
+   return 0;
+}
+
+
+/* Another bt_scan_buffer() callback: remembers the last span. */
+static int
+last_span (bt_entry_span *span, void *data)
+{
+   *(bt_entry_span *) data = *span;
+   return 0;
+}
+
+
+/*
+ * Checks that two lists of entries are the same, right down to the
+ * line number and offset of each entry, and frees them both.
+ */
+static boolean
+same_forest (AST *entries1, AST *entries2)
+{
+   AST *   entry1,
+       *   entry2;
+   char    sig1[SIG_SIZE],
+           sig2[SIG_SIZE];
+   boolean same = TRUE;
+
+   entry1 = entry2 = NULL;
+   do
+   {
+      entry1 = bt_next_entry (entries1, entry1);
+      entry2 = bt_next_entry (entries2, entry2);
+      if (entry1 == NULL || entry2 == NULL)
+      {
+         same &= (entry1 == entry2);
+         break;
+      }
+      sig1[0] = sig2[0] = (char) 0;
+      add_signature (sig1, entry1);
+      add_signature (sig2, entry2);
+      same &= (strcmp (sig1, sig2) == 0 &&
+               entry1->line == entry2->line &&
+               entry1->offset == entry2->offset);
+   }
+   while (same);
+
+   bt_free_ast (entries1);
+   bt_free_ast (entries2);
+   return same;
+}
+
+
+#if HAVE_PTHREAD_H && HAVE_LIBPTHREAD
+
+static char SimpleFile[256];
+
+static void *
+thread_main (void *arg)
+{
+   char *  sig = (char *) arg;
+   int     i;
+
+   /* parse it several times to give the threads a chance to overlap */
+   for (i = 0; i < 5; i++)
+      file_signature (SimpleFile, sig);
+   bt_cleanup ();                       /* free this thread's macro table */
+   return NULL;
+}
+
+#endif /* HAVE_PTHREAD_H && HAVE_LIBPTHREAD */
+
+
+/*
+ * Parsing two files in lock-step with two parsers, with a string parse
+ * thrown into the middle of each step for good measure, must give the
+ * same results as parsing each of them on its own.
+ */
+static boolean
+test_interleaved (char *filename1, char *expect1,
+                  char *filename2, char *expect2)
+{
+   FILE *      file1;
+   FILE *      file2;
+   bt_parser * parser1;
+   bt_parser * parser2;
+   AST *       entry;
+   AST *       entry1;
+   AST *       entry2;
+   boolean     status1;
+   boolean     status2;
+   char        got1[SIG_SIZE];
+   char        got2[SIG_SIZE];
+   boolean     ok = TRUE;
+
+   file1 = open_file ("simple.bib", DATA_DIR, filename1);
+   file2 = open_file ("regular.bib", DATA_DIR, filename2);
+   parser1 = bt_parser_new (file1, filename1);
+   parser2 = bt_parser_new (file2, filename2);
+   got1[0] = got2[0] = (char) 0;
+
+   entry1 = entry2 = NULL;
+   status1 = status2 = TRUE;
+   do
+   {
+      if (parser1)
+      {
+         entry1 = bt_parser_parse_entry (parser1, 0, &status1);
+         CHECK (status1);
+      }
+      entry = bt_parse_entry_s ("@misc{foo, title = {Interloper}}",
+                                NULL, 1, 0, NULL);
+      CHECK (entry != NULL && strcmp (bt_entry_key (entry), "foo") == 0);
+      bt_free_ast (entry);
+      if (parser2)
+      {
+         entry2 = bt_parser_parse_entry (parser2, 0, &status2);
+         CHECK (status2);
+      }
+
+      if (entry1)
+         add_signature (got1, entry1);
+      else if (parser1)                 /* at eof: done with this one */
+      {
+         bt_parser_free (parser1);
+         parser1 = NULL;
+      }
+      if (entry2)
+         add_signature (got2, entry2);
+      else if (parser2)
+      {
+         bt_parser_free (parser2);
+         parser2 = NULL;
+      }
+      bt_free_ast (entry1);
+      bt_free_ast (entry2);
+      entry1 = entry2 = NULL;
+   }
+   while (parser1 || parser2);
+
+   bt_parse_entry_s (NULL, NULL, 1, 0, NULL);
+   fclose (file1);
+   fclose (file2);
+
+   CHECK (strcmp (got1, expect1) == 0);
+   CHECK (strcmp (got2, expect2) == 0);
+   return ok;
+}
+
+
+/* The whole-file and in-memory parsers must give the same results. */
+static boolean
+test_whole_file (char *filename, char *expect)
+{
+   FILE *  file;
+   boolean status;
+   char    got[SIG_SIZE];
+   char    buf[SIG_SIZE];
+   size_t  len;
+   boolean ok = TRUE;
+
+   forest_signature (bt_parse_file_mmap (filename, 0, &status), got);
+   CHECK (status);
+   CHECK (strcmp (got, expect) == 0);
+
+   file = open_file ("regular.bib", DATA_DIR, filename);
+   len = fread (buf, 1, sizeof (buf) - 32, file);
+   fclose (file);
+
+   /* stuff past the end of the buffer must be ignored */
+   strcpy (buf + len, "@misc{past_the_end}");
+   forest_signature (bt_parse_buffer (buf, len, filename, 0, &status), got);
+   CHECK (status);
+   CHECK (strcmp (got, expect) == 0);
+
+   forest_signature (bt_parse_buffer (NULL, 0, NULL, 0, &status), got);
+   CHECK (status && got[0] == (char) 0);
+   return ok;
+}
+
+
+/*
+ * Streaming a file through a callback must see the same entries, and
+ * the callback must be able to keep an entry, or stop early.
+ */
+static boolean
+test_process_file (char *filename, char *expect)
+{
+   AST *   entry;
+   char    got[SIG_SIZE];
+   boolean ok = TRUE;
+
+   got[0] = (char) 0;
+   CHECK (bt_process_file (filename, 0, sign_entry, got));
+   CHECK (strcmp (got, expect) == 0);
+   entry = NULL;
+   CHECK (bt_process_file (filename, 0, keep_second, &entry));
+   CHECK (NumSeen == 3 && entry != NULL);
+   if (entry != NULL)
+   {
+      got[0] = (char) 0;
+      add_signature (got, entry);
+      CHECK (strncmp (got, strchr (expect, '\n') + 1, strlen (got)) == 0);
+      bt_free_ast (entry);
+   }
+   return ok;
+}
+
+
+/*
+ * With lazy post-processing, the values must come out the same once
+ * they're asked for -- and only be processed once.
+ */
+static boolean
+test_lazy (char *filename, char *expect)
+{
+   boolean status;
+   char    got[SIG_SIZE];
+   AST *   entries;
+   AST *   field;
+   char *  name;
+   char *  value;
+   boolean ok = TRUE;
+
+   forest_signature (bt_parse_file (filename, BTO_LAZY, &status), got);
+   CHECK (status);
+   CHECK (strcmp (got, expect) == 0);
+
+   entries = bt_parse_file (filename, BTO_LAZY, &status);
+   field = bt_next_field (entries, NULL, &name);
+   CHECK (field != NULL && field->pending != 0);
+   CHECK (name && strcmp (name, "title") == 0);
+   value = bt_get_value (field);
+   CHECK (value && strcmp (value, "A Book") == 0);
+   CHECK (field->pending == 0 && bt_get_value (field) == value);
+   CHECK (field->down && field->down->right == NULL);
+   bt_free_ast (entries);
+   return ok;
+}
+
+
+/*
+ * A macro that wasn't expanded has no value (only a name) to get from
+ * the AST; bt_get_text() must expand it, though.
+ */
+static boolean
+test_unexpanded_macro (void)
+{
+   boolean status;
+   AST *   entry;
+   AST *   field;
+   char *  name;
+   char *  value;
+   boolean ok = TRUE;
+
+   bt_set_stringopts (BTE_REGULAR, BTO_CONVERT);
+   entry = bt_parse_entry_s ("@string{mac = {m}}", NULL, 1, 0, &status);
+   bt_free_ast (entry);
+   entry = bt_parse_entry_s ("@misc{key, title = mac}", NULL, 1, 0, &status);
+   bt_set_stringopts (BTE_REGULAR, BTO_FULL);
+   CHECK (status);
+   field = bt_next_field (entry, NULL, &name);
+   CHECK (field->down->nodetype == BTAST_MACRO && bt_get_value (field) == NULL);
+   value = bt_get_text (field);
+   CHECK (value && strcmp (value, "m") == 0);
+   free (value);
+   bt_free_ast (entry);
+   bt_parse_entry_s (NULL, NULL, 1, 0, NULL);
+   bt_delete_macro ("mac");
+   return ok;
+}
+
+
+/*
+ * A compacted entry must have the same fields as the AST -- even
+ * after being copied somewhere else.
+ */
+static boolean
+test_compact (char *filename)
+{
+   AST *              entry;
+   boolean            status;
+   char               got1[SIG_SIZE];
+   char               got2[SIG_SIZE];
+   AST *              entries;
+   bt_compact_entry * compact;
+   bt_compact_entry * copy;
+   int                i;
+   boolean            ok = TRUE;
+
+   entries = bt_parse_file (filename, BTO_LAZY, &status);
+   for (entry = entries; entry != NULL; entry = entry->right)
+   {
+      compact = bt_entry_compact (entry);
+      copy = (bt_compact_entry *) malloc (compact->size);
+      memcpy (copy, compact, compact->size);
+      free (compact);
+
+      got1[0] = (char) 0;
+      sprintf (got1, "%d %s %s:", copy->metatype,
+               bt_compact_text (copy) + copy->type,
+               copy->key ? bt_compact_text (copy) + copy->key : "(none)");
+      for (i = 0; i < copy->num_fields; i++)
+         sprintf (got1 + strlen (got1), " %s=%s",
+                  bt_compact_name (copy, i), bt_compact_value (copy, i));
+      strcat (got1, "\n");
+      free (copy);
+
+      /*
+       * Values are as post-processed, which (by default) means macro
+       * definitions aren't collapsed; and comments and preambles
+       * have one nameless field.
+       */
+      got2[0] = (char) 0;
+      add_signature (got2, entry);
+      if (entry->metatype == BTE_REGULAR)
+      {
+         CHECK (strcmp (got1, got2) == 0);
+      }
+      else if (entry->metatype == BTE_MACRODEF)
+      {
+         CHECK (strstr (got1, " macro=macro  text  foo=") != NULL);
+      }
+      else
+      {
+         CHECK (strncmp (got1, got2, strlen (got2) - 1) == 0 &&
+                strncmp (got1 + strlen (got2) - 1, " =", 2) == 0);
+      }
+   }
+   bt_free_ast (entries);
+   return ok;
+}
+
+
+/*
+ * Field names and entry types must be atoms: the same lowercase text
+ * (and ID) for every node with that name, even in an arena.
+ */
+static boolean
+test_atoms (char *filename)
+{
+   AST *      entry1;
+   AST *      entry2;
+   boolean    status1;
+   boolean    status2;
+   AST *      entries1;
+   AST *      entries2;
+   bt_arena * arena;
+   int        id;
+   boolean    ok = TRUE;
+
+   entries1 = bt_parse_file (filename, 0, &status1);
+   arena = bt_arena_new (0);
+   bt_set_arena (arena);
+   entries2 = bt_parse_file (filename, BTO_LAZY, &status2);
+   bt_set_arena (NULL);
+   CHECK (status1 && status2);
+
+   CHECK (entries1->atom == BTA_BOOK && entries2->atom == BTA_BOOK);
+   CHECK (entries1->text == bt_atom_text (BTA_BOOK));
+   CHECK (entries1->down->atom == BTA_NONE);           /* the key */
+   CHECK (entries1->down->right->atom == BTA_TITLE);
+   CHECK (bt_intern ("TITLE", &id) == entries2->down->right->text);
+   CHECK (id == BTA_TITLE);
+   CHECK (strcmp (bt_atom_text (BTA_YEAR), "year") == 0);
+   CHECK (bt_atom_text (-1) == NULL);
+
+   entry1 = entries1->right;                           /* @string */
+   entry2 = entries2->right;
+   CHECK (entry1->atom == BTA_STRING);
+   CHECK (entry1->down->atom >= BTA_NUM_PREDEFINED);   /* "macro" */
+   CHECK (entry1->down->text == entry2->down->text);
+   CHECK (entry1->right->atom == BTA_COMMENT);
+   CHECK (entry1->right->right->atom == BTA_PREAMBLE);
+
+   bt_free_ast (entries1);
+   bt_free_ast (entries2);
+   bt_arena_free (arena);
+   return ok;
+}
+
+
+/*
+ * A huge value must come through whole, with only a few notices about
+ * the lexical buffer growing -- and none at all the second time, when
+ * the buffer has been kept from the first.
+ */
+static boolean
+test_huge_value (void)
+{
+   AST *   entry;
+   boolean status;
+   char *  buf;
+   int     len;
+   int     notes;
+   int     pass;
+   boolean ok = TRUE;
+
+   buf = (char *) malloc (NUM_HUGE + 64);
+   len = sprintf (buf, "@misc{huge, note = {");
+   memset (buf + len, 'x', NUM_HUGE);
+   strcpy (buf + len + NUM_HUGE, "}}");
+   bt_keep_lex_buffer (TRUE);
+   for (pass = 0; pass < 2; pass++)
+   {
+      notes = bt_get_error_count (BTERR_NOTIFY);
+      entry = bt_parse_entry_s (buf, NULL, 1, 0, &status);
+      bt_parse_entry_s (NULL, NULL, 1, 0, NULL);
+      notes = bt_get_error_count (BTERR_NOTIFY) - notes;
+      CHECK (status);
+      CHECK (strlen (bt_get_value (entry->down->right)) == NUM_HUGE);
+      CHECK (notes == (pass == 0 ? 3 : 0));
+      bt_free_ast (entry);
+   }
+   bt_keep_lex_buffer (FALSE);
+
+   free (buf);
+
+   /*
+    * Several huge entries in one go, each bigger than the last (so
+    * the buffer overflows again for each), still only get three.
+    */
+   buf = (char *) malloc (2 * NUM_HUGE + 256);
+   len = 0;
+   for (pass = 3; pass >= 0; pass--)
+   {
+      len += sprintf (buf + len, "@misc{huge%d, note = {", pass);
+      memset (buf + len, 'x', NUM_HUGE >> (2 * pass));
+      len += NUM_HUGE >> (2 * pass);
+      len += sprintf (buf + len, "}}\n");
+   }
+   notes = bt_get_error_count (BTERR_NOTIFY);
+   bt_free_ast (bt_parse_buffer (buf, len, NULL, 0, &status));
+   notes = bt_get_error_count (BTERR_NOTIFY) - notes;
+   CHECK (status && notes == 3);
+   free (buf);
+   return ok;
+}
+
+
+/*
+ * Entries with many more fields than fit in the parser's first stack
+ * chunk (about 97) must parse, more than once (so the stacks can grow
+ * again after being freed), and when two of them come in a row.
+ */
+static boolean
+test_many_fields (void)
+{
+   AST *   entry;
+   boolean status;
+   char *  buf;
+   int     len;
+   int     i;
+   int     pass;
+   AST *   entries;
+   AST *   field;
+   char *  name;
+   boolean ok = TRUE;
+
+   buf = (char *) malloc (2 * (NUM_FIELDS * 32 + 64));
+   len = sprintf (buf, "@misc{many");
+   for (i = 0; i < NUM_FIELDS; i++)
+      len += sprintf (buf + len, ",\n  f%d = {v%d} # \"w\"", i, i);
+   len += sprintf (buf + len, "}\n");
+
+   for (pass = 0; pass < 2; pass++)
+   {
+      entry = bt_parse_entry_s (buf, NULL, 1, 0, &status);
+      CHECK (status);
+      field = NULL;
+      for (i = 0; (field = bt_next_field (entry, field, &name)); i++)
+         ;
+      CHECK (i == NUM_FIELDS);
+      CHECK (strcmp (bt_get_value (bt_next_field (entry, NULL, &name)),
+                     "v0w") == 0);
+      bt_free_ast (entry);
+   }
+   bt_parse_entry_s (NULL, NULL, 1, 0, NULL);
+
+   memcpy (buf + len, buf, len);        /* two of them in a row */
+   entries = bt_parse_buffer (buf, 2 * len, NULL, 0, &status);
+   CHECK (status && entries != NULL && entries->right != NULL);
+   bt_free_ast (entries);
+   free (buf);
+   return ok;
+}
+
+
+/*
+ * String bodies are copied in bulk by the scanner, many characters at
+ * a time; runs of every length up to a few vectors, ending in every
+ * sort of special character (and with tabs, backslashes, and 8-bit
+ * characters in them) must come through the same from a string, a
+ * buffer, or a file.
+ */
+static boolean
+test_string_runs (void)
+{
+   AST *   entry;
+   boolean status;
+   static char * pieces[] =
+      { "{\\'e}", "\t", "(x)", "\xe9\\", "\n", "{\"}", "\r{}" };
+   char    value[NUM_RUNS * (NUM_RUNS + 8)];
+   char    expect[sizeof (value)];
+   char    buf[sizeof (value) + 64];
+   int     len;
+   int     i, j;
+   FILE *  tmp;
+   boolean ok = TRUE;
+
+   value[0] = expect[0] = (char) 0;
+   for (i = 1; i <= NUM_RUNS; i++)
+   {
+      len = strlen (value);
+      for (j = 0; j < i; j++)
+         value[len + j] = 'a' + j % 26;
+      strcpy (value + len + i, pieces[i % 7]);
+   }
+   for (i = 0; value[i]; i++)           /* tabs in a run stay as they are */
+      expect[i] = (value[i] == '\n') ? ' ' : value[i];
+   expect[i] = (char) 0;
+   len = sprintf (buf, "@misc{runs, note = {%s}}\n", value);
+
+   entry = bt_parse_entry_s (buf, NULL, 1, 0, &status);
+   bt_parse_entry_s (NULL, NULL, 1, 0, NULL);
+   CHECK (status && strcmp (bt_get_value (entry->down->right), expect) == 0);
+   bt_free_ast (entry);
+
+   entry = bt_parse_buffer (buf, len, NULL, 0, &status);
+   CHECK (status && strcmp (bt_get_value (entry->down->right), expect) == 0);
+   bt_free_ast (entry);
+
+   tmp = tmpfile ();
+   fputs (buf, tmp);
+   rewind (tmp);
+   entry = bt_parse_entry (tmp, NULL, 0, &status);
+   CHECK (status && strcmp (bt_get_value (entry->down->right), expect) == 0);
+   bt_free_ast (entry);
+   bt_parse_entry (tmp, NULL, 0, NULL);
+   fclose (tmp);
+   return ok;
+}
+
+
+/*
+ * A batch of entries, none of them null-terminated, must parse just as
+ * they would one at a time -- bad ones included.
+ */
+static boolean
+test_batch (void)
+{
+   AST *        entry;
+   boolean      status;
+   const char * rows = "@misc{one, title = {One}}"
+                       "@book{two, title = \"Two\" # { and a half}}"
+                       "@misc{three, title = {Three} year = 1999}"
+                       "@string{four = {4}}";
+   const char * texts[5];
+   size_t       lens[5];
+   AST *        entries[5];
+   boolean      statuses[5];
+   char         row[64];
+   int          i;
+   boolean      ok = TRUE;
+
+   texts[0] = rows;
+   for (i = 0; i < 4; i++)
+   {
+      lens[i] = strchr (texts[i] + 1, '@') ?
+         (size_t) (strchr (texts[i] + 1, '@') - texts[i]) : strlen (texts[i]);
+      texts[i+1] = texts[i] + lens[i];
+   }
+   lens[4] = 0;                         /* and an empty one */
+
+   CHECK (bt_parse_entries_s (texts, lens, 5, NULL, 1, 0,
+                              entries, statuses) == 3);
+   CHECK (! statuses[2] && ! statuses[4]);
+   CHECK (strcmp (bt_get_value (entries[1]->down->right),
+                  "Two and a half") == 0);
+   for (i = 0; i < 5; i++)
+   {
+      memcpy (row, texts[i], lens[i]);
+      row[lens[i]] = (char) 0;
+      entry = bt_parse_entry_s (row, NULL, 1, 0, &status);
+      CHECK (statuses[i] == status);
+      CHECK (entries[i] == NULL ? entry == NULL
+             : entry != NULL && same_forest (entries[i], entry));
+   }
+   bt_parse_entry_s (NULL, NULL, 1, 0, NULL);
+   CHECK (bt_parse_entries_s (NULL, NULL, 0, NULL, 1, 0, NULL, NULL) == 0);
+   return ok;
+}
+
+
+/*
+ * Errors queued on a parser must be kept (up to the limit) with their
+ * locations, and counted just as if they'd been printed.
+ */
+static boolean
+test_queued_errors (void)
+{
+   bt_parser * parser1;
+   AST *       entry;
+   boolean     status;
+   char        buf[NUM_WARN * 64];
+   size_t      len;
+   int         i;
+   int         warnings;
+   int         num_errors;
+   int         num_dropped;
+   bt_error *  errors;
+   boolean     ok = TRUE;
+
+   len = 0;
+   for (i = 0; i < NUM_WARN; i++)
+      len += sprintf (buf + len, "@misc{w%d, title = {\"%d}}\n", i, i);
+   len += sprintf (buf + len, "@misc{bad title = {x}}\n");
+
+   warnings = bt_get_error_count (BTERR_LEXWARN);
+   parser1 = bt_parser_new_buffer (buf, len, "queued");
+   bt_parser_queue_errors (parser1, 10);
+   for (i = 0; (entry = bt_parser_parse_entry (parser1, 0, &status)); i++)
+   {
+      CHECK (status == (i < NUM_WARN));
+      bt_free_ast (entry);
+   }
+   CHECK (bt_get_error_count (BTERR_LEXWARN) - warnings == NUM_WARN);
+
+   errors = bt_parser_errors (parser1, &num_errors, &num_dropped);
+   CHECK (num_errors >= 11 && num_dropped == NUM_WARN - 10);
+   CHECK (errors[0].class == BTERR_LEXWARN && errors[0].line == 1);
+   CHECK (errors[0].offset == 19);      /* at the quote */
+   CHECK (strcmp (errors[0].filename, "queued") == 0);
+   CHECK (errors[9].line == 10);
+   CHECK (errors[10].class == BTERR_SYNTAX
+          && errors[10].line == NUM_WARN + 1);
+
+   bt_parser_clear_errors (parser1);
+   bt_parser_errors (parser1, &num_errors, &num_dropped);
+   CHECK (num_errors == 0 && num_dropped == 0);
+   bt_parser_free (parser1);
+   return ok;
+}
+
+
+/*
+ * The counters should see what was parsed -- if they're kept at all;
+ * if not, they must all read zero.
+ */
+static boolean
+test_stats (void)
+{
+   AST *     entry;
+   boolean   status;
+   bt_stats  stats;
+   boolean   ok = TRUE;
+
+   bt_reset_stats ();
+   entry = bt_parse_entry_s ("@string{mac = {m}}", NULL, 1, 0, &status);
+   bt_free_ast (entry);
+   entry = bt_parse_entry_s ("@misc{key, title = mac # \"x\" # nomac}",
+                             NULL, 1, 0, &status);
+   bt_free_ast (entry);
+   entry = bt_parse_entry_s (NULL, NULL, 1, 0, NULL);
+   if (bt_get_stats (&stats))
+   {
+      CHECK (stats.entries[BTE_MACRODEF] == 1);
+      CHECK (stats.entries[BTE_REGULAR] == 1);
+      CHECK (stats.bytes_lexed > 0 && stats.tokens > 0);
+      CHECK (stats.macro_lookups >= 2 && stats.macro_hits >= 1);
+      CHECK (stats.macro_hits < stats.macro_lookups);
+      CHECK (stats.strings_pasted == 1);
+      CHECK (stats.ast_nodes > 0);
+   }
+   else
+   {
+      CHECK (stats.tokens == 0 && stats.entries[BTE_REGULAR] == 0);
+   }
+   bt_reset_stats ();
+   bt_get_stats (&stats);
+   CHECK (stats.tokens == 0 && stats.macro_lookups == 0);
+   return ok;
+}
+
+
+/* Fields that weren't selected mustn't make it into the AST. */
+static boolean
+test_select_fields (char *filename, char *expect)
+{
+   boolean status;
+   char    got[SIG_SIZE];
+   char *  wanted[] = { "Year", "title", NULL };
+   AST *   entry;
+   bt_stats stats;
+   boolean ok = TRUE;
+
+   bt_select_fields (wanted);
+   forest_signature (bt_parse_file (filename, 0, &status), got);
+   bt_select_fields (NULL);
+   CHECK (status);
+   CHECK (strncmp (got, "1 book abook: title=A Book year=1922\n"
+                   "4 string (none): macro=macro text ", 70) == 0);
+   CHECK (strcmp (strchr (got, '\n'), strchr (expect, '\n')) == 0);
+
+   /* a dropped field's value doesn't even get nodes (if we can tell) */
+   bt_reset_stats ();
+   bt_select_fields (wanted);
+   entry = bt_parse_entry_s ("@misc{k, note = {a} # {b} # mac}", NULL, 1, 0,
+                             &status);
+   bt_select_fields (NULL);
+   CHECK (status && entry != NULL && entry->down->right == NULL);
+   if (bt_get_stats (&stats))
+      CHECK (stats.ast_nodes == 3);     /* entry, key, and field name */
+   bt_free_ast (entry);
+   bt_parse_entry_s (NULL, NULL, 1, 0, NULL);
+   bt_reset_stats ();
+   return ok;
+}
+
+
+/*
+ * A skip-scan must get past a broken entry to the next one -- including
+ * one with a NUL in a name, which isn't part of the name.
+ */
+static boolean
+test_skip_scan (void)
+{
+   boolean      status;
+   const char * text = "@misc{a,}\n@misc{b, x = {oops}\n@misc(c, y=1)";
+   static const char nul_text[] = "@misc{k\0x, y = 1}\n@misc{d, y = 2}\n";
+   bt_entry_span span;
+   boolean      ok = TRUE;
+
+   CHECK (bt_scan_buffer (text, strlen (text), last_span, &span, &status)
+          == 2);
+   CHECK (!status);
+   CHECK (span.line == 3 && span.offset == 30 && span.length == 13);
+   CHECK (span.key_len == 1 && span.key == text + 36);
+
+   CHECK (bt_scan_buffer (nul_text, sizeof (nul_text) - 1, last_span, &span,
+                          &status) == 1);
+   CHECK (!status && span.key == nul_text + 24);
+   return ok;
+}
+
+
+/*
+ * An entry fetched through an index must be just as if the whole file
+ * had been parsed, macros and all; and the index must go stale when
+ * the file changes.
+ */
+static boolean
+test_index (void)
+{
+   AST *        entry;
+   AST *        entry1;
+   AST *        entry2;
+   boolean      status1;
+   boolean      status2;
+   char         got1[SIG_SIZE];
+   char         got2[SIG_SIZE];
+   const char * idx_bib = "index_test.bib";
+   const char * idx_file = "index_test.idx";
+   FILE *       out;
+   bt_index *   index;
+   AST *        entries;
+   boolean      ok = TRUE;
+
+   out = fopen (idx_bib, "w");
+   fputs ("@string{pub = {Foo Press}}\n"
+          "@book{First, title = {One}, publisher = pub}\n"
+          "junk @comment{nothing}\n"
+          "@book(second, title = \"Two\" # { and } # pub)\n"
+          "@book{first, title = {Duplicate}}\n", out);
+   fclose (out);
+
+   entries = bt_parse_file ((char *) idx_bib, 0, &status1);
+   bt_delete_all_macros ();
+   CHECK (bt_index_build ((char *) idx_bib, (char *) idx_file));
+   CHECK ((index = bt_index_open ((char *) idx_bib, (char *) idx_file)));
+
+   entry1 = entries->right->right->right;      /* "second" */
+   entry2 = bt_index_lookup (index, "SECOND", 0, &status2);
+   CHECK (status2 && entry2 != NULL);
+   if (entry2 != NULL)
+   {
+      got1[0] = got2[0] = (char) 0;
+      add_signature (got1, entry1);
+      add_signature (got2, entry2);
+      CHECK (strcmp (got1, got2) == 0);
+      CHECK (strstr (got2, "title=Two and Foo Press") != NULL);
+      CHECK (entry1->line == entry2->line &&
+             entry1->offset == entry2->offset);
+   }
+   bt_free_ast (entry2);
+
+   entry1 = entries->right;                    /* "First" */
+   entry2 = bt_index_lookup (index, "first", 0, &status2);
+   CHECK (entry2 != NULL);
+   if (entry2 != NULL)
+   {
+      got1[0] = got2[0] = (char) 0;
+      add_signature (got1, entry1);
+      add_signature (got2, entry2);
+      CHECK (strcmp (got1, got2) == 0);
+   }
+   bt_free_ast (entry2);
+   CHECK (bt_index_lookup (index, "third", 0, &status2) == NULL);
+   bt_index_close (index);
+
+   out = fopen (idx_bib, "a");
+   fputs ("@book{third, title = {Three}}\n", out);
+   fclose (out);
+   CHECK (bt_index_open ((char *) idx_bib, (char *) idx_file) == NULL);
+   CHECK (bt_index_build ((char *) idx_bib, (char *) idx_file));
+   CHECK ((index = bt_index_open ((char *) idx_bib, (char *) idx_file)));
+   entry = bt_index_lookup (index, "third", 0, &status2);
+   CHECK (entry != NULL && entry->line == 6);
+   bt_free_ast (entry);
+   bt_index_close (index);
+
+   /* a record pointing past the end of the file means it's damaged */
+   out = fopen (idx_file, "r+b");
+   fseek (out, 48, SEEK_SET);           /* first record, after the header */
+   fputs ("\377\377\377\377\377\377\377\177", out);
+   fclose (out);
+   CHECK (bt_index_open ((char *) idx_bib, (char *) idx_file) == NULL);
+
+   bt_free_ast (entries);
+   remove (idx_bib);
+   remove (idx_file);
+   return ok;
+}
+
+
+/*
+ * A forest loaded from a cache must be the same as the one saved,
+ * and bring its macros back with it; a cache that's stale or damaged
+ * must be ignored.
+ */
+static boolean
+test_cache (void)
+{
+   boolean      status1;
+   boolean      status2;
+   const char * cache_bib = "cache_test.bib";
+   const char * cache_file = "cache_test.btc";
+   FILE *       out;
+   AST *        entries;
+   AST *        loaded;
+   bt_arena *   arena;
+   char *       name;
+   char *       text;
+   char         buf[8192];
+   size_t       len;
+   char *       title_only[] = { "title", NULL };
+   AST          node;
+   size_t       j;
+   int          i;
+   boolean      ok = TRUE;
+
+   out = fopen (cache_bib, "w");
+   fputs ("@string{pub = {Foo Press}}\n"
+          "@book{First, title = {One}, publisher = pub}\n"
+          "@preamble{\"Some \" # pub}\n"
+          "@book(second, title = \"Two\" # { and } # pub, year = 1999)\n",
+          out);
+   fclose (out);
+
+   bt_delete_all_macros ();             /* left by the index lookups */
+   entries = bt_parse_file ((char *) cache_bib, 0, &status1);
+   CHECK (bt_forest_save (entries, (char *) cache_file));
+   bt_delete_all_macros ();
+   loaded = bt_forest_load ((char *) cache_file, &arena);
+   CHECK (loaded != NULL && loaded->arena == arena);
+   CHECK (loaded != NULL && loaded->right->down->right->atom == BTA_TITLE);
+   text = bt_macro_text ("pub", NULL, 0);
+   CHECK (text != NULL && strcmp (text, "Foo Press") == 0);
+   CHECK (same_forest (entries, loaded));
+   bt_arena_free (arena);
+
+   /* first a miss, which writes the cache, then a hit */
+   remove (cache_file);
+   bt_delete_all_macros ();
+   entries = bt_parse_file ((char *) cache_bib, 0, &status1);
+   bt_delete_all_macros ();
+   loaded = bt_parse_file_cached ((char *) cache_bib, (char *) cache_file,
+                                  0, &status2, &arena);
+   CHECK (status2 && same_forest (entries, loaded));
+   bt_arena_free (arena);
+   bt_delete_all_macros ();
+   entries = bt_parse_file ((char *) cache_bib, 0, &status1);
+   bt_delete_all_macros ();
+   loaded = bt_parse_file_cached ((char *) cache_bib, (char *) cache_file,
+                                  0, &status2, &arena);
+   CHECK (status2 && bt_macro_text ("pub", NULL, 0) != NULL);
+   CHECK (same_forest (entries, loaded));
+   bt_arena_free (arena);
+
+   /* so does selecting fields (and unselecting them again) */
+   for (i = 0; i < 2; i++)
+   {
+      bt_select_fields (i == 0 ? title_only : NULL);
+      bt_delete_all_macros ();
+      entries = bt_parse_file ((char *) cache_bib, 0, &status1);
+      CHECK (i > 0 || entries->right->down->right->right == NULL);
+      bt_delete_all_macros ();
+      loaded = bt_parse_file_cached ((char *) cache_bib,
+                                     (char *) cache_file,
+                                     0, &status2, &arena);
+      CHECK (same_forest (entries, loaded));
+      bt_arena_free (arena);
+   }
+
+   /* a changed file makes the cache stale */
+   out = fopen (cache_bib, "a");
+   fputs ("@book{third, title = {Three}}\n", out);
+   fclose (out);
+   bt_delete_all_macros ();
+   entries = bt_parse_file ((char *) cache_bib, 0, &status1);
+   bt_delete_all_macros ();
+   loaded = bt_parse_file_cached ((char *) cache_bib, (char *) cache_file,
+                                  0, &status2, &arena);
+   CHECK (same_forest (entries, loaded));
+   bt_arena_free (arena);
+
+   /* and a truncated cache won't load */
+   out = fopen (cache_file, "rb");
+   len = fread (buf, 1, sizeof (buf), out);
+   fclose (out);
+   out = fopen (cache_file, "wb");
+   fwrite (buf, 1, len - 1, out);
+   fclose (out);
+   CHECK (bt_forest_load ((char *) cache_file, &arena) == NULL);
+
+   /* nor will one with a bad node type, or an atom with no name */
+   for (i = 0; i < 2; i++)
+   {
+      entries = bt_parse_entry_s ("@book{k, title = {T}}", NULL, 4242, 0,
+                                  &status1);
+      CHECK (bt_forest_save (entries, (char *) cache_file));
+      bt_free_ast (entries);
+      bt_parse_entry_s (NULL, NULL, 1, 0, NULL);
+      out = fopen (cache_file, "rb");
+      len = fread (buf, 1, sizeof (buf), out);
+      fclose (out);
+      for (j = 0; j + sizeof (AST) <= len; j += sizeof (void *))
+      {
+         memcpy (&node, buf + j, sizeof (AST));
+         if (node.line == 4242 &&
+             node.nodetype == (i == 0 ? BTAST_ENTRY : BTAST_FIELD))
+         {
+            if (i == 0)
+               node.nodetype = (bt_nodetype) 99;
+            else
+               node.text = NULL;
+            memcpy (buf + j, &node, sizeof (AST));
+            break;
+         }
+      }
+      CHECK (j + sizeof (AST) <= len);
+      out = fopen (cache_file, "wb");
+      fwrite (buf, 1, len, out);
+      fclose (out);
+      CHECK (bt_forest_load ((char *) cache_file, &arena) == NULL);
+   }
+
+   /*
+    * macros defined beforehand make a difference, but aren't saved with
+    * the file's own
+    */
+   out = fopen (cache_bib, "w");
+   fputs ("@string{pub = {Foo Press}}\n"
+          "@book{k, month = jan}\n", out);
+   fclose (out);
+   for (i = 0; i < 2; i++)
+   {
+      bt_delete_all_macros ();
+      bt_add_macro_text ("jan", i == 0 ? "Janvier" : "January", NULL, 0);
+      bt_add_macro_text ("other", "Other", NULL, 0);
+      loaded = bt_parse_file_cached ((char *) cache_bib,
+                                     (char *) cache_file,
+                                     0, &status2, &arena);
+      CHECK (loaded != NULL && status2);
+      text = loaded ? bt_get_value (bt_next_field (loaded->right, NULL,
+                                                   &name)) : NULL;
+      CHECK (text != NULL && strcmp (text, i == 0 ? "Janvier" : "January") == 0);
+      bt_arena_free (arena);
+   }
+   bt_delete_all_macros ();
+   loaded = bt_forest_load ((char *) cache_file, &arena);
+   CHECK (loaded != NULL);
+   CHECK (bt_macro_length ("pub") > 0 && bt_macro_length ("other") == 0);
+   bt_arena_free (arena);
+
+   bt_delete_all_macros ();
+   remove (cache_bib);
+   remove (cache_file);
+   return ok;
+}
+
+
+/*
+ * Entries written out as BibTeX must parse back the same, however
+ * they're laid out; and with the source text to hand, the writer
+ * copies unchanged entries from it as they were.
+ */
+static boolean
+test_writer (void)
+{
+   boolean      status1;
+   boolean      status2;
+   const char * text =
+      "@string{pub = {Foo Press}}\n"
+      "@Book{First,\n   Title={One \"two\"},publisher=pub # { Inc.},\n"
+      "  year = 1999}\n"
+      "@preamble{\"Some \" # pub}\n"
+      "@comment{anything {at} all}\n";
+   char *       order[] = { "YEAR", "publisher", NULL };
+   char *       title_only[] = { "title", NULL };
+   bt_writer *  writer;
+   AST *        entries;
+   char *       out;
+   char         sig1[SIG_SIZE],
+                sig2[SIG_SIZE];
+   boolean      ok = TRUE;
+
+   bt_delete_all_macros ();
+   forest_signature (bt_parse_buffer (text, strlen (text), NULL, 0,
+                                      &status1), sig1);
+
+   bt_delete_all_macros ();
+   entries = bt_parse_buffer (text, strlen (text), NULL, 0, &status1);
+   writer = bt_writer_new (NULL);
+   bt_write_forest (entries, writer);
+   out = bt_writer_text (writer, NULL);
+   bt_delete_all_macros ();
+   forest_signature (bt_parse_buffer (out, strlen (out), NULL, 0,
+                                      &status2), sig2);
+   CHECK (status2 && strcmp (sig1, sig2) == 0);
+   bt_writer_free (writer);
+
+   writer = bt_writer_new (NULL);
+   bt_writer_set_quote (writer, '"');
+   bt_writer_set_indent (writer, 4);
+   bt_writer_set_order (writer, order);
+   bt_write_forest (entries, writer);
+   out = bt_writer_text (writer, NULL);
+   CHECK (strcmp (out,
+                  "@string{pub = \"Foo Press\"}\n\n"
+                  "@book{First,\n"
+                  "    year = \"1999\",\n"
+                  "    publisher = \"Foo Press Inc.\",\n"
+                  "    title = {One \"two\"}\n"
+                  "}\n\n"
+                  "@preamble{\"Some \" # pub}\n\n"
+                  "@comment{anything {at} all}\n") == 0);
+   bt_writer_free (writer);
+
+   writer = bt_writer_new (NULL);
+   bt_writer_set_source (writer, text, strlen (text));
+   bt_set_text (entries->right->down->right->down, "Changed");
+   bt_write_forest (entries, writer);
+   out = bt_writer_text (writer, NULL);
+   CHECK (strcmp (out,
+                  "@string{pub = {Foo Press}}\n\n"
+                  "@book{First,\n"
+                  "  title = {Changed},\n"
+                  "  publisher = {Foo Press Inc.},\n"
+                  "  year = {1999}\n"
+                  "}\n\n"
+                  "@preamble{\"Some \" # pub}\n\n"
+                  "@comment{anything {at} all}\n") == 0);
+   bt_writer_free (writer);
+   bt_free_ast (entries);
+   bt_delete_all_macros ();
+
+   /* A comment in an entry mustn't end it early, brace or no brace. */
+   text = "@article{k1,\n title = {A},\n% stray } brace\n year = 1999\n}\n"
+          "@misc{k2, note = {B}}\n";
+   forest_signature (bt_parse_buffer (text, strlen (text), NULL, 0,
+                                      &status1), sig1);
+   entries = bt_parse_buffer (text, strlen (text), NULL, 0, &status1);
+   writer = bt_writer_new (NULL);
+   bt_writer_set_source (writer, text, strlen (text));
+   bt_write_forest (entries, writer);
+   out = bt_writer_text (writer, NULL);
+   CHECK (strstr (out, "year = 1999\n}\n") != NULL);
+   forest_signature (bt_parse_buffer (out, strlen (out), NULL, 0,
+                                      &status2), sig2);
+   CHECK (status1 && status2 && strcmp (sig1, sig2) == 0);
+   bt_writer_free (writer);
+   bt_free_ast (entries);
+
+   /*
+    * Nor may the source text bring back fields that were dropped, or
+    * paper over errors in an entry.
+    */
+   text = "@article{k, abstract = {huge}, title = {T}, year = 1}\n";
+   bt_select_fields (title_only);
+   entries = bt_parse_buffer (text, strlen (text), NULL, 0, &status1);
+   bt_select_fields (NULL);
+   writer = bt_writer_new (NULL);
+   bt_writer_set_source (writer, text, strlen (text));
+   bt_write_forest (entries, writer);
+   out = bt_writer_text (writer, NULL);
+   CHECK (status1 && strcmp (out, "@article{k,\n  title = {T}\n}\n") == 0);
+   bt_writer_free (writer);
+   bt_free_ast (entries);
+   entries = bt_parse_entry_s ("@article{k, title = {T} year = 1}",
+                               NULL, 1, 0, &status1);
+   CHECK (!status1 && entries != NULL && entries->changed);
+   bt_free_ast (entries);
+   bt_parse_entry_s (NULL, NULL, 1, 0, NULL);
+   return ok;
+}
+
+
+/*
+ * A list of entries long enough that freeing it recursively would
+ * blow the stack.
+ */
+static boolean
+test_long_list (void)
+{
+   AST *   entry;
+   boolean status;
+   char *  buf;
+   size_t  len;
+   int     i;
+   AST *   entries;
+   boolean ok = TRUE;
+
+   buf = (char *) malloc (NUM_LONG * 16);
+   len = 0;
+   for (i = 0; i < NUM_LONG; i++)
+      len += sprintf (buf + len, "@misc{k%d,}\n", i);
+   entries = bt_parse_buffer (buf, len, NULL, 0, &status);
+   CHECK (status);
+   i = 0;
+   entry = NULL;
+   while ((entry = bt_next_entry (entries, entry)))
+      i++;
+   CHECK (i == NUM_LONG);
+   bt_free_ast (entries);
+   free (buf);
+   return ok;
+}
+
+
+/* A key map must find every entry, whatever the case of its key. */
+static boolean
+test_keymap (void)
+{
+   AST *       entry;
+   boolean     status;
+   char *      buf;
+   size_t      len;
+   int         i;
+   AST *       entries;
+   bt_keymap * map;
+   AST **      dups;
+   char *      keys[3];
+   AST *       found[3];
+   boolean     ok = TRUE;
+
+   buf = (char *) malloc (NUM_PARALLEL * 32);
+   len = 0;
+   for (i = 0; i < NUM_PARALLEL; i++)
+      len += sprintf (buf + len, "@misc{Key%d, note = %d}\n", i, i);
+   len += sprintf (buf + len, "@string{key1 = 1}\n@misc{KEY7, note=0}\n");
+   entries = bt_parse_buffer (buf, len, NULL, 0, &status);
+   free (buf);
+
+   map = bt_forest_index (entries);     /* warns about KEY7 */
+   CHECK (bt_keymap_duplicates (map, &dups) == 1);
+   CHECK (strcmp (bt_entry_key (dups[0]), "KEY7") == 0);
+   for (entry = entries, i = 0; i < 7; i++)
+      entry = entry->right;
+   CHECK (bt_keymap_find (map, "key7") == entry);
+   keys[0] = "KEY12345";
+   keys[1] = "nokey";
+   keys[2] = "key0";
+   CHECK (bt_keymap_find_keys (map, keys, 3, found) == 2);
+   CHECK (found[0] && strcmp (bt_entry_key (found[0]), "Key12345") == 0);
+   CHECK (found[1] == NULL && found[2] == entries);
+   bt_keymap_free (map);
+   bt_free_ast (entries);
+   return ok;
+}
+
+
+/*
+ * Entries for the same work must end up in the same cluster, however
+ * their titles and names are spelt -- and whether or not the
+ * fingerprints are made in parallel.
+ */
+static boolean
+test_duplicates (void)
+{
+   AST *       entry;
+   boolean     status;
+   const char * dups =
+      "@string{yr = \"2001\"}\n"
+      "@article{d1, title = {The {\\\"O}ber-Test},\n"
+      "  author = {M{\\\"u}ller, Hans and Doe, J.}, year = 2001}\n"
+      "@book{d2, author = \"Hans M{\\\"u}ller\",\n"
+      "  title = \"THE  {\\\"O}ber  test\", year = yr}\n"
+      "@misc{d3, title = {The Ober Test}, author = {H. Muller}, year=2002}\n"
+      "@misc{d4, title = {Something Else}, editor = {Jones, Ann},\n"
+      "  year = 1999}\n"
+      "@misc{d5, title = \"Something \" # \"else\", author = {Ann Jones},\n"
+      "  year = 1999}\n"
+      "@misc{d6, author = {Nobody}}\n";
+   char *      buf;
+   size_t      len;
+   int         i;
+   AST *       entries;
+   AST **      cluster;
+   char *      fp;
+   bt_dupmap * map;
+   boolean     ok = TRUE;
+
+   buf = (char *) malloc (NUM_PARALLEL * 80 + strlen (dups));
+   len = 0;
+   for (i = 0; i < NUM_PARALLEL; i++)
+      len += sprintf (buf + len,
+                      "@misc{k%d, title = {Title %d},\n"
+                      "  author = {A. Author}, year = %d}\n",
+                      i, i, 1900 + i % 100);
+   len += sprintf (buf + len, "%s", dups);
+   bt_delete_all_macros ();
+   entries = bt_parse_buffer (buf, len, NULL, 0, &status);
+   free (buf);
+   CHECK (status);
+
+   for (i = 1; i <= NUM_THREADS; i += NUM_THREADS - 1)
+   {
+      map = bt_find_duplicates (entries, i);
+      CHECK (bt_dupmap_clusters (map) == 2);
+      CHECK (bt_dupmap_cluster (map, 0, &cluster, &fp) == 2);
+      CHECK (strcmp (fp, "the ober test/muller/2001") == 0);
+      CHECK (strcmp (bt_entry_key (cluster[0]), "d1") == 0 &&
+             strcmp (bt_entry_key (cluster[1]), "d2") == 0);
+      CHECK (bt_dupmap_cluster (map, 1, &cluster, &fp) == 2);
+      CHECK (strcmp (fp, "something else/jones/1999") == 0);
+      CHECK (strcmp (bt_entry_key (cluster[0]), "d4") == 0 &&
+             strcmp (bt_entry_key (cluster[1]), "d5") == 0);
+      CHECK (bt_dupmap_cluster (map, 2, &cluster, &fp) == 0);
+      bt_dupmap_free (map);
+   }
+
+   for (entry = entries; entry->right != NULL; entry = entry->right)
+      ;
+   CHECK (bt_entry_fingerprint (entry) == NULL);   /* no title */
+   fp = bt_entry_fingerprint (entries);
+   CHECK (fp != NULL && strcmp (fp, "title 0/author/1900") == 0);
+   free (fp);
+   bt_free_ast (entries);
+   bt_delete_all_macros ();
+   return ok;
+}
+
+
+/*
+ * Parsing a big buffer in parallel must give the same results as
+ * parsing it all in one go -- including macros, which must only be
+ * expanded in the entries after their definition.
+ */
+static boolean
+test_parallel (void)
+{
+   boolean    status1;
+   boolean    status2;
+   char *     buf;
+   size_t     len;
+   int        i;
+   AST *      expected;
+   bt_arena * arena;
+   boolean    ok = TRUE;
+
+   buf = (char *) malloc (NUM_PARALLEL * 128);
+   len = sprintf (buf, "@misc{early, note = {too early: } # m%d}\n",
+                  NUM_PARALLEL - 100);
+   for (i = 0; i < NUM_PARALLEL; i++)
+   {
+      if (i % 100 == 0)
+         len += sprintf (buf + len, "@string{m%d = {macro %d}}\n", i, i);
+      else if (i % 997 == 0)
+         len += sprintf (buf + len, "%% @misc{c%d}\n@comment(x{%d})\n",
+                         i, i);
+      else
+         len += sprintf (buf + len,
+                         "@article(a%d,\n  title = {T%d} # m%d,\n"
+                         "  year = \"%d\")\n",
+                         i, i, i - i % 100, 1900 + i % 100);
+   }
+
+   expected = bt_parse_buffer (buf, len, NULL, 0, &status1);
+   CHECK (status1);
+   bt_cleanup ();
+   bt_initialize ();
+   CHECK (same_forest (expected, bt_parse_buffer_parallel
+                       (buf, len, NULL, 0, &status2, NUM_THREADS)));
+   CHECK (status2);
+   CHECK (bt_macro_length ("m100") == 9);
+
+   /* A skip-scan of the same buffer must find all the same entries. */
+   {
+      scan_check  check;
+
+      check.buf = buf;
+      check.entries = bt_parse_buffer (buf, len, NULL, 0, &status1);
+      check.entry = NULL;
+      check.same = TRUE;
+      CHECK (bt_scan_buffer (buf, len, check_span, &check, &status2)
+             == NUM_PARALLEL + 1);
+      CHECK (status2 && check.same);
+      CHECK (bt_next_entry (check.entries, check.entry) == NULL);
+      bt_free_ast (check.entries);
+   }
+
+   bt_cleanup ();
+   bt_initialize ();
+   arena = bt_arena_new (0);
+   bt_set_arena (arena);
+   expected = bt_parse_buffer (buf, len, NULL, 0, &status1);
+   bt_cleanup ();
+   bt_initialize ();
+   CHECK (same_forest (expected, bt_parse_buffer_parallel
+                       (buf, len, NULL, 0, &status2, NUM_THREADS)));
+   bt_set_arena (NULL);
+   bt_arena_free (arena);
+
+   bt_cleanup ();
+   bt_initialize ();
+   expected = bt_parse_buffer (buf, len, NULL, 0, &status1);
+   bt_cleanup ();
+   bt_initialize ();
+   CHECK (same_forest (expected, bt_parse_buffer_parallel
+                       (buf, len, NULL, 0, &status2, 1)));
+   free (buf);
+   return ok;
+}
+
+
+/* Freeing a parser that's not done (or never used) must be OK too. */
+static boolean
+test_free_parser (char *filename)
+{
+   FILE *      file;
+   bt_parser * parser1;
+   bt_parser * parser2;
+   boolean     ok = TRUE;
+
+   file = open_file ("simple.bib", DATA_DIR, filename);
+   parser1 = bt_parser_new (file, filename);
+   parser2 = bt_parser_new (file, filename);
+   bt_free_ast (bt_parser_parse_entry (parser1, 0, NULL));
+   bt_parser_free (parser2);
+   bt_parser_free (parser1);
+   fclose (file);
+   return ok;
+}
+
+
+#if HAVE_PTHREAD_H && HAVE_LIBPTHREAD
+
+/*
+ * Parsing the same file in several threads at once must give the same
+ * results in each.
+ */
+static boolean
+test_threads (char *filename, char *expect)
+{
+   pthread_t  threads[NUM_THREADS];
+   char       sigs[NUM_THREADS][SIG_SIZE];
+   int        i;
+   boolean    ok = TRUE;
+
+   strcpy (SimpleFile, filename);
+   for (i = 0; i < NUM_THREADS; i++)
+   {
+      sigs[i][0] = (char) 0;
+      CHECK (pthread_create (&threads[i], NULL, thread_main, sigs[i]) == 0);
+   }
+   for (i = 0; i < NUM_THREADS; i++)
+   {
+      pthread_join (threads[i], NULL);
+      CHECK (strcmp (sigs[i], expect) == 0);
+   }
+   return ok;
+}
+
+#endif /* HAVE_PTHREAD_H && HAVE_LIBPTHREAD */
+
+
+int main (void)
+{
+   char       filename1[256],
+              filename2[256];
+   FILE *     file;
+   char       expect1[SIG_SIZE],
+              expect2[SIG_SIZE];
+   boolean    ok = TRUE;
+
+   bt_initialize ();
+
+   /* First get the expected results by parsing each file on its own. */
+   file = open_file ("simple.bib", DATA_DIR, filename1);
+   fclose (file);
+   file = open_file ("regular.bib", DATA_DIR, filename2);
+   fclose (file);
+   CHECK (file_signature (filename1, expect1));
+   CHECK (file_signature (filename2, expect2));
+
+   ok &= test_interleaved (filename1, expect1, filename2, expect2);
+   ok &= test_whole_file (filename2, expect2);
+   ok &= test_process_file (filename1, expect1);
+   ok &= test_lazy (filename1, expect1);
+   ok &= test_unexpanded_macro ();
+   ok &= test_compact (filename1);
+   ok &= test_atoms (filename1);
+   ok &= test_huge_value ();
+   ok &= test_many_fields ();
+   ok &= test_string_runs ();
+   ok &= test_batch ();
+   ok &= test_queued_errors ();
+   ok &= test_stats ();
+   ok &= test_select_fields (filename1, expect1);
+   ok &= test_skip_scan ();
+   ok &= test_index ();
+   ok &= test_cache ();
+   ok &= test_writer ();
+   ok &= test_long_list ();
+   ok &= test_keymap ();
+   ok &= test_duplicates ();
+   ok &= test_parallel ();
+   ok &= test_free_parser (filename1);
+#if HAVE_PTHREAD_H && HAVE_LIBPTHREAD
+   ok &= test_threads (filename1, expect1);
+#endif
+
+   bt_cleanup ();
+
+   if (! ok)
+   {
+      printf ("Some tests failed\n");
+      exit (1);
+   }
+   else
+   {
+      printf ("All tests successful\n");
+      exit (0);
+   }
+
+} /* main() */
@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+# progs_test.sh
+#
+# smoke tests for the programs in ../progs: bibgen must write a corpus
+# that bibparse reads without complaint, and bibparse -json must print
+# one object per entry, with quotes and backslashes escaped.
+#
+
+progs=../progs
+tmp=progs_test.$$
+trap 'rm -f $tmp.*' 0
+
+fail ()
+{
+   echo "failed check: $1"
+   echo "Some tests failed"
+   exit 1
+}
+
+$progs/bibgen -entries 50 > $tmp.bib || fail "bibgen runs"
+entries=`grep -c '^@' $tmp.bib`
+test "$entries" -gt 50 || fail "bibgen writes at least 50 entries"
+
+$progs/bibparse -json $tmp.bib > $tmp.json || fail "bibparse reads bibgen's corpus"
+test `wc -l < $tmp.json` -eq "$entries" || fail "one line of JSON per entry"
+grep -v '^{"metatype":"[a-z]*","type":"[a-z]*","key":.*,"fields":{.*}}$' \
+   $tmp.json > /dev/null && fail "every line is an entry object"
+
+cat > $tmp.in <<'EOF'
+@string{pub = {Foo Press}}
+@Book{K1, title = {Say {"}hi{"} \ there}, publisher = pub, year = 1999}
+EOF
+cat > $tmp.ok <<'EOF'
+{"metatype":"macrodef","type":"string","key":null,"fields":{"pub":"Foo Press"}}
+{"metatype":"regular","type":"book","key":"K1","fields":{"title":"Say {\"}hi{\"} \\ there","publisher":"Foo Press","year":"1999"}}
+EOF
+$progs/bibparse -json $tmp.in > $tmp.json || fail "bibparse -json runs"
+cmp -s $tmp.json $tmp.ok || fail "bibparse -json output"
+
+$progs/bibparse -json -dump $tmp.in > $tmp.json || fail "bibparse -json -dump runs"
+test "`sed -n 1p $tmp.json`" = "`sed -n 1p $tmp.ok`" || \
+   fail "bibparse -json -dump prints each entry before its AST"
+
+echo "All tests successful"
+exit 0
@@ -69,6 +69,8 @@ boolean goodtest_preamble (AST *entry, test_data *data);
 /* and prototypes to keep "gcc -Wall" from whining */
 boolean test_multiple (FILE *, char *, ushort, ushort, int, test *);
 boolean test_wholefile (char *, ushort, ushort, int, test *);
+boolean test_macro_table (int num_macros);
+boolean test_pasting (int num_pieces);
 
 
 /* a priori knowledge about the entry in "regular.bib" (used for both tests) */
@@ -538,6 +540,125 @@ boolean test_wholefile (char * filename,
 }
 
 
+/*
+ * Defines lots of macros (enough to make the macro table grow several
+ * times), then deletes every other one, and makes sure the right ones
+ * are left -- with the right text, and regardless of case.
+ */
+boolean test_macro_table (int num_macros)
+{
+   boolean ok = TRUE;
+   char    name[32],
+           text[32];
+   char *  value;
+   int     i;
+
+   printf ("big macro table: ");
+   for (i = 0; i < num_macros; i++)
+   {
+      sprintf (name, "Mac%d", i);
+      sprintf (text, "text of %d", i);
+      bt_add_macro_text (name, text, NULL, 0);
+   }
+   for (i = 0; i < num_macros; i += 2)
+   {
+      sprintf (name, "mac%d", i);
+      bt_delete_macro (name);
+   }
+   for (i = 0; i < num_macros; i++)
+   {
+      sprintf (name, "MAC%d", i);
+      sprintf (text, "text of %d", i);
+      if (i % 2 == 0)
+      {
+         CHECK_ESCAPE (bt_macro_length (name) == 0, break, "macro table");
+      }
+      else
+      {
+         value = bt_macro_text (name, NULL, 0);
+         CHECK_ESCAPE (value && strcmp (value, text) == 0,
+                       break, "macro table");
+      }
+   }
+
+   bt_add_macro_text ("mac1", "new text", NULL, 0);
+   value = bt_macro_text ("mac1", NULL, 0);
+   CHECK (value && strcmp (value, "new text") == 0);
+   bt_delete_all_macros ();
+   CHECK (bt_macro_length ("mac3") == 0);
+
+   printf ("%s\n", ok ? "ok" : "not ok");
+   return ok;
+}
+
+
+/*
+ * Pastes together a value with lots of pieces -- macros, strings, and
+ * numbers -- and checks the result.
+ */
+boolean test_pasting (int num_pieces)
+{
+   boolean ok = TRUE;
+   char *  entry_text;
+   char *  expect;
+   char *  text;
+   char *  name;
+   size_t  len,
+           expect_len;
+   int     i;
+   AST *   entry;
+
+   printf ("pasting %d pieces: ", num_pieces);
+   bt_add_macro_text ("jan", "January", NULL, 0);
+   bt_add_macro_text ("feb", "February", NULL, 0);
+
+   entry_text = (char *) malloc (num_pieces * 16 + 64);
+   expect = (char *) malloc (num_pieces * 16);
+   len = sprintf (entry_text, "@misc{paste, note = {start}");
+   expect_len = sprintf (expect, "start");
+   for (i = 0; i < num_pieces; i++)
+   {
+      switch (i % 4)
+      {
+         case 0:
+            len += sprintf (entry_text + len, " # jan");
+            expect_len += sprintf (expect + expect_len, "January");
+            break;
+         case 1:
+            len += sprintf (entry_text + len, " # {-%d-}", i);
+            expect_len += sprintf (expect + expect_len, "-%d-", i);
+            break;
+         case 2:
+            len += sprintf (entry_text + len, " # %d", i);
+            expect_len += sprintf (expect + expect_len, "%d", i);
+            break;
+         case 3:
+            len += sprintf (entry_text + len, " # FEB");
+            expect_len += sprintf (expect + expect_len, "February");
+            break;
+      }
+   }
+   strcpy (entry_text + len, "}");
+
+   set_all_stringopts (BTO_FULL);
+   entry = bt_parse_entry_s (entry_text, NULL, 1, 0, NULL);
+   CHECK (entry != NULL);
+   if (entry != NULL)
+   {
+      text = bt_get_text (bt_next_field (entry, NULL, &name));
+      CHECK (text && strcmp (text, expect) == 0);
+      free (text);
+      bt_free_ast (entry);
+   }
+   bt_parse_entry_s (NULL, NULL, 1, 0, NULL);
+
+   free (entry_text);
+   free (expect);
+   printf ("%s\n", ok ? "ok" : "not ok");
+   return ok;
+}
+
+
 int main (void)
 {
    unsigned i;
@@ -547,6 +668,7 @@ int main (void)
    ushort  options = 0;                 /* use default non-string options */
    boolean ok;
    int     num_failures = 0;
+   bt_arena * arena;
 
    bt_initialize ();
 
@@ -585,6 +707,20 @@ int main (void)
                          BTO_FULL, options, 4, tests+12))
       num_failures++;
 
+   /* same again, but with the whole forest in an arena */
+   arena = bt_arena_new (0);
+   bt_set_arena (arena);
+   if (! test_wholefile (DATA_DIR "/" "simple.bib",
+                         BTO_FULL, options, 4, tests+12))
+      num_failures++;
+   bt_set_arena (NULL);
+   bt_arena_free (arena);
+
+   if (! test_macro_table (50000))
+      num_failures++;
+   if (! test_pasting (300))
+      num_failures++;
+
    bt_cleanup ();
 
    if (num_failures == 0)